@@ -1,4 +1,5 @@
 #include "global.h"
+#include "param_snapshot.h"
 #include "Network.h"
 #include "Control.h"
 #include "Led.h"
@@ -90,17 +91,23 @@ int main(int argc, char *argv[]) {
     control->registerControlFunction(ID_VIDEO, OP_VIDEO_RELOAD_CONFIG, std::bind(&Video::reload_roi_config, video));
 #endif
 #if VIDEO_ENABLE && DISPLAY_ENABLE
-    video->signal_video_frame.connectWithRef(display, &Display::push_frame);
+    // 显示跟不上时只显示最新的一帧
+    video->signal_video_frame.connectWithRef(display, &Display::push_frame, DeliveryPolicy::CoalesceLatest);
+    // 显示不可用或暂停时不需要子码流分支帧
+    display->set_demand_callback([video](bool demand) {
+        video->set_frame_demand(Video::FrameConsumer::Display, demand);
+    });
 #endif
 #if VIDEO_ENABLE && PANTILT_ENABLE
-    video->signal_adjust_pantilt.connect(pantilt, &Pantilt::onAjustPantilt);
+    // 舵机调整较慢，只按最新的检测结果调整，避免积压的旧偏移量导致云台过冲
+    video->signal_adjust_pantilt.connect(pantilt, &Pantilt::onAjustPantilt, DeliveryPolicy::CoalesceLatest);
 #endif
 
 #if API_SERVER_ENABLE
     // 初始化 API 服务器
     LOG_DEBUG("API server initializing\n");
     // 读取 API 服务器的端口号（默认为 8080）
-    int api_port = rk_param_get_int("api:port", 8080);
+    int api_port = rk_param_snapshot()->get(param_key::api_port);
     ApiServer api_server(api_port);
     
 #if API_SERVER_ENABLE && VIDEO_ENABLE
@@ -109,6 +116,12 @@ int main(int argc, char *argv[]) {
     
     // 注册视频控制功能
     api_server.setControl(control);
+    
+    // 检测结果推送给事件订阅者
+    video->signal_detections.connectWithRef(&api_server, &ApiServer::onDetections, DeliveryPolicy::DropOldest, 8);
+    
+    // 设置视频预览图来源
+    api_server.setPreviewSource(video->get_preview_cache());
 #endif
 
 #if API_SERVER_ENABLE && LED_ENABLE
@@ -122,7 +135,7 @@ int main(int argc, char *argv[]) {
 #endif
     
     // 读取并设置 API 密钥（如果有的话）
-    std::string api_key = rk_param_get_string("api:key", "");
+    std::string api_key = rk_param_snapshot()->get(param_key::api_key);
     if (!api_key.empty()) {
         LOG_INFO("API authentication enabled\n");
         api_server.setApiKey(api_key);
@@ -166,6 +179,9 @@ int main(int argc, char *argv[]) {
         api_server.stop();
         LOG_DEBUG("API server stopped\n");
 #endif
+#if VIDEO_ENABLE && DISPLAY_ENABLE
+        display->set_demand_callback(nullptr);
+#endif
 #if VIDEO_ENABLE
         delete video;
         LOG_DEBUG("Video module deinitialized\n");
@@ -59,42 +59,154 @@ static char *xstrdup(const char *s) {
 
 /*-------------------------------------------------------------------------*/
 /**
-  @brief    Double the size of the dictionary
+  @brief    Index size for a given storage size
+  @param    size Storage size
+  @return   Smallest power of two holding size entries at a load factor <= 1/2
+ */
+/*--------------------------------------------------------------------------*/
+static size_t dictionary_nslots(ssize_t size) {
+	size_t nslots = 16;
+	while (nslots < (size_t)size * 2)
+		nslots <<= 1;
+	return nslots;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Find the storage position of a key
+  @param    d    Dictionary to search
+  @param    key  Key to look for
+  @param    hash Hash of the key
+  @return   Storage position, or -1 if the key is not in the dictionary
+ */
+/*--------------------------------------------------------------------------*/
+static ssize_t dictionary_find(const dictionary *d, const char *key, unsigned hash) {
+	size_t mask;
+	size_t i;
+	unsigned slot;
+
+	if (d->slots == NULL)
+		return -1;
+	mask = d->nslots - 1;
+	for (i = hash & mask; (slot = d->slots[i]) != 0; i = (i + 1) & mask) {
+		ssize_t pos = (ssize_t)slot - 1;
+		if (d->hash[pos] == hash && !strcmp(key, d->key[pos]))
+			return pos;
+	}
+	return -1;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Add a storage position to the hash index (linear probing)
+ */
+/*--------------------------------------------------------------------------*/
+static void dictionary_index_add(unsigned *slots, size_t nslots, unsigned hash, ssize_t pos) {
+	size_t mask = nslots - 1;
+	size_t i = hash & mask;
+
+	while (slots[i] != 0)
+		i = (i + 1) & mask;
+	slots[i] = (unsigned)(pos + 1);
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Remove a storage position from the hash index
+
+  Uses backward-shift deletion: the entries following the removed slot in
+  the same probe run are moved back, so no tombstones are needed and probe
+  sequences stay short after many deletions.
+ */
+/*--------------------------------------------------------------------------*/
+static void dictionary_index_remove(dictionary *d, ssize_t pos) {
+	size_t mask = d->nslots - 1;
+	size_t i = d->hash[pos] & mask;
+	size_t j;
+
+	while (d->slots[i] != (unsigned)(pos + 1))
+		i = (i + 1) & mask;
+
+	for (j = (i + 1) & mask; d->slots[j] != 0; j = (j + 1) & mask) {
+		size_t home = d->hash[d->slots[j] - 1] & mask;
+		/* Leave the entry alone if its home slot lies cyclically in (i, j] */
+		if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+			continue;
+		d->slots[i] = d->slots[j];
+		i = j;
+	}
+	d->slots[i] = 0;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Make room for a new entry
   @param    d Dictionary to grow
   @return   This function returns non-zero in case of failure
+
+  Called when the storage is full up to d->size. Holes left by deleted keys
+  are reclaimed first; the storage is only doubled when at least half of it
+  holds live entries. Either way the live entries are compacted in their
+  original order and the hash index is rebuilt.
  */
 /*--------------------------------------------------------------------------*/
 static int dictionary_grow(dictionary *d) {
-	char **new_val;
-	char **new_key;
-	unsigned *new_hash;
-
-	new_val = (char **)calloc(d->size * 2, sizeof *d->val);
-	new_key = (char **)calloc(d->size * 2, sizeof *d->key);
-	new_hash = (unsigned *)calloc(d->size * 2, sizeof *d->hash);
-	if (!new_val || !new_key || !new_hash) {
+	ssize_t new_size = (d->n >= d->size / 2) ? d->size * 2 : d->size;
+	size_t new_nslots = dictionary_nslots(new_size);
+	char **new_val = d->val;
+	char **new_key = d->key;
+	unsigned *new_hash = d->hash;
+	unsigned *new_slots;
+	ssize_t i, j;
+
+	new_slots = (unsigned *)calloc(new_nslots, sizeof *new_slots);
+	if (new_size != d->size) {
+		new_val = (char **)calloc(new_size, sizeof *d->val);
+		new_key = (char **)calloc(new_size, sizeof *d->key);
+		new_hash = (unsigned *)calloc(new_size, sizeof *d->hash);
+	}
+	if (!new_slots || !new_val || !new_key || !new_hash) {
 		/* An allocation failed, leave the dictionary unchanged */
-		if (new_val)
+		free(new_slots);
+		if (new_size != d->size) {
 			free(new_val);
-		if (new_key)
 			free(new_key);
-		if (new_hash)
 			free(new_hash);
+		}
 		return -1;
 	}
-	/* Initialize the newly allocated space */
-	memcpy(new_val, d->val, d->size * sizeof(char *));
-	memcpy(new_key, d->key, d->size * sizeof(char *));
-	memcpy(new_hash, d->hash, d->size * sizeof(unsigned));
-	/* Delete previous data */
-	free(d->val);
-	free(d->key);
-	free(d->hash);
-	/* Actually update the dictionary */
-	d->size *= 2;
+
+	/* Compact live entries, keeping their order */
+	for (i = 0, j = 0; i < d->end; i++) {
+		if (d->key[i] == NULL)
+			continue;
+		new_key[j] = d->key[i];
+		new_val[j] = d->val[i];
+		new_hash[j] = d->hash[i];
+		dictionary_index_add(new_slots, new_nslots, new_hash[j], j);
+		j++;
+	}
+	if (new_size != d->size) {
+		free(d->val);
+		free(d->key);
+		free(d->hash);
+	} else {
+		/* Clear the tail vacated by compaction */
+		for (i = j; i < d->end; i++) {
+			new_key[i] = NULL;
+			new_val[i] = NULL;
+			new_hash[i] = 0;
+		}
+	}
+	free(d->slots);
+
+	d->size = new_size;
 	d->val = new_val;
 	d->key = new_key;
 	d->hash = new_hash;
+	d->end = j;
+	d->slots = new_slots;
+	d->nslots = new_nslots;
 	return 0;
 }
 
@@ -158,6 +270,16 @@ dictionary *dictionary_new(size_t size) {
 		d->val = (char **)calloc(size, sizeof *d->val);
 		d->key = (char **)calloc(size, sizeof *d->key);
 		d->hash = (unsigned *)calloc(size, sizeof *d->hash);
+		d->nslots = dictionary_nslots(size);
+		d->slots = (unsigned *)calloc(d->nslots, sizeof *d->slots);
+		if (!d->val || !d->key || !d->hash || !d->slots) {
+			free(d->val);
+			free(d->key);
+			free(d->hash);
+			free(d->slots);
+			free(d);
+			d = NULL;
+		}
 	}
 	return d;
 }
@@ -176,7 +298,7 @@ void dictionary_del(dictionary *d) {
 
 	if (d == NULL)
 		return;
-	for (i = 0; i < d->size; i++) {
+	for (i = 0; i < d->end; i++) {
 		if (d->key[i] != NULL)
 			free(d->key[i]);
 		if (d->val[i] != NULL)
@@ -185,6 +307,7 @@ void dictionary_del(dictionary *d) {
 	free(d->val);
 	free(d->key);
 	free(d->hash);
+	free(d->slots);
 	free(d);
 	return;
 }
@@ -204,22 +327,12 @@ void dictionary_del(dictionary *d) {
  */
 /*--------------------------------------------------------------------------*/
 const char *dictionary_get(const dictionary *d, const char *key, const char *def) {
-	unsigned hash;
-	ssize_t i;
+	ssize_t pos;
 
-	hash = dictionary_hash(key);
-	for (i = 0; i < d->size; i++) {
-		if (d->key[i] == NULL)
-			continue;
-		/* Compare hash */
-		if (hash == d->hash[i]) {
-			/* Compare string, to avoid hash collisions */
-			if (!strcmp(key, d->key[i])) {
-				return d->val[i];
-			}
-		}
-	}
-	return def;
+	pos = dictionary_find(d, key, dictionary_hash(key));
+	if (pos < 0)
+		return def;
+	return d->val[pos];
 }
 
 /*-------------------------------------------------------------------------*/
@@ -249,7 +362,7 @@ const char *dictionary_get(const dictionary *d, const char *key, const char *def
  */
 /*--------------------------------------------------------------------------*/
 int dictionary_set(dictionary *d, const char *key, const char *val) {
-	ssize_t i;
+	ssize_t pos;
 	unsigned hash;
 
 	if (d == NULL || key == NULL)
@@ -258,41 +371,27 @@ int dictionary_set(dictionary *d, const char *key, const char *val) {
 	/* Compute hash for this key */
 	hash = dictionary_hash(key);
 	/* Find if value is already in dictionary */
-	if (d->n > 0) {
-		for (i = 0; i < d->size; i++) {
-			if (d->key[i] == NULL)
-				continue;
-			if (hash == d->hash[i]) {          /* Same hash value */
-				if (!strcmp(key, d->key[i])) { /* Same key */
-					/* Found a value: modify and return */
-					if (d->val[i] != NULL)
-						free(d->val[i]);
-					d->val[i] = (val ? xstrdup(val) : NULL);
-					/* Value has been modified: return */
-					return 0;
-				}
-			}
-		}
+	pos = dictionary_find(d, key, hash);
+	if (pos >= 0) {
+		/* Found a value: modify and return */
+		if (d->val[pos] != NULL)
+			free(d->val[pos]);
+		d->val[pos] = (val ? xstrdup(val) : NULL);
+		return 0;
 	}
 	/* Add a new value */
-	/* See if dictionary needs to grow */
-	if (d->n == d->size) {
-		/* Reached maximum size: reallocate dictionary */
+	/* See if the storage needs to be compacted or grown */
+	if (d->end == d->size) {
 		if (dictionary_grow(d) != 0)
 			return -1;
 	}
 
-	/* Insert key in the first empty slot. Start at d->n and wrap at
-	   d->size. Because d->n < d->size this will necessarily
-	   terminate. */
-	for (i = d->n; d->key[i];) {
-		if (++i == d->size)
-			i = 0;
-	}
-	/* Copy key */
-	d->key[i] = xstrdup(key);
-	d->val[i] = (val ? xstrdup(val) : NULL);
-	d->hash[i] = hash;
+	/* Append after the last entry so iteration follows insertion order */
+	pos = d->end++;
+	d->key[pos] = xstrdup(key);
+	d->val[pos] = (val ? xstrdup(val) : NULL);
+	d->hash[pos] = hash;
+	dictionary_index_add(d->slots, d->nslots, hash, pos);
 	d->n++;
 	return 0;
 }
@@ -309,38 +408,29 @@ int dictionary_set(dictionary *d, const char *key, const char *val) {
  */
 /*--------------------------------------------------------------------------*/
 void dictionary_unset(dictionary *d, const char *key) {
-	unsigned hash;
-	ssize_t i;
+	ssize_t pos;
 
 	if (key == NULL || d == NULL) {
 		return;
 	}
 
-	hash = dictionary_hash(key);
-	for (i = 0; i < d->size; i++) {
-		if (d->key[i] == NULL)
-			continue;
-		/* Compare hash */
-		if (hash == d->hash[i]) {
-			/* Compare string, to avoid hash collisions */
-			if (!strcmp(key, d->key[i])) {
-				/* Found key */
-				break;
-			}
-		}
-	}
-	if (i >= d->size)
+	pos = dictionary_find(d, key, dictionary_hash(key));
+	if (pos < 0)
 		/* Key not found */
 		return;
 
-	free(d->key[i]);
-	d->key[i] = NULL;
-	if (d->val[i] != NULL) {
-		free(d->val[i]);
-		d->val[i] = NULL;
+	dictionary_index_remove(d, pos);
+	free(d->key[pos]);
+	d->key[pos] = NULL;
+	if (d->val[pos] != NULL) {
+		free(d->val[pos]);
+		d->val[pos] = NULL;
 	}
-	d->hash[i] = 0;
+	d->hash[pos] = 0;
 	d->n--;
+	/* Trailing holes can be reused right away */
+	while (d->end > 0 && d->key[d->end - 1] == NULL)
+		d->end--;
 	return;
 }
 
@@ -365,7 +455,7 @@ void dictionary_dump(const dictionary *d, FILE *out) {
 		fprintf(out, "empty dictionary\n");
 		return;
 	}
-	for (i = 0; i < d->size; i++) {
+	for (i = 0; i < d->end; i++) {
 		if (d->key[i]) {
 			fprintf(out, "%20s\t[%s]\n", d->key[i], d->val[i] ? d->val[i] : "UNDEF");
 		}
@@ -36,9 +36,10 @@ extern "C" {
   @brief    Dictionary object
 
   This object contains a list of string/string associations. Each
-  association is identified by a unique string key. Looking up values
-  in the dictionary is speeded up by the use of a (hopefully collision-free)
-  hash function.
+  association is identified by a unique string key. Entries are kept in
+  insertion order in the key/val/hash arrays, so iterating over them (and
+  dumping an ini file) gives a stable order. Lookups go through a separate
+  open-addressing hash index and do not scan the entries.
  */
 /*-------------------------------------------------------------------------*/
 typedef struct _dictionary_ {
@@ -47,6 +48,9 @@ typedef struct _dictionary_ {
 	char **val;     /** List of string values */
 	char **key;     /** List of string keys */
 	unsigned *hash; /** List of hash values for keys */
+	ssize_t end;    /** Storage slots in use, holes included */
+	unsigned *slots; /** Open-addressing index: storage position + 1, 0 if empty */
+	size_t nslots;  /** Index size, a power of two */
 } dictionary;
 
 /*---------------------------------------------------------------------------
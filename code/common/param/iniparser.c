@@ -166,7 +166,7 @@ int iniparser_getnsec(const dictionary *d) {
 	if (d == NULL)
 		return -1;
 	nsec = 0;
-	for (i = 0; i < d->size; i++) {
+	for (i = 0; i < d->end; i++) {
 		if (d->key[i] == NULL)
 			continue;
 		if (strchr(d->key[i], ':') == NULL) {
@@ -197,7 +197,7 @@ const char *iniparser_getsecname(const dictionary *d, int n) {
 	if (d == NULL || n < 0)
 		return NULL;
 	foundsec = 0;
-	for (i = 0; i < d->size; i++) {
+	for (i = 0; i < d->end; i++) {
 		if (d->key[i] == NULL)
 			continue;
 		if (strchr(d->key[i], ':') == NULL) {
@@ -230,7 +230,7 @@ void iniparser_dump(const dictionary *d, FILE *f) {
 
 	if (d == NULL || f == NULL)
 		return;
-	for (i = 0; i < d->size; i++) {
+	for (i = 0; i < d->end; i++) {
 		if (d->key[i] == NULL)
 			continue;
 		if (d->val[i] != NULL) {
@@ -264,7 +264,7 @@ void iniparser_dump_ini(const dictionary *d, FILE *f) {
 	nsec = iniparser_getnsec(d);
 	if (nsec < 1) {
 		/* No section in file: dump all keys as they are */
-		for (i = 0; i < d->size; i++) {
+		for (i = 0; i < d->end; i++) {
 			if (d->key[i] == NULL)
 				continue;
 			fprintf(f, "%s = %s\n", d->key[i], d->val[i]);
@@ -304,11 +304,18 @@ void iniparser_dumpsection_ini(const dictionary *d, const char *s, FILE *f) {
 	seclen = (int)strlen(s);
 	fprintf(f, "\n[%s]\n", s);
 	sprintf(keym, "%s:", s);
-	for (j = 0; j < d->size; j++) {
+	for (j = 0; j < d->end; j++) {
 		if (d->key[j] == NULL)
 			continue;
 		if (!strncmp(d->key[j], keym, seclen + 1)) {
-			fprintf(f, "%-30s = %s\n", d->key[j] + seclen + 1, d->val[j] ? d->val[j] : "");
+			const char *val = d->val[j] ? d->val[j] : "";
+			/* Quote values containing comment characters so they survive a reload */
+			if (strpbrk(val, ";#") != NULL && strchr(val, '"') == NULL)
+				fprintf(f, "%-30s = \"%s\"\n", d->key[j] + seclen + 1, val);
+			else if (strpbrk(val, ";#") != NULL && strchr(val, '\'') == NULL)
+				fprintf(f, "%-30s = '%s'\n", d->key[j] + seclen + 1, val);
+			else
+				fprintf(f, "%-30s = %s\n", d->key[j] + seclen + 1, val);
 		}
 	}
 	fprintf(f, "\n");
@@ -339,7 +346,7 @@ int iniparser_getsecnkeys(const dictionary *d, const char *s) {
 	strlwc(s, keym, sizeof(keym));
 	keym[seclen] = ':';
 
-	for (j = 0; j < d->size; j++) {
+	for (j = 0; j < d->end; j++) {
 		if (d->key[j] == NULL)
 			continue;
 		if (!strncmp(d->key[j], keym, seclen + 1))
@@ -380,7 +387,7 @@ const char **iniparser_getseckeys(const dictionary *d, const char *s, const char
 
 	i = 0;
 
-	for (j = 0; j < d->size; j++) {
+	for (j = 0; j < d->end; j++) {
 		if (d->key[j] == NULL)
 			continue;
 		if (!strncmp(d->key[j], keym, seclen + 1)) {
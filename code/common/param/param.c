@@ -38,22 +38,216 @@ int rk_param_dump() {
 	return 0;
 }
 
+// 延迟保存的等待时间：最后一次修改后等待的时间，以及首次修改后最长等待的时间
+#define PARAM_SAVE_DELAY_MS 1000
+#define PARAM_SAVE_MAX_DELAY_MS 5000
+
+static pthread_mutex_t g_save_file_mutex = PTHREAD_MUTEX_INITIALIZER; // 串行化文件写入
+static pthread_mutex_t g_save_mutex = PTHREAD_MUTEX_INITIALIZER;      // 保护延迟保存的状态
+static pthread_cond_t g_save_cond;
+static pthread_once_t g_save_once = PTHREAD_ONCE_INIT;
+static pthread_t g_save_thread;
+static int g_save_thread_running = 0;
+static int g_save_quit = 0;
+static int g_save_pending = 0;
+static struct timespec g_save_first;    // 本轮第一次请求保存的时间
+static struct timespec g_save_deadline; // 本轮计划写入的时间
+
+static void timespec_add_ms(struct timespec *ts, int ms) {
+	ts->tv_sec += ms / 1000;
+	ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+	if (ts->tv_nsec >= 1000000000L) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000L;
+	}
+}
+
+static int timespec_before(const struct timespec *a, const struct timespec *b) {
+	return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+static int write_all(int fd, const char *buf, size_t len) {
+	while (len > 0) {
+		ssize_t n = write(fd, buf, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+
+// 将当前参数写入配置文件
+// 先在参数锁内导出到内存，写 flash 时不阻塞参数读写；
+// 写入临时文件并 fsync 后再 rename 覆盖，掉电时配置文件要么是旧的要么是新的
+static int param_write_file() {
+	char *buf = NULL;
+	size_t len = 0;
+	char tmp_path[sizeof(g_ini_path_) + 8];
+	char dir_path[sizeof(g_ini_path_)];
+	int ret = -1;
+	int fd;
+
+	pthread_mutex_lock(&g_save_file_mutex);
+
+	pthread_mutex_lock(&g_param_mutex);
+	if (g_ini_d_ == NULL) {
+		pthread_mutex_unlock(&g_param_mutex);
+		goto out;
+	}
+	FILE *mem = open_memstream(&buf, &len);
+	if (mem) {
+		iniparser_dump_ini(g_ini_d_, mem);
+		fclose(mem);
+	}
+	pthread_mutex_unlock(&g_param_mutex);
+	if (mem == NULL || buf == NULL) {
+		LOG_ERROR("dump ini to memory failed!\n");
+		goto out;
+	}
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", g_ini_path_);
+	fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		LOG_ERROR("%s, open error: %s\n", tmp_path, strerror(errno));
+		goto out;
+	}
+	if (write_all(fd, buf, len) != 0 || fsync(fd) != 0) {
+		LOG_ERROR("%s, write error: %s\n", tmp_path, strerror(errno));
+		close(fd);
+		unlink(tmp_path);
+		goto out;
+	}
+	close(fd);
+
+	if (rename(tmp_path, g_ini_path_) != 0) {
+		LOG_ERROR("rename %s to %s error: %s\n", tmp_path, g_ini_path_, strerror(errno));
+		unlink(tmp_path);
+		goto out;
+	}
+
+	// 同步目录项，保证 rename 本身落盘
+	snprintf(dir_path, sizeof(dir_path), "%s", g_ini_path_);
+	char *slash = strrchr(dir_path, '/');
+	if (slash == dir_path)
+		slash[1] = '\0';
+	else if (slash)
+		*slash = '\0';
+	else
+		snprintf(dir_path, sizeof(dir_path), ".");
+	fd = open(dir_path, O_RDONLY | O_DIRECTORY);
+	if (fd >= 0) {
+		fsync(fd);
+		close(fd);
+	}
+
+	LOG_DEBUG("%s saved, %zu bytes\n", g_ini_path_, len);
+	ret = 0;
+
+out:
+	pthread_mutex_unlock(&g_save_file_mutex);
+	free(buf);
+	return ret;
+}
+
 int rk_param_save() {
-	FILE *fp = fopen(g_ini_path_, "w");
-	if (fp == NULL) {
-		LOG_ERROR("%s, fopen error!\n", g_ini_path_);
-		iniparser_freedict(g_ini_d_);
-		g_ini_d_ = NULL;
-		return -1;
+	// 立即保存时取消尚未执行的延迟保存
+	pthread_mutex_lock(&g_save_mutex);
+	g_save_pending = 0;
+	pthread_mutex_unlock(&g_save_mutex);
+
+	return param_write_file();
+}
+
+static void param_save_cond_init() {
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&g_save_cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+static void *param_save_thread(void *arg) {
+	struct timespec now;
+
+	(void)arg;
+	prctl(PR_SET_NAME, "param_save", 0, 0, 0);
+	pthread_mutex_lock(&g_save_mutex);
+	while (!g_save_quit) {
+		if (!g_save_pending) {
+			pthread_cond_wait(&g_save_cond, &g_save_mutex);
+			continue;
+		}
+		// 等待期间有新的修改会推迟 deadline，醒来后重新检查
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (timespec_before(&now, &g_save_deadline)) {
+			pthread_cond_timedwait(&g_save_cond, &g_save_mutex, &g_save_deadline);
+			continue;
+		}
+		g_save_pending = 0;
+		pthread_mutex_unlock(&g_save_mutex);
+		param_write_file();
+		pthread_mutex_lock(&g_save_mutex);
 	}
-	iniparser_dump_ini(g_ini_d_, fp);
+	pthread_mutex_unlock(&g_save_mutex);
 
-	fflush(fp);
-	fclose(fp);
+	return NULL;
+}
+
+int rk_param_save_deferred() {
+	struct timespec now, latest;
+
+	pthread_once(&g_save_once, param_save_cond_init);
+	pthread_mutex_lock(&g_save_mutex);
+	if (!g_save_thread_running) {
+		g_save_quit = 0;
+		if (pthread_create(&g_save_thread, NULL, param_save_thread, NULL) != 0) {
+			pthread_mutex_unlock(&g_save_mutex);
+			LOG_ERROR("create param save thread failed, save now\n");
+			return rk_param_save();
+		}
+		g_save_thread_running = 1;
+	}
+
+	// 每次请求都把写入时间推迟到 PARAM_SAVE_DELAY_MS 之后，
+	// 但不超过本轮首次请求后的 PARAM_SAVE_MAX_DELAY_MS，避免持续修改时一直不落盘
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (!g_save_pending)
+		g_save_first = now;
+	g_save_deadline = now;
+	timespec_add_ms(&g_save_deadline, PARAM_SAVE_DELAY_MS);
+	latest = g_save_first;
+	timespec_add_ms(&latest, PARAM_SAVE_MAX_DELAY_MS);
+	if (timespec_before(&latest, &g_save_deadline))
+		g_save_deadline = latest;
+	g_save_pending = 1;
+	pthread_cond_signal(&g_save_cond);
+	pthread_mutex_unlock(&g_save_mutex);
 
 	return 0;
 }
 
+// 停止延迟保存线程，未写入的修改由调用者随后保存
+static void param_save_thread_stop() {
+	pthread_mutex_lock(&g_save_mutex);
+	if (!g_save_thread_running) {
+		pthread_mutex_unlock(&g_save_mutex);
+		return;
+	}
+	g_save_quit = 1;
+	pthread_cond_signal(&g_save_cond);
+	pthread_mutex_unlock(&g_save_mutex);
+
+	pthread_join(g_save_thread, NULL);
+
+	pthread_mutex_lock(&g_save_mutex);
+	g_save_thread_running = 0;
+	pthread_mutex_unlock(&g_save_mutex);
+}
+
 int rk_param_get_int(const char *entry, int default_val) {
 	int ret;
 	pthread_mutex_lock(&g_param_mutex);
@@ -64,11 +258,12 @@ int rk_param_get_int(const char *entry, int default_val) {
 }
 
 int rk_param_set_int(const char *entry, int val) {
-	char tmp[8];
-	sprintf(tmp, "%d", val);
+	char tmp[16];
+	snprintf(tmp, sizeof(tmp), "%d", val);
 	pthread_mutex_lock(&g_param_mutex);
 	iniparser_set(g_ini_d_, entry, tmp);
 	pthread_mutex_unlock(&g_param_mutex);
+	rk_param_publish();
 
 	return 0;
 }
@@ -86,10 +281,150 @@ int rk_param_set_string(const char *entry, const char *val) {
 	pthread_mutex_lock(&g_param_mutex);
 	iniparser_set(g_ini_d_, entry, val);
 	pthread_mutex_unlock(&g_param_mutex);
+	rk_param_publish();
 
 	return 0;
 }
 
+// 检查参数名是否为合法的 "section:key"，不能含有会破坏 ini 格式的字符
+static int param_entry_valid(const char *entry) {
+	const char *colon;
+	size_t len;
+
+	if (entry == NULL)
+		return 0;
+	len = strlen(entry);
+	colon = strchr(entry, ':');
+	if (len == 0 || len > 1024 || colon == NULL || colon == entry || colon[1] == '\0')
+		return 0;
+	for (const char *p = entry; *p; p++) {
+		if ((unsigned char)*p < 0x20 || strchr("[]=;#", *p))
+			return 0;
+	}
+	return 1;
+}
+
+// 检查参数值，换行等控制字符会破坏 ini 的行结构；';' 和 '#' 保存时加引号，不受限制
+static int param_value_valid(const char *value) {
+	if (value == NULL || strlen(value) > 1024)
+		return 0;
+	for (const char *p = value; *p; p++) {
+		if ((unsigned char)*p < 0x20 && *p != '\t')
+			return 0;
+	}
+	return 1;
+}
+
+// 取出 "section:key" 中的 section 部分，entry 已经过校验
+static void param_section_of(const char *entry, char *section) {
+	size_t len = strchr(entry, ':') - entry;
+	memcpy(section, entry, len);
+	section[len] = '\0';
+}
+
+// 批量更新参数：先校验全部条目，再在同一次加锁内写入，
+// 任何一项失败都回滚已写入的条目，读者不会看到只更新了一半的配置。
+// 参数不合法返回 -EINVAL，其他错误返回 -1
+int rk_param_set_batch(const rk_param_kv_t *kvs, int count, int save_mode) {
+	static const char param_missing[] = "";
+	char section[1025];
+	char last_section[1025] = "";
+	char **old_values;
+	unsigned char *flags; // bit0: 原来存在该条目，bit1: 新建了 section
+	int failed = -1;
+	int i;
+
+	if (count < 0 || (count > 0 && kvs == NULL))
+		return -EINVAL;
+	for (i = 0; i < count; i++) {
+		if (!param_entry_valid(kvs[i].entry) || !param_value_valid(kvs[i].value)) {
+			LOG_ERROR("invalid param %s\n", kvs[i].entry ? kvs[i].entry : "(null)");
+			return -EINVAL;
+		}
+		if (rk_param_check_value(kvs[i].entry, kvs[i].value) != 0)
+			return -EINVAL;
+	}
+	if (count == 0)
+		return 0;
+
+	old_values = (char **)calloc(count, sizeof(char *));
+	flags = (unsigned char *)calloc(count, 1);
+	if (old_values == NULL || flags == NULL) {
+		free(old_values);
+		free(flags);
+		return -1;
+	}
+
+	pthread_mutex_lock(&g_param_mutex);
+	if (g_ini_d_ == NULL) {
+		pthread_mutex_unlock(&g_param_mutex);
+		free(old_values);
+		free(flags);
+		return -1;
+	}
+
+	for (i = 0; i < count; i++) {
+		const char *entry = kvs[i].entry;
+		const char *old = iniparser_getstring(g_ini_d_, entry, param_missing);
+
+		if (old != param_missing) {
+			flags[i] |= 1;
+			old_values[i] = old ? strdup(old) : NULL;
+		}
+
+		// iniparser 只导出已存在 section 下的条目，新 section 需要先创建
+		// 同一批次中的连续条目通常属于同一个 section，只检查一次
+		if (strncmp(entry, last_section, strlen(last_section)) != 0 ||
+		    entry[strlen(last_section)] != ':') {
+			param_section_of(entry, section);
+			if (!iniparser_find_entry(g_ini_d_, section)) {
+				if (iniparser_set(g_ini_d_, section, NULL) != 0) {
+					failed = i;
+					break;
+				}
+				flags[i] |= 2;
+			}
+			strcpy(last_section, section);
+		}
+
+		if (iniparser_set(g_ini_d_, entry, kvs[i].value) != 0) {
+			failed = i;
+			break;
+		}
+	}
+
+	if (failed >= 0) {
+		// 倒序恢复，同一个条目出现多次时最终回到最初的值
+		LOG_ERROR("set param %s failed, rollback\n", kvs[failed].entry);
+		for (i = failed; i >= 0; i--) {
+			if (flags[i] & 1)
+				iniparser_set(g_ini_d_, kvs[i].entry, old_values[i]);
+			else
+				iniparser_unset(g_ini_d_, kvs[i].entry);
+			if (flags[i] & 2) {
+				param_section_of(kvs[i].entry, section);
+				iniparser_unset(g_ini_d_, section);
+			}
+		}
+	}
+	pthread_mutex_unlock(&g_param_mutex);
+
+	for (i = 0; i < count; i++)
+		free(old_values[i]);
+	free(old_values);
+	free(flags);
+
+	if (failed >= 0)
+		return -1;
+
+	rk_param_publish();
+	if (save_mode == RK_PARAM_SAVE_NOW)
+		return rk_param_save();
+	if (save_mode == RK_PARAM_SAVE_DEFERRED)
+		return rk_param_save_deferred();
+	return 0;
+}
+
 int rk_param_init(char *ini_path) {
 	LOG_DEBUG("%s\n", __func__);
 	char cmd[256];
@@ -116,6 +451,7 @@ int rk_param_init(char *ini_path) {
 	}
 	rk_param_dump();
 	pthread_mutex_unlock(&g_param_mutex);
+	rk_param_publish();
 
 	return 0;
 }
@@ -124,10 +460,12 @@ int rk_param_deinit() {
 	LOG_INFO("%s\n", __func__);
 	if (g_ini_d_ == NULL)
 		return 0;
-	pthread_mutex_lock(&g_param_mutex);
+	param_save_thread_stop();
 	rk_param_save();
+	pthread_mutex_lock(&g_param_mutex);
 	if (g_ini_d_)
 		iniparser_freedict(g_ini_d_);
+	g_ini_d_ = NULL;
 	pthread_mutex_unlock(&g_param_mutex);
 
 	return 0;
@@ -146,6 +484,7 @@ int rk_param_reload() {
 	}
 	rk_param_dump();
 	pthread_mutex_unlock(&g_param_mutex);
+	rk_param_publish();
 
 	return 0;
 }
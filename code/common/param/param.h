@@ -1,6 +1,9 @@
 // Copyright 2021 Rockchip Electronics Co., Ltd. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
+#ifndef PARAM_H
+#define PARAM_H
+
 #include "iniparser.h"
 
 #ifdef __cplusplus
@@ -14,16 +17,37 @@ extern "C" {
 
 extern dictionary *g_ini_d_;
 
+// 批量更新的一项，entry 格式为 "section:key"
+typedef struct {
+	const char *entry;
+	const char *value;
+} rk_param_kv_t;
+
+// 批量更新后的保存方式
+enum {
+	RK_PARAM_NO_SAVE = 0,    // 只更新内存
+	RK_PARAM_SAVE_NOW,       // 立即写入文件
+	RK_PARAM_SAVE_DEFERRED,  // 延迟写入，短时间内的多次修改合并为一次
+};
+
 int rk_param_get_int(const char *entry, int default_val);
 int rk_param_set_int(const char *entry, int val);
 const char *rk_param_get_string(const char *entry, const char *default_val);
 int rk_param_set_string(const char *entry, const char *val);
 float rk_param_get_float(const char *entry, float default_val);
 int rk_param_save();
+int rk_param_save_deferred();
+int rk_param_set_batch(const rk_param_kv_t *kvs, int count, int save_mode);
 int rk_param_init(char *ini_path);
 int rk_param_deinit();
 int rk_param_reload();
 
+// 按参数表检查值的类型和取值范围，不在参数表中的参数总是通过；不合法时返回 -1
+int rk_param_check_value(const char *entry, const char *value);
+
+// 参数修改后发布新的只读快照并通知订阅者（见 param_snapshot.h），由参数模块内部调用
+void rk_param_publish();
+
 #ifdef __cplusplus
 }
 
@@ -32,4 +56,9 @@ std::vector<std::pair<std::string, std::string>> rk_param_get_section(const char
 
 // 添加C++接口，返回所有参数
 std::vector<std::pair<std::string, std::string>> rk_param_get_all();
+
+// 添加C++接口，批量更新参数
+int rk_param_set_batch(const std::vector<std::pair<std::string, std::string>>& updates, int save_mode);
 #endif
+
+#endif // PARAM_H
@@ -89,4 +89,19 @@ std::vector<std::pair<std::string, std::string>> rk_param_get_all() {
     
     pthread_mutex_unlock(&g_param_mutex);
     return result;
-}
\ No newline at end of file
+}
+
+/**
+ * 批量更新参数
+ * @param updates 参数名与参数值的列表
+ * @param save_mode 保存方式，RK_PARAM_NO_SAVE / RK_PARAM_SAVE_NOW / RK_PARAM_SAVE_DEFERRED
+ * @return 0 成功，-EINVAL 参数不合法，-1 其他错误
+ */
+int rk_param_set_batch(const std::vector<std::pair<std::string, std::string>>& updates, int save_mode) {
+    std::vector<rk_param_kv_t> kvs;
+    kvs.reserve(updates.size());
+    for (const auto& update : updates) {
+        kvs.push_back({update.first.c_str(), update.second.c_str()});
+    }
+    return rk_param_set_batch(kvs.data(), (int)kvs.size(), save_mode);
+}
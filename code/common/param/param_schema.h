@@ -0,0 +1,211 @@
+#ifndef PARAM_SCHEMA_H
+#define PARAM_SCHEMA_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 参数表：集中定义常用参数的类型、默认值和取值范围
+//
+// 每个参数在编译期分配一个槽位，生成快照时按表解析并校验一次，
+// 之后通过 ParamSnapshot::get(param_key::xxx) 直接按下标取值，不再查找和解析字符串。
+// 配置文件中的值类型不对或超出范围时记录错误并使用默认值，不做截断。
+//
+// 新增参数时在下表中添加一行：
+//   INT(名称, "section:key", 默认值, 最小值, 最大值)
+//   FLOAT(名称, "section:key", 默认值, 最小值, 最大值)
+//   BOOL(名称, "section:key", 默认值)
+//   STRING(名称, "section:key", 默认值)
+#define RK_PARAM_SCHEMA(INT, FLOAT, BOOL, STRING) \
+    /* 主码流 / 子码流 */ \
+    INT(video0_width, "video.0:width", 2304, 64, 4096) \
+    INT(video0_height, "video.0:height", 1296, 64, 4096) \
+    INT(video0_max_rate, "video.0:max_rate", 4096, 64, 65536) \
+    INT(video0_fps, "video.0:dst_frame_rate_num", 25, 1, 60) \
+    INT(video0_gop, "video.0:gop", 10, 1, 65536) \
+    INT(video1_width, "video.1:width", 704, 64, 1920) \
+    INT(video1_height, "video.1:height", 576, 64, 1920) \
+    INT(video1_preview_fps, "video.1:preview_fps", 10, 1, 30) \
+    INT(video1_preview_quality, "video.1:preview_quality", 70, 1, 99) \
+    BOOL(video1_preview_jpeg_hw, "video.1:preview_jpeg_hw", true) \
+    BOOL(video1_venc_bind, "video.1:venc_bind", true) \
+    INT(video1_branch_fps, "video.1:branch_fps", 10, 1, 30) \
+    INT(video1_max_rate, "video.1:max_rate", 1024, 64, 65536) \
+    INT(video1_fps, "video.1:dst_frame_rate_num", 30, 1, 60) \
+    INT(video1_gop, "video.1:gop", 10, 1, 65536) \
+    /* RTSP 自适应码率 */ \
+    BOOL(video_rc_enable, "video.rate_control:enable", true) \
+    INT(video_rc_min_percent, "video.rate_control:min_percent", 25, 5, 100) \
+    INT(video_rc_backlog_ms, "video.rate_control:backlog_ms", 300, 50, 5000) \
+    INT(video_rc_recover_s, "video.rate_control:recover_s", 10, 1, 600) \
+    /* 主码流空闲档 */ \
+    BOOL(video_idle_enable, "video.idle:enable", false) \
+    INT(video_idle_fps, "video.idle:fps", 5, 1, 60) \
+    INT(video_idle_gop_s, "video.idle:gop_s", 10, 1, 60) \
+    INT(video_idle_rate_percent, "video.idle:rate_percent", 25, 5, 100) \
+    INT(video_idle_hold_s, "video.idle:hold_s", 30, 1, 3600) \
+    /* 主码流检测 ROI 编码 */ \
+    BOOL(video_roi_qp_enable, "video.roi_qp:enable", false) \
+    INT(video_roi_qp_subject, "video.roi_qp:subject_qp", -6, -51, 0) \
+    INT(video_roi_qp_background, "video.roi_qp:background_qp", 3, 0, 51) \
+    INT(video_roi_qp_update_frames, "video.roi_qp:update_frames", 5, 1, 100) \
+    INT(video_roi_qp_margin, "video.roi_qp:margin", 32, 0, 512) \
+    INT(video_roi_qp_hold_frames, "video.roi_qp:hold_frames", 10, 0, 300) \
+    /* AI */ \
+    BOOL(ai_enable, "ai:enable", false) \
+    BOOL(ai_input_substream, "ai:input_substream", false) \
+    STRING(ai_model_path, "ai.model:path", "./model/yolov5.rknn") \
+    STRING(ai_model_label, "ai.model:label", "./model/coco_80_labels_list.txt") \
+    BOOL(ai_od_enable, "ai.od:enable", false) \
+    INT(ai_od_line_pixel, "ai.od:line_pixel", 2, 1, 16) \
+    BOOL(ai_od_predict, "ai.od:predict", true) \
+    INT(ai_od_latency_ms, "ai.od:latency_ms", 0, 0, 1000) \
+    FLOAT(ai_od_predict_min_score, "ai.od:predict_min_score", 0.5f, 0.0f, 1.0f) \
+    BOOL(ai_od_people_detect, "ai.od:people_detect", false) \
+    BOOL(ai_od_vehicle_detect, "ai.od:vehicle_detect", false) \
+    BOOL(ai_od_pet_detect, "ai.od:pet_detect", false) \
+    BOOL(ai_privacy_enable, "ai.privacy:enable", false) \
+    STRING(ai_privacy_style, "ai.privacy:style", "mosaic") \
+    INT(ai_privacy_max_masks, "ai.privacy:max_masks", 4, 1, 8) \
+    INT(ai_privacy_margin, "ai.privacy:margin", 16, 0, 256) \
+    INT(ai_privacy_hold_ms, "ai.privacy:hold_ms", 500, 0, 5000) \
+    BOOL(ai_privacy_head_only, "ai.privacy:head_only", false) \
+    BOOL(ai_follow_enable, "ai.follow:enable", false) \
+    BOOL(ai_follow_people, "ai.follow:people_follow", false) \
+    BOOL(ai_follow_vehicle, "ai.follow:vehicle_follow", false) \
+    BOOL(ai_follow_pet, "ai.follow:pet_follow", false) \
+    INT(ai_follow_tolerance_width, "ai.follow:tolerance_width", 100, 0, 4096) \
+    INT(ai_follow_tolerance_height, "ai.follow:tolerance_height", 100, 0, 4096) \
+    INT(ai_follow_roi_x, "ai.follow:roi_x", 0, 0, 4096) \
+    INT(ai_follow_roi_y, "ai.follow:roi_y", 0, 0, 4096) \
+    INT(ai_follow_roi_width, "ai.follow:roi_width", 2304, 0, 4096) \
+    INT(ai_follow_roi_height, "ai.follow:roi_height", 1296, 0, 4096) \
+    BOOL(ai_roi_enable, "ai.roi:enable", false) \
+    INT(ai_roi_count, "ai.roi:count", 0, 0, 256) \
+    INT(ai_roi_groups, "ai.roi:groups", 0, 0, 256) \
+    FLOAT(ai_roi_detection_threshold, "ai.roi:detection_threshold", 0.4f, 0.0f, 1.0f) \
+    /* 告警推送 */ \
+    STRING(alarm_server_url, "alarm:server_url", "http://localhost:8080") \
+    STRING(alarm_auth_token, "alarm:auth_token", "") \
+    /* 云台，范围与舵机行程一致 */ \
+    INT(ptz_preset_pan, "ptz:preset_pan", 0, -90, 90) \
+    INT(ptz_preset_tilt, "ptz:preset_tilt", 0, -60, 90) \
+    BOOL(ptz_preset_home_enable, "ptz:preset_home_enable", false) \
+    INT(ptz_preset_home_time, "ptz:preset_home_time", 30, 0, 86400) \
+    /* HTTP API */ \
+    INT(api_port, "api:port", 8080, 1, 65535) \
+    STRING(api_key, "api:key", "") \
+    INT(api_alarm_history_size, "api:alarm_history_size", 100, 1, 10000) \
+    INT(api_sse_queue_size, "api:sse_queue_size", 64, 1, 4096) \
+    INT(api_sse_max_clients, "api:sse_max_clients", 4, 0, 64) \
+    INT(api_mjpeg_max_clients, "api:mjpeg_max_clients", 2, 0, 16) \
+    STRING(api_snapshot_dir, "api:snapshot_dir", "/userdata/snapshots") \
+    INT(api_snapshot_max_kb, "api:snapshot_max_kb", 8192, 0, 1048576) \
+    BOOL(api_snapshot_thumbnail, "api:snapshot_thumbnail", true)
+
+enum class ParamType : uint8_t {
+    Int,
+    Float,
+    Bool,
+    String,
+};
+
+struct ParamDef {
+    const char* key;
+    ParamType type;
+    double def_num;         // 数值类型的默认值（bool 为 0/1）
+    const char* def_str;    // 字符串类型的默认值
+    double min;
+    double max;
+};
+
+// 参数槽位，按表中顺序编号
+enum class ParamSlot : uint16_t {
+#define PARAM_SCHEMA_SLOT(name, ...) name,
+    RK_PARAM_SCHEMA(PARAM_SCHEMA_SLOT, PARAM_SCHEMA_SLOT, PARAM_SCHEMA_SLOT, PARAM_SCHEMA_SLOT)
+#undef PARAM_SCHEMA_SLOT
+    Count
+};
+
+static constexpr size_t kParamSlotCount = (size_t)ParamSlot::Count;
+
+static constexpr ParamDef kParamSchema[] = {
+#define PARAM_SCHEMA_INT(name, key, def, min, max) {key, ParamType::Int, (double)(def), nullptr, (double)(min), (double)(max)},
+#define PARAM_SCHEMA_FLOAT(name, key, def, min, max) {key, ParamType::Float, (double)(def), nullptr, (double)(min), (double)(max)},
+#define PARAM_SCHEMA_BOOL(name, key, def) {key, ParamType::Bool, (def) ? 1.0 : 0.0, nullptr, 0.0, 1.0},
+#define PARAM_SCHEMA_STRING(name, key, def) {key, ParamType::String, 0.0, def, 0.0, 0.0},
+    RK_PARAM_SCHEMA(PARAM_SCHEMA_INT, PARAM_SCHEMA_FLOAT, PARAM_SCHEMA_BOOL, PARAM_SCHEMA_STRING)
+#undef PARAM_SCHEMA_INT
+#undef PARAM_SCHEMA_FLOAT
+#undef PARAM_SCHEMA_BOOL
+#undef PARAM_SCHEMA_STRING
+};
+
+// 带类型的参数名，只保存槽位下标
+template <typename T>
+struct ParamKey {
+    uint16_t slot;
+};
+
+namespace param_key {
+#define PARAM_SCHEMA_INT(name, ...) constexpr ParamKey<int> name{(uint16_t)ParamSlot::name};
+#define PARAM_SCHEMA_FLOAT(name, ...) constexpr ParamKey<float> name{(uint16_t)ParamSlot::name};
+#define PARAM_SCHEMA_BOOL(name, ...) constexpr ParamKey<bool> name{(uint16_t)ParamSlot::name};
+#define PARAM_SCHEMA_STRING(name, ...) constexpr ParamKey<const char*> name{(uint16_t)ParamSlot::name};
+    RK_PARAM_SCHEMA(PARAM_SCHEMA_INT, PARAM_SCHEMA_FLOAT, PARAM_SCHEMA_BOOL, PARAM_SCHEMA_STRING)
+#undef PARAM_SCHEMA_INT
+#undef PARAM_SCHEMA_FLOAT
+#undef PARAM_SCHEMA_BOOL
+#undef PARAM_SCHEMA_STRING
+}
+
+// 编译期检查参数表：参数名格式正确、不重复，默认值在取值范围内
+namespace param_schema_check {
+
+constexpr bool key_equal(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+constexpr bool key_valid(const char* key) {
+    bool colon = false;
+    for (const char* p = key; *p; p++) {
+        if (*p >= 'A' && *p <= 'Z') {
+            return false;   // iniparser 的 key 均为小写
+        }
+        if (*p == ':') {
+            if (colon || p == key || p[1] == '\0') {
+                return false;
+            }
+            colon = true;
+        }
+    }
+    return colon;
+}
+
+constexpr bool schema_valid() {
+    for (size_t i = 0; i < kParamSlotCount; i++) {
+        const ParamDef& def = kParamSchema[i];
+        if (!key_valid(def.key) || def.min > def.max) {
+            return false;
+        }
+        if (def.type != ParamType::String && (def.def_num < def.min || def.def_num > def.max)) {
+            return false;
+        }
+        for (size_t j = i + 1; j < kParamSlotCount; j++) {
+            if (key_equal(def.key, kParamSchema[j].key)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}
+
+static_assert(sizeof(kParamSchema) / sizeof(kParamSchema[0]) == kParamSlotCount, "param schema size mismatch");
+static_assert(param_schema_check::schema_valid(), "invalid param schema: bad key, duplicate key or default out of range");
+
+#endif // PARAM_SCHEMA_H
@@ -0,0 +1,448 @@
+#include "param_snapshot.h"
+#include "param.h"
+#include "log.h"
+#include "Signal.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+extern "C" {
+    extern dictionary *g_ini_d_;
+    extern pthread_mutex_t g_param_mutex;
+}
+
+// 参数名只由 ASCII 字符组成，不区分大小写，不需要经过 locale
+static inline unsigned char lower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c;
+}
+
+// 按小写计算哈希（FNV-1a），快照中的 key 均为小写
+static uint32_t hash_entry(const char* entry) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)entry; *p; p++) {
+        hash ^= lower(*p);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool equal_entry(const char* query, const std::string& key) {
+    const unsigned char* a = (const unsigned char*)query;
+    const unsigned char* b = (const unsigned char*)key.c_str();
+    while (*a && lower(*a) == *b) {
+        a++;
+        b++;
+    }
+    return *a == '\0' && *b == '\0';
+}
+
+const ParamSnapshot::Entry* ParamSnapshot::find(const char* entry) const {
+    if (entry == nullptr || slots.empty()) {
+        return nullptr;
+    }
+    uint32_t hash = hash_entry(entry);
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask; slots[i] != 0; i = (i + 1) & mask) {
+        const Entry& e = entries[slots[i] - 1];
+        if (e.hash == hash && equal_entry(entry, e.key)) {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+const ParamSnapshot::Entry* ParamSnapshot::find(const Entry& other) const {
+    if (slots.empty()) {
+        return nullptr;
+    }
+    size_t mask = slots.size() - 1;
+    for (size_t i = other.hash & mask; slots[i] != 0; i = (i + 1) & mask) {
+        const Entry& e = entries[slots[i] - 1];
+        if (e.hash == other.hash && e.key == other.key) {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+// 空快照中参数表的值均为默认值
+ParamSnapshot::ParamSnapshot() : version_(0) {
+    for (size_t i = 0; i < kParamSlotCount; i++) {
+        const ParamDef& def = kParamSchema[i];
+        typed[i].int_value = (int)def.def_num;
+        typed[i].float_value = (float)def.def_num;
+        typed[i].str_value = def.def_str;
+    }
+}
+
+int ParamSnapshot::getInt(const char* entry, int default_val) const {
+    const Entry* e = find(entry);
+    return e ? e->int_value : default_val;
+}
+
+float ParamSnapshot::getFloat(const char* entry, float default_val) const {
+    const Entry* e = find(entry);
+    return (e && e->float_valid) ? e->float_value : default_val;
+}
+
+bool ParamSnapshot::getBool(const char* entry, bool default_val) const {
+    const Entry* e = find(entry);
+    if (!e || e->value.empty()) {
+        return default_val;
+    }
+    switch (e->value[0]) {
+    case 'y': case 'Y': case '1': case 't': case 'T':
+        return true;
+    case 'n': case 'N': case '0': case 'f': case 'F':
+        return false;
+    default:
+        return default_val;
+    }
+}
+
+const char* ParamSnapshot::getString(const char* entry, const char* default_val) const {
+    const Entry* e = find(entry);
+    return e ? e->value.c_str() : default_val;
+}
+
+std::vector<std::pair<std::string, std::string>> ParamSnapshot::getSection(const char* section) const {
+    std::vector<std::pair<std::string, std::string>> result;
+    if (section == nullptr) {
+        return result;
+    }
+    size_t len = strlen(section);
+    for (const auto& e : entries) {
+        if (e.key.size() > len && e.key[len] == ':' && strncasecmp(e.key.c_str(), section, len) == 0) {
+            result.emplace_back(e.key, e.value);
+        }
+    }
+    return result;
+}
+
+bool ParamChange::affects(const std::string& section) const {
+    for (const auto& changed : sections) {
+        if (changed.compare(0, section.size(), section) == 0 &&
+            (changed.size() == section.size() || changed[section.size()] == '.')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 按参数表检查一个值，合法时返回 nullptr 并写入 value，否则返回错误说明
+static const char* check_value(const ParamDef& def, const char* str, double* value) {
+    char* end = nullptr;
+    *value = 0;
+    switch (def.type) {
+    case ParamType::Int:
+        *value = (double)strtol(str, &end, 0);
+        break;
+    case ParamType::Float:
+        *value = strtod(str, &end);
+        break;
+    case ParamType::Bool:
+        if (str[0] != '\0' && strchr("yYtT1", str[0])) {
+            *value = 1;
+            return nullptr;
+        }
+        if (str[0] != '\0' && strchr("nNfF0", str[0])) {
+            return nullptr;
+        }
+        return "is not a boolean";
+    case ParamType::String:
+        return nullptr;
+    }
+
+    while (end != nullptr && end != str && isspace((unsigned char)*end)) {
+        end++;
+    }
+    if (end == str || *end != '\0') {
+        return "is not a number";
+    }
+    if (*value < def.min || *value > def.max) {
+        return "is out of range";
+    }
+    return nullptr;
+}
+
+// 从字典生成快照
+class ParamSnapshotBuilder {
+public:
+    static std::shared_ptr<ParamSnapshot> build() {
+        auto snapshot = std::make_shared<ParamSnapshot>();
+        auto& entries = snapshot->entries;
+
+        // 锁内只复制字符串，解析放到锁外
+        pthread_mutex_lock(&g_param_mutex);
+        if (g_ini_d_ != NULL) {
+            entries.reserve(g_ini_d_->n);
+            for (ssize_t i = 0; i < g_ini_d_->end; i++) {
+                // 没有值的条目是 section 本身
+                if (g_ini_d_->key[i] == NULL || g_ini_d_->val[i] == NULL) {
+                    continue;
+                }
+                ParamSnapshot::Entry e;
+                e.key = g_ini_d_->key[i];
+                e.value = g_ini_d_->val[i];
+                entries.push_back(std::move(e));
+            }
+        }
+        pthread_mutex_unlock(&g_param_mutex);
+
+        for (auto& e : entries) {
+            const char* str = e.value.c_str();
+            char* end = nullptr;
+            e.hash = hash_entry(e.key.c_str());
+            e.int_value = (int)strtol(str, nullptr, 0);
+            e.float_value = strtof(str, &end);
+            e.float_valid = (end != str);
+        }
+
+        // 哈希表至少保持一半空槽，查找时探测次数很少
+        size_t nslots = 16;
+        while (nslots < entries.size() * 2) {
+            nslots <<= 1;
+        }
+        auto& slots = snapshot->slots;
+        slots.assign(nslots, 0);
+        for (uint32_t i = 0; i < entries.size(); i++) {
+            size_t pos = entries[i].hash & (nslots - 1);
+            while (slots[pos] != 0) {
+                pos = (pos + 1) & (nslots - 1);
+            }
+            slots[pos] = i + 1;
+        }
+
+        resolveSchema(*snapshot);
+        return snapshot;
+    }
+
+    // 按参数表解析并校验，不合法的值记录错误后使用默认值
+    static void resolveSchema(ParamSnapshot& snapshot) {
+        char msg[256];
+        for (size_t i = 0; i < kParamSlotCount; i++) {
+            const ParamDef& def = kParamSchema[i];
+            ParamSnapshot::TypedValue& typed = snapshot.typed[i];
+            const ParamSnapshot::Entry* e = snapshot.find(def.key);
+            if (e == nullptr) {
+                continue;
+            }
+
+            const char* str = e->value.c_str();
+            if (def.type == ParamType::String) {
+                typed.str_value = str;
+                continue;
+            }
+            double value = 0;
+            const char* error = check_value(def, str, &value);
+            if (error != nullptr) {
+                snprintf(msg, sizeof(msg), "%s = \"%s\" %s, expected [%g, %g], using default %g",
+                         def.key, str, error, def.min, def.max, def.def_num);
+                snapshot.errors_.push_back(msg);
+                continue;
+            }
+            typed.int_value = (int)value;
+            typed.float_value = (float)value;
+        }
+    }
+
+    static void setVersion(ParamSnapshot& snapshot, uint64_t version) {
+        snapshot.version_ = version;
+    }
+
+    // 对比两个快照，返回发生变化的 section
+    static std::vector<std::string> diff(const ParamSnapshot& a, const ParamSnapshot& b) {
+        std::set<std::string> changed;
+        auto section_of = [](const std::string& key) {
+            return key.substr(0, key.find(':'));
+        };
+
+        for (const auto& eb : b.entries) {
+            const ParamSnapshot::Entry* ea = a.find(eb);
+            if (ea == nullptr || ea->value != eb.value) {
+                changed.insert(section_of(eb.key));
+            }
+        }
+        // 被删除的参数
+        for (const auto& ea : a.entries) {
+            if (b.find(ea) == nullptr) {
+                changed.insert(section_of(ea.key));
+            }
+        }
+        return std::vector<std::string>(changed.begin(), changed.end());
+    }
+};
+
+static std::shared_ptr<const ParamSnapshot> g_snapshot;
+static std::mutex g_publish_mutex;
+static std::atomic<int> g_subscriber_count(0);
+
+// 变更通知在 SignalExecutor 的低优先级线程中执行，修改参数的线程不会被订阅者阻塞
+static Signal<ParamChangePtr>& change_signal() {
+    static Signal<ParamChangePtr> signal("param_change", SignalPriority::Low);
+    return signal;
+}
+
+ParamSnapshotPtr rk_param_snapshot() {
+    static const ParamSnapshotPtr empty = std::make_shared<ParamSnapshot>();
+    ParamSnapshotPtr snapshot = std::atomic_load(&g_snapshot);
+    return snapshot ? snapshot : empty;
+}
+
+// 订阅登记表；running 为正在执行的回调数，退订时等待其归零
+struct ParamSubscriber {
+    int token;
+    std::string section;
+    ParamChangeCallback callback;
+    int running = 0;
+    bool removed = false;
+};
+
+struct ParamSubscribers {
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::vector<std::shared_ptr<ParamSubscriber>> list;
+    int next_token = 1;
+    bool connected = false;
+};
+
+// 全局对象析构时仍会退订，登记表不随静态对象析构
+static ParamSubscribers& subscribers() {
+    static ParamSubscribers* registry = new ParamSubscribers();
+    return *registry;
+}
+
+// 当前线程正在执行的订阅回调，回调中退订自己时不能等待自己结束
+static thread_local const ParamSubscriber* t_running_subscriber = nullptr;
+
+static void dispatch_change(const ParamChangePtr& change) {
+    ParamSubscribers& registry = subscribers();
+    std::vector<std::shared_ptr<ParamSubscriber>> list;
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        list = registry.list;
+    }
+    for (const auto& subscriber : list) {
+        if (!change->affects(subscriber->section)) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            if (subscriber->removed) {
+                continue;
+            }
+            subscriber->running++;
+        }
+        const ParamSubscriber* outer = t_running_subscriber;
+        t_running_subscriber = subscriber.get();
+        subscriber->callback(change);
+        t_running_subscriber = outer;
+        {
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            subscriber->running--;
+        }
+        registry.idle.notify_all();
+    }
+}
+
+int rk_param_subscribe(const std::string& section, ParamChangeCallback callback) {
+    ParamSubscribers& registry = subscribers();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (!registry.connected) {
+        change_signal().connect(dispatch_change);
+        registry.connected = true;
+    }
+    auto subscriber = std::make_shared<ParamSubscriber>();
+    subscriber->token = registry.next_token++;
+    subscriber->section = section;
+    subscriber->callback = std::move(callback);
+    registry.list.push_back(subscriber);
+    g_subscriber_count++;
+    return subscriber->token;
+}
+
+void rk_param_unsubscribe(int token) {
+    if (token <= 0) {
+        return;
+    }
+    ParamSubscribers& registry = subscribers();
+    std::unique_lock<std::mutex> lock(registry.mutex);
+    auto it = std::find_if(registry.list.begin(), registry.list.end(),
+                           [token](const std::shared_ptr<ParamSubscriber>& s) { return s->token == token; });
+    if (it == registry.list.end()) {
+        return;
+    }
+    std::shared_ptr<ParamSubscriber> subscriber = *it;
+    registry.list.erase(it);
+    subscriber->removed = true;
+    g_subscriber_count--;
+    if (t_running_subscriber != subscriber.get()) {
+        registry.idle.wait(lock, [&] { return subscriber->running == 0; });
+    }
+}
+
+// 批量修改前由 param.c 调用，参数表中的参数必须类型正确且在取值范围内，其他参数不检查
+extern "C" int rk_param_check_value(const char* entry, const char* value) {
+    for (size_t i = 0; i < kParamSlotCount; i++) {
+        const ParamDef& def = kParamSchema[i];
+        if (strcasecmp(def.key, entry) != 0) {
+            continue;
+        }
+        double number = 0;
+        const char* error = check_value(def, value, &number);
+        if (error != nullptr) {
+            LOG_ERROR("param %s = \"%s\" %s, expected [%g, %g]\n", def.key, value, error, def.min, def.max);
+            return -1;
+        }
+        return 0;
+    }
+    return 0;
+}
+
+// 参数修改后由 param.c 调用（不能持有 g_param_mutex），内容没有变化时不发布新快照
+extern "C" void rk_param_publish() {
+    static uint64_t version = 0;
+
+    // 串行化发布，保证快照版本与修改顺序一致
+    std::lock_guard<std::mutex> lock(g_publish_mutex);
+    auto snapshot = ParamSnapshotBuilder::build();
+    auto previous = std::atomic_load(&g_snapshot);
+
+    std::vector<std::string> sections;
+    if (previous) {
+        sections = ParamSnapshotBuilder::diff(*previous, *snapshot);
+        if (sections.empty()) {
+            return;
+        }
+    }
+
+    // 只报告新出现的校验错误，避免每次修改参数都重复输出
+    for (const auto& error : snapshot->errors()) {
+        if (!previous || std::find(previous->errors().begin(), previous->errors().end(), error) ==
+                             previous->errors().end()) {
+            LOG_ERROR("invalid param %s\n", error.c_str());
+        }
+    }
+
+    ParamSnapshotBuilder::setVersion(*snapshot, ++version);
+    std::atomic_store(&g_snapshot, std::shared_ptr<const ParamSnapshot>(snapshot));
+
+    if (!previous || g_subscriber_count == 0) {
+        return;
+    }
+
+    auto change = std::make_shared<ParamChange>();
+    change->snapshot = snapshot;
+    change->previous = previous;
+    change->sections = std::move(sections);
+    LOG_DEBUG("param snapshot v%llu, %zu sections changed\n",
+              (unsigned long long)snapshot->version(), change->sections.size());
+    change_signal().emit(change);
+}
@@ -0,0 +1,98 @@
+#ifndef PARAM_SNAPSHOT_H
+#define PARAM_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include "param_schema.h"
+
+// 参数快照：某一时刻全部参数的只读副本
+//
+// 每次参数被修改后生成一份新快照并原子发布，读者通过 rk_param_snapshot() 取得
+// 当前快照后不再需要加锁。快照内的字符串归快照所有，持有快照期间一直有效，
+// 不会因为参数被修改或重新加载而失效。整数和浮点值在生成快照时就已解析好。
+class ParamSnapshot {
+public:
+    ParamSnapshot();
+
+    // 快照版本号，每次发布递增
+    uint64_t version() const { return version_; }
+
+    bool has(const char* entry) const { return find(entry) != nullptr; }
+
+    // 与 rk_param_get_int/float/string 的解析规则一致
+    int getInt(const char* entry, int default_val) const;
+    float getFloat(const char* entry, float default_val) const;
+    bool getBool(const char* entry, bool default_val) const;
+
+    // 返回的指针在快照存活期间有效
+    const char* getString(const char* entry, const char* default_val) const;
+
+    // 获取一个 section 下的全部参数，顺序与配置文件一致
+    std::vector<std::pair<std::string, std::string>> getSection(const char* section) const;
+
+    // 按参数表取值（见 param_schema.h），值已解析并校验，不查找字符串
+    int get(ParamKey<int> key) const { return typed[key.slot].int_value; }
+    float get(ParamKey<float> key) const { return typed[key.slot].float_value; }
+    bool get(ParamKey<bool> key) const { return typed[key.slot].int_value != 0; }
+    const char* get(ParamKey<const char*> key) const { return typed[key.slot].str_value; }
+
+    // 按参数表校验时发现的错误，对应的参数使用默认值
+    const std::vector<std::string>& errors() const { return errors_; }
+
+private:
+    friend class ParamSnapshotBuilder;
+
+    struct Entry {
+        std::string key;        // "section:key"，小写
+        std::string value;
+        uint32_t hash;
+        int int_value;
+        float float_value;
+        bool float_valid;
+    };
+
+    struct TypedValue {
+        int int_value;          // int 和 bool
+        float float_value;
+        const char* str_value;  // 指向 entries 中的字符串或参数表中的默认值
+    };
+
+    const Entry* find(const char* entry) const;
+    const Entry* find(const Entry& other) const;   // 在另一份快照中查找同一个参数
+
+    std::vector<Entry> entries;     // 配置文件中的顺序
+    std::vector<uint32_t> slots;    // 开放寻址哈希表，存放 entries 下标 + 1，0 表示空槽
+    TypedValue typed[kParamSlotCount];
+    std::vector<std::string> errors_;
+    uint64_t version_;
+};
+
+using ParamSnapshotPtr = std::shared_ptr<const ParamSnapshot>;
+
+// 一次参数变更
+struct ParamChange {
+    ParamSnapshotPtr snapshot;          // 变更后的快照
+    ParamSnapshotPtr previous;          // 变更前的快照
+    std::vector<std::string> sections;  // 发生变化的 section
+
+    // section 本身或其子 section（如 "ai.roi" 包含 "ai.roi.0"）是否有变化
+    bool affects(const std::string& section) const;
+};
+
+using ParamChangePtr = std::shared_ptr<const ParamChange>;
+using ParamChangeCallback = std::function<void(const ParamChangePtr&)>;
+
+// 获取当前参数快照，不加锁；参数模块初始化前返回空快照
+ParamSnapshotPtr rk_param_snapshot();
+
+// 订阅某个 section 的变更，回调在参数通知线程中执行；返回退订用的编号（大于 0）
+int rk_param_subscribe(const std::string& section, ParamChangeCallback callback);
+
+// 取消订阅，返回时该订阅的回调都已执行完毕，之后不会再被调用；编号不大于 0 时忽略。
+// 回调捕获了对象指针时，对象析构前必须调用
+void rk_param_unsubscribe(int token);
+
+#endif // PARAM_SNAPSHOT_H
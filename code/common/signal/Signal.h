@@ -18,15 +18,21 @@
 #include <algorithm>
 #include <mutex>
 #include <memory>
+#include "SignalStats.h"
 
 template <typename... Args>
 class Signal {
 public:
     using Slot = std::function<void(Args...)>;
 
+    // 直接调用模式下名称、优先级和投递策略都没有作用，只为与 EVENT_LOOP 模式保持接口一致
+    explicit Signal(SignalPriority = SignalPriority::Normal) {}
+    explicit Signal(const char*, SignalPriority = SignalPriority::Normal) {}
+
     // 连接成员函数
     template <typename T>
-    void connect(T* object, void (T::*method)(Args...)) {
+    void connect(T* object, void (T::*method)(Args...),
+                 DeliveryPolicy = DeliveryPolicy::Fifo, size_t = 0) {
         auto slot = [object, method](Args... args) {
             (object->*method)(args...);  // 调用成员函数
         };
@@ -36,7 +42,8 @@ public:
 
     // 修改这里，使用完全不同的名称避免重载冲突
     template <typename T>
-    void connectWithRef(T* object, void (T::*method)(const Args&...)) {
+    void connectWithRef(T* object, void (T::*method)(const Args&...),
+                        DeliveryPolicy = DeliveryPolicy::Fifo, size_t = 0) {
         auto slot = [object, method](Args... args) {
             (object->*method)(args...);  // 调用成员函数
         };
@@ -45,7 +52,7 @@ public:
     }
 
     // 连接普通函数
-    void connect(Slot slot) {
+    void connect(Slot slot, DeliveryPolicy = DeliveryPolicy::Fifo, size_t = 0) {
         std::lock_guard<std::mutex> lock(mutex_);
         slots.push_back(std::make_shared<Slot>(std::move(slot)));
     }
@@ -79,97 +86,265 @@ private:
 #include <algorithm>
 #include <mutex>
 #include <memory>
-#include <queue>
-#include <thread>
-#include <condition_variable>
+#include <tuple>
 #include <atomic>
+#include <condition_variable>
+#include <type_traits>
+#include <utility>
+#include "SignalExecutor.h"
+#include "SignalStats.h"
 
 template <typename... Args>
 class Signal {
 public:
     using Slot = std::function<void(Args...)>;
 
-    // 构造函数，启动事件循环线程
-    Signal() : running(true) {
-        eventLoopThread = std::thread(&Signal::eventLoop, this);  // 启动事件循环线程
+    // DropOldest 未指定容量时的默认值
+    static constexpr size_t kDefaultCapacity = 4;
+
+    // 事件投递到共享的 SignalExecutor，按优先级执行，不再为每个 Signal 创建线程
+    // 名称用于 /api/system/signals 中的统计
+    explicit Signal(SignalPriority priority = SignalPriority::Normal) : Signal("", priority) {}
+
+    explicit Signal(const char* name, SignalPriority priority = SignalPriority::Normal)
+        : priority(priority), state(std::make_shared<State>(name, priority)) {
+        SignalRegistry::instance().add(state->stats);
     }
 
-    // 析构函数，停止事件循环线程
+    // 析构后尚未执行的事件直接丢弃；正在执行本 Signal 槽函数的事件先执行完再返回，
+    // 之后接收者可以安全析构。在本 Signal 自己的槽函数中析构时不等待自己
     ~Signal() {
-        stop();
-        if (eventLoopThread.joinable()) {
-            eventLoopThread.join();  // 等待事件循环线程退出
-        }
+        state->alive.store(false);
+        SignalRegistry::instance().remove(state->stats.get());
+        int self = runningState() == state.get() ? 1 : 0;
+        std::unique_lock<std::mutex> lock(state->idle_mutex);
+        state->idle.wait(lock, [&] { return state->running.load() <= self; });
     }
 
+    Signal(const Signal&) = delete;
+    Signal& operator=(const Signal&) = delete;
+
     // 连接成员函数
     template <typename T>
-    void connect(T* object, void (T::*method)(Args...)) {
-        auto slot = [object, method](Args... args) {
+    void connect(T* object, void (T::*method)(Args...),
+                 DeliveryPolicy policy = DeliveryPolicy::Fifo, size_t capacity = 0) {
+        addSlot([object, method](Args... args) {
             (object->*method)(args...);
-        };
-        std::lock_guard<std::mutex> lock(mutex_);
-        slots.push_back(std::make_shared<Slot>(slot));
+        }, policy, capacity);
     }
 
     // 修改这里，使用完全不同的名称避免重载冲突
     template <typename T>
-    void connectWithRef(T* object, void (T::*method)(const Args&...)) {
-        auto slot = [object, method](Args... args) {
+    void connectWithRef(T* object, void (T::*method)(const Args&...),
+                        DeliveryPolicy policy = DeliveryPolicy::Fifo, size_t capacity = 0) {
+        addSlot([object, method](Args... args) {
             (object->*method)(args...);  // 调用成员函数
-        };
-        std::lock_guard<std::mutex> lock(mutex_);
-        slots.push_back(std::make_shared<Slot>(slot));  // 存储槽
+        }, policy, capacity);
     }
 
     // 连接普通函数
-    void connect(Slot slot) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        slots.push_back(std::make_shared<Slot>(std::move(slot)));
+    void connect(Slot slot, DeliveryPolicy policy = DeliveryPolicy::Fifo, size_t capacity = 0) {
+        addSlot(std::move(slot), policy, capacity);
     }
 
-    // 发射信号
+    // 发射信号：参数按值保存
+    // Fifo 连接共用一个事件，依次调用；DropOldest / CoalesceLatest 连接各自缓存待投递的值
     void emit(Args... args) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        // 将事件添加到队列
-        for (auto& slot : slots) {
-            eventQueue.push([slot, args...]() {
-                (*slot)(args...);  // 执行槽函数
-            });
+        const SlotList* list = state->current.load(std::memory_order_acquire);
+        if (list == nullptr) {
+            return;
+        }
+        state->stats->emitted.fetch_add(1, std::memory_order_relaxed);
+
+        if (list->fifo_count > 0) {
+            state->stats->onQueued(list->fifo_count);
+            SignalExecutor::instance().post(priority, FifoEvent{state, list, ArgsTuple(args...)});
+        }
+        if (list->fifo_count == list->connections.size()) {
+            return;
+        }
+        for (const auto& conn : list->connections) {
+            if (conn->policy != DeliveryPolicy::Fifo) {
+                enqueue(conn, ArgsTuple(args...));
+            }
         }
-        condVar.notify_one();  // 通知事件调度器
     }
 
 private:
-    // 事件调度器，处理队列中的事件
-    void eventLoop() {
-        while (running) {
-            std::unique_lock<std::mutex> lock(mutex_);
-            condVar.wait(lock, [this]() { return !eventQueue.empty() || !running; });
-
-            while (!eventQueue.empty()) {
-                auto event = eventQueue.front();
-                eventQueue.pop();
-                lock.unlock();
-                event();  // 执行事件
-                lock.lock();
+    using ArgsTuple = std::tuple<typename std::decay<Args>::type...>;
+
+    template <size_t... I>
+    static void call(const Slot& slot, ArgsTuple& args, std::index_sequence<I...>) {
+        slot(std::get<I>(args)...);
+    }
+
+    struct Connection {
+        Slot slot;
+        DeliveryPolicy policy;
+        size_t capacity;
+        std::mutex mutex;                   // 保护 pending 和 scheduled
+        std::vector<ArgsTuple> pending;     // 尚未投递的值（非 Fifo 连接）
+        std::vector<ArgsTuple> draining;    // 正在投递的一批值，只在执行器线程中使用
+        bool scheduled = false;             // 执行器中是否已有该连接的投递事件
+    };
+    using ConnectionPtr = std::shared_ptr<Connection>;
+
+    struct SlotList {
+        std::vector<ConnectionPtr> connections;
+        size_t fifo_count = 0;
+    };
+
+    // 槽列表、统计和存活标志，由 Signal 和尚未执行的事件共同持有
+    // 连接时生成新的槽列表，旧列表保留到 State 释放，发射时只需原子读取当前列表
+    struct State {
+        State(const char* name, SignalPriority priority)
+            : stats(std::make_shared<SignalStats>(name, priority)) {}
+
+        // 开始调用槽函数前登记，析构时 alive 已清除则放弃；与析构中先清 alive 再读 running 配对
+        bool enter() {
+            running.fetch_add(1);
+            if (!alive.load()) {
+                leave();
+                return false;
             }
+            return true;
         }
+
+        void leave() {
+            running.fetch_sub(1);
+            if (!alive.load()) {
+                std::lock_guard<std::mutex> lock(idle_mutex);
+                idle.notify_all();
+            }
+        }
+
+        std::atomic<bool> alive{true};
+        std::atomic<int> running{0};        // 正在调用槽函数的事件数
+        std::mutex idle_mutex;
+        std::condition_variable idle;       // 析构时等待 running 归零
+        std::shared_ptr<SignalStats> stats;
+        std::atomic<const SlotList*> current{nullptr};
+        std::vector<std::unique_ptr<SlotList>> lists;   // 所有生成过的槽列表，只在 mutex 下修改
+        std::mutex mutex;
+    };
+    using StatePtr = std::shared_ptr<State>;
+
+    // 当前线程正在执行的事件所属的 State
+    static const State*& runningState() {
+        static thread_local const State* running = nullptr;
+        return running;
     }
 
-    // 停止事件循环
-    void stop() {
-        running = false;
-        condVar.notify_one();  // 唤醒事件循环线程，退出
+    // 依次调用所有 Fifo 连接
+    struct FifoEvent {
+        StatePtr state;
+        const SlotList* list;
+        ArgsTuple args;
+
+        void operator()() {
+            bool alive = state->enter();
+            const State* outer = runningState();
+            runningState() = state.get();
+            for (const auto& conn : list->connections) {
+                if (conn->policy != DeliveryPolicy::Fifo) {
+                    continue;
+                }
+                if (alive) {
+                    call(conn->slot, args, std::index_sequence_for<Args...>());
+                    state->stats->onDelivered();
+                } else {
+                    state->stats->onDropped();
+                }
+            }
+            runningState() = outer;
+            if (alive) {
+                state->leave();
+            }
+        }
+    };
+
+    // 投递某个连接缓存的值，直到缓存为空
+    // 两个缓冲区轮换使用，稳定运行后不再分配内存
+    struct DrainEvent {
+        StatePtr state;
+        ConnectionPtr conn;
+
+        void operator()() {
+            for (;;) {
+                {
+                    std::lock_guard<std::mutex> lock(conn->mutex);
+                    if (conn->pending.empty()) {
+                        conn->scheduled = false;
+                        return;
+                    }
+                    conn->pending.swap(conn->draining);
+                }
+                bool alive = state->enter();
+                const State* outer = runningState();
+                runningState() = state.get();
+                for (auto& args : conn->draining) {
+                    if (alive) {
+                        call(conn->slot, args, std::index_sequence_for<Args...>());
+                        state->stats->onDelivered();
+                    } else {
+                        state->stats->onDropped();
+                    }
+                }
+                runningState() = outer;
+                if (alive) {
+                    state->leave();
+                }
+                conn->draining.clear();
+            }
+        }
+    };
+
+    void enqueue(const ConnectionPtr& conn, ArgsTuple&& args) {
+        bool schedule = false;
+        {
+            std::lock_guard<std::mutex> lock(conn->mutex);
+            if (conn->pending.size() >= conn->capacity) {
+                conn->pending.erase(conn->pending.begin());
+                state->stats->onDropped();
+            }
+            conn->pending.push_back(std::move(args));
+            state->stats->onQueued();
+            if (!conn->scheduled) {
+                conn->scheduled = true;
+                schedule = true;
+            }
+        }
+        if (schedule) {
+            SignalExecutor::instance().post(priority, DrainEvent{state, conn});
+        }
+    }
+
+    // 连接时复制槽列表，正在执行的事件仍使用旧列表
+    void addSlot(Slot slot, DeliveryPolicy policy, size_t capacity) {
+        auto conn = std::make_shared<Connection>();
+        conn->slot = std::move(slot);
+        conn->policy = policy;
+        if (policy == DeliveryPolicy::CoalesceLatest) {
+            conn->capacity = 1;
+        } else {
+            conn->capacity = capacity > 0 ? capacity : kDefaultCapacity;
+        }
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        const SlotList* old = state->current.load(std::memory_order_relaxed);
+        std::unique_ptr<SlotList> list(old ? new SlotList(*old) : new SlotList());
+        list->connections.push_back(std::move(conn));
+        if (policy == DeliveryPolicy::Fifo) {
+            list->fifo_count++;
+        }
+        state->stats->connections.store(list->connections.size(), std::memory_order_relaxed);
+        state->current.store(list.get(), std::memory_order_release);
+        state->lists.push_back(std::move(list));
     }
 
 private:
-    std::vector<std::shared_ptr<Slot>> slots;  // 存储连接的槽
-    std::queue<std::function<void()>> eventQueue;  // 事件队列
-    std::mutex mutex_;  // 用于线程安全
-    std::condition_variable condVar;  // 用于线程同步
-    std::atomic<bool> running;  // 事件循环是否继续运行
-    std::thread eventLoopThread;  // 事件循环线程
+    SignalPriority priority;
+    StatePtr state;
 };
 
 #endif
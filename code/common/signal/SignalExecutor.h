@@ -0,0 +1,463 @@
+// SignalExecutor.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <sys/prctl.h>
+#include "SignalStats.h"
+
+// 小对象优化的可调用对象，只能移动
+// 不超过 kInlineSize 的可调用对象直接存放在内部缓冲区，发射事件时不分配内存
+class SignalTask {
+public:
+    static constexpr size_t kInlineSize = 128;
+
+    SignalTask() : ops(nullptr) {}
+
+    template <typename F, typename Fn = typename std::decay<F>::type,
+              typename = typename std::enable_if<!std::is_same<Fn, SignalTask>::value>::type>
+    SignalTask(F&& f) : ops(&OpsFor<Fn, fitsInline<Fn>()>::ops) {
+        OpsFor<Fn, fitsInline<Fn>()>::construct(&storage, std::forward<F>(f));
+    }
+
+    SignalTask(SignalTask&& other) noexcept : ops(other.ops) {
+        if (ops) {
+            ops->move(&storage, &other.storage);
+            other.ops = nullptr;
+        }
+    }
+
+    SignalTask& operator=(SignalTask&& other) noexcept {
+        if (this != &other) {
+            reset();
+            ops = other.ops;
+            if (ops) {
+                ops->move(&storage, &other.storage);
+                other.ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    SignalTask(const SignalTask&) = delete;
+    SignalTask& operator=(const SignalTask&) = delete;
+
+    ~SignalTask() { reset(); }
+
+    explicit operator bool() const { return ops != nullptr; }
+
+    void operator()() { ops->call(&storage); }
+
+    void reset() {
+        if (ops) {
+            ops->destroy(&storage);
+            ops = nullptr;
+        }
+    }
+
+private:
+    using Storage = typename std::aligned_storage<kInlineSize, alignof(std::max_align_t)>::type;
+
+    struct Ops {
+        void (*call)(void*);
+        void (*move)(void* dst, void* src);   // 移动后销毁 src
+        void (*destroy)(void*);
+    };
+
+    template <typename Fn>
+    static constexpr bool fitsInline() {
+        return sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<Fn>::value;
+    }
+
+    template <typename Fn, bool Inline>
+    struct OpsFor;
+
+    // 存放在内部缓冲区
+    template <typename Fn>
+    struct OpsFor<Fn, true> {
+        template <typename F>
+        static void construct(void* p, F&& f) { new (p) Fn(std::forward<F>(f)); }
+        static void call(void* p) { (*static_cast<Fn*>(p))(); }
+        static void move(void* dst, void* src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        }
+        static void destroy(void* p) { static_cast<Fn*>(p)->~Fn(); }
+        static const Ops ops;
+    };
+
+    // 过大的可调用对象放到堆上，缓冲区中只存指针
+    template <typename Fn>
+    struct OpsFor<Fn, false> {
+        template <typename F>
+        static void construct(void* p, F&& f) { *static_cast<Fn**>(p) = new Fn(std::forward<F>(f)); }
+        static void call(void* p) { (**static_cast<Fn**>(p))(); }
+        static void move(void* dst, void* src) { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); }
+        static void destroy(void* p) { delete *static_cast<Fn**>(p); }
+        static const Ops ops;
+    };
+
+    const Ops* ops;
+    Storage storage;
+};
+
+template <typename Fn>
+const SignalTask::Ops SignalTask::OpsFor<Fn, true>::ops = {
+    &SignalTask::OpsFor<Fn, true>::call,
+    &SignalTask::OpsFor<Fn, true>::move,
+    &SignalTask::OpsFor<Fn, true>::destroy,
+};
+
+template <typename Fn>
+const SignalTask::Ops SignalTask::OpsFor<Fn, false>::ops = {
+    &SignalTask::OpsFor<Fn, false>::call,
+    &SignalTask::OpsFor<Fn, false>::move,
+    &SignalTask::OpsFor<Fn, false>::destroy,
+};
+
+// 有界无锁多生产者单消费者队列
+// 每个槽位带一个序号，生产者通过 CAS 抢占写入位置，消费者只有一个，按顺序读出
+class SignalTaskQueue {
+public:
+    explicit SignalTaskQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask = size - 1;
+        cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++) {
+            cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+        enqueue_pos.store(0, std::memory_order_relaxed);
+        dequeue_pos.store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+    // 队列满时返回 false，task 保持不变
+    bool push(SignalTask& task) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->task = std::move(task);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 只能由消费者线程调用
+    bool pop(SignalTask& task) {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        Cell* cell = &cells[pos & mask];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(pos + 1) < 0) {
+            return false;
+        }
+        task = std::move(cell->task);
+        cell->seq.store(pos + mask + 1, std::memory_order_release);
+        dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 只能由消费者线程调用
+    bool empty() const {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        const Cell* cell = &cells[pos & mask];
+        return (intptr_t)cell->seq.load(std::memory_order_acquire) - (intptr_t)(pos + 1) < 0;
+    }
+
+    // 已被生产者占用的写入位置，之前的位置都已入队或正在写入
+    size_t tail() const { return enqueue_pos.load(std::memory_order_acquire); }
+
+    // 只能由消费者线程调用
+    size_t head() const { return dequeue_pos.load(std::memory_order_relaxed); }
+
+    // 当前排队的事件数，只用于统计，可以在任意线程调用
+    size_t size() const {
+        size_t head = dequeue_pos.load(std::memory_order_relaxed);
+        size_t tail = enqueue_pos.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        SignalTask task;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueue_pos;
+    alignas(64) std::atomic<size_t> dequeue_pos;   // 只有消费者写入
+};
+
+// 所有 Signal 共用的事件执行器
+// 每个优先级一个有界队列和一个工作线程，线程在该优先级第一次收到事件时启动，
+// 取代原来每个 Signal 对象各自创建一个事件循环线程的做法
+//
+// 队列满时：
+//   - 其他线程投递时在条件变量上等待消费者腾出空间（Fifo 连接不丢事件）；
+//   - 执行器线程投递时（槽函数里再次发射信号，包括发射到其他优先级）不等待，
+//     事件进入目标优先级的溢出列表，因此高、低优先级的槽函数互相发射也不会死锁。
+//     溢出列表非空时，执行器线程之后的投递也进入溢出列表；消费者先执行完取出溢出事件之前
+//     已入队的事件，再执行溢出事件，同一线程投递的事件保持顺序。
+// 同一优先级的事件由一个线程依次执行，一个槽函数耗时过长会推迟该优先级的所有事件。
+// 槽函数中只做轻量处理，耗时的工作（编码、写盘、网络请求）交给模块自己的线程；
+// 超过 kSlowTaskUs 的执行计入 slowTasks，在 /api/system/signals 中查看。
+class SignalExecutor {
+public:
+    static constexpr size_t kQueueCapacity = 256;
+    static constexpr uint64_t kSlowTaskUs = 20 * 1000;
+
+    static SignalExecutor& instance() {
+        static SignalExecutor executor;
+        return executor;
+    }
+
+    void post(SignalPriority priority, SignalTask task) {
+        Worker& worker = workers[(size_t)priority];
+        worker.ensureStarted((size_t)priority);
+        if (onWorkerThread()) {
+            if (worker.overflow_pending.load(std::memory_order_acquire) > 0 || !worker.queue.push(task)) {
+                worker.pushOverflow(std::move(task));
+            }
+        } else if (!worker.queue.push(task)) {
+            worker.waitPush(task);
+        }
+        worker.wake();
+    }
+
+    // 某个优先级队列中等待执行的事件数（含溢出列表）
+    size_t queueDepth(SignalPriority priority) const {
+        const Worker& worker = workers[(size_t)priority];
+        return worker.queue.size() + worker.overflow_pending.load(std::memory_order_relaxed);
+    }
+
+    // 进入溢出列表的事件数
+    uint64_t overflowed(SignalPriority priority) const {
+        return workers[(size_t)priority].overflowed.load(std::memory_order_relaxed);
+    }
+
+    // 生产者因队列满而等待的次数
+    uint64_t producerWaits(SignalPriority priority) const {
+        return workers[(size_t)priority].producer_waits.load(std::memory_order_relaxed);
+    }
+
+    // 执行时间超过 kSlowTaskUs 的事件数及最长执行时间
+    uint64_t slowTasks(SignalPriority priority) const {
+        return workers[(size_t)priority].slow_tasks.load(std::memory_order_relaxed);
+    }
+
+    uint64_t maxTaskUs(SignalPriority priority) const {
+        return workers[(size_t)priority].max_task_us.load(std::memory_order_relaxed);
+    }
+
+    ~SignalExecutor() {
+        for (auto& worker : workers) {
+            worker.stop();
+        }
+    }
+
+private:
+    // 当前线程是否为执行器的工作线程
+    static bool& onWorkerThread() {
+        static thread_local bool value = false;
+        return value;
+    }
+
+    struct Worker {
+        Worker() : queue(kQueueCapacity), running(true), started(false), sleeping(false) {}
+
+        void ensureStarted(size_t index) {
+            if (started.load(std::memory_order_acquire)) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!started.load(std::memory_order_relaxed)) {
+                thread = std::thread(&Worker::run, this, index);
+                started.store(true, std::memory_order_release);
+            }
+        }
+
+        // 只有消费者准备休眠时才需要加锁通知，并且只由第一个生产者通知
+        void wake() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping.load(std::memory_order_relaxed) && sleeping.exchange(false)) {
+                std::lock_guard<std::mutex> lock(mutex);
+                cond.notify_one();
+            }
+        }
+
+        void pushOverflow(SignalTask&& task) {
+            std::lock_guard<std::mutex> lock(overflow_mutex);
+            overflow.push_back(std::move(task));
+            overflow_pending.fetch_add(1, std::memory_order_release);
+            overflowed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // 队列满时等待消费者腾出空间，执行器停止后丢弃
+        void waitPush(SignalTask& task) {
+            producer_waits.fetch_add(1, std::memory_order_relaxed);
+            std::unique_lock<std::mutex> lock(space_mutex);
+            blocked.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            space_cond.wait(lock, [&] {
+                return queue.push(task) || !running.load(std::memory_order_acquire);
+            });
+            blocked.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // 消费者取出事件后通知等待中的生产者，与 waitPush 中先登记再重试入队对应
+        void notifySpace() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (blocked.load(std::memory_order_relaxed) > 0) {
+                std::lock_guard<std::mutex> lock(space_mutex);
+                space_cond.notify_all();
+            }
+        }
+
+        void execute(SignalTask& task) {
+            auto start = std::chrono::steady_clock::now();
+            task();
+            task.reset();
+            uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            if (us > kSlowTaskUs) {
+                slow_tasks.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (us > max_task_us.load(std::memory_order_relaxed)) {
+                max_task_us.store(us, std::memory_order_relaxed);
+            }
+        }
+
+        // 执行溢出列表中的事件，之前已占用队列位置的事件先执行
+        void drainOverflow() {
+            {
+                std::lock_guard<std::mutex> lock(overflow_mutex);
+                batch.swap(overflow);
+            }
+            if (batch.empty()) {
+                return;
+            }
+            SignalTask task;
+            size_t end = queue.tail();
+            while ((intptr_t)(end - queue.head()) > 0) {
+                if (queue.pop(task)) {
+                    notifySpace();
+                    execute(task);
+                } else {
+                    std::this_thread::yield();   // 生产者已占用位置、尚未写完
+                }
+            }
+            for (auto& pending : batch) {
+                execute(pending);
+            }
+            overflow_pending.fetch_sub(batch.size(), std::memory_order_release);
+            batch.clear();
+        }
+
+        void run(size_t index) {
+            static const char* names[] = {"signal_high", "signal_normal", "signal_low"};
+            prctl(PR_SET_NAME, names[index], 0, 0, 0);
+            onWorkerThread() = true;
+
+            SignalTask task;
+            while (running.load(std::memory_order_acquire)) {
+                while (queue.pop(task)) {
+                    notifySpace();
+                    execute(task);
+                }
+                if (overflow_pending.load(std::memory_order_acquire) > 0) {
+                    drainOverflow();
+                    continue;
+                }
+
+                // 休眠前先让出一次 CPU，单核上生产者可以继续投递，减少每个事件都唤醒一次的开销
+                std::this_thread::yield();
+                if (!queue.empty()) {
+                    continue;
+                }
+
+                // 先声明要休眠再检查队列，与 wake() 中先入队再检查 sleeping 对应，不会丢失唤醒
+                std::unique_lock<std::mutex> lock(mutex);
+                for (;;) {
+                    sleeping.store(true, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (!queue.empty() || overflow_pending.load(std::memory_order_relaxed) > 0 ||
+                        !running.load(std::memory_order_relaxed)) {
+                        break;
+                    }
+                    cond.wait(lock);
+                }
+                sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running.store(false, std::memory_order_release);
+                cond.notify_one();
+            }
+            {
+                std::lock_guard<std::mutex> lock(space_mutex);
+                space_cond.notify_all();
+            }
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+
+        SignalTaskQueue queue;
+        std::atomic<bool> running;
+        std::atomic<bool> started;
+        std::atomic<bool> sleeping;
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::thread thread;
+
+        // 执行器线程投递时的溢出列表，overflow_pending 含已取出、尚未执行的事件
+        std::mutex overflow_mutex;
+        std::vector<SignalTask> overflow;
+        std::vector<SignalTask> batch;      // 正在执行的一批溢出事件，只在工作线程中使用
+        std::atomic<size_t> overflow_pending{0};
+
+        // 等待队列空间的生产者
+        std::mutex space_mutex;
+        std::condition_variable space_cond;
+        std::atomic<int> blocked{0};
+
+        std::atomic<uint64_t> overflowed{0};
+        std::atomic<uint64_t> producer_waits{0};
+        std::atomic<uint64_t> slow_tasks{0};
+        std::atomic<uint64_t> max_task_us{0};
+    };
+
+    SignalExecutor() {}
+
+    Worker workers[(size_t)SignalPriority::Count];
+};
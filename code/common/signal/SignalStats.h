@@ -0,0 +1,107 @@
+// SignalStats.h
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Signal 事件的优先级，每个优先级对应一个队列和一个工作线程
+// 同一个 Signal 的事件始终进入同一个队列，由同一个线程按顺序执行
+enum class SignalPriority : uint8_t {
+    High = 0,   // 控制命令、云台调整等需要及时响应的事件
+    Normal,     // 视频帧、检测结果
+    Low,        // 参数变更等后台通知
+    Count
+};
+
+// 每个连接的投递策略
+enum class DeliveryPolicy : uint8_t {
+    Fifo = 0,       // 不丢弃，按顺序投递每一个事件（执行器队列满时发射方等待，执行器线程中发射时进入溢出列表）
+    DropOldest,     // 最多缓存 capacity 个未投递的事件，满后丢弃最旧的
+    CoalesceLatest, // 只投递最新的一个值，尚未投递的旧值被新值覆盖
+};
+
+inline const char* signalPriorityName(SignalPriority priority) {
+    switch (priority) {
+    case SignalPriority::High: return "high";
+    case SignalPriority::Normal: return "normal";
+    case SignalPriority::Low: return "low";
+    default: return "unknown";
+    }
+}
+
+// 单个 Signal 的运行统计，计数以槽函数调用为单位
+struct SignalStats {
+    SignalStats(const char* name, SignalPriority priority) : name(name), priority(priority) {}
+
+    void onQueued(uint32_t count = 1) {
+        uint32_t now = pending.fetch_add(count, std::memory_order_relaxed) + count;
+        uint32_t max = max_pending.load(std::memory_order_relaxed);
+        while (now > max && !max_pending.compare_exchange_weak(max, now, std::memory_order_relaxed)) {
+        }
+    }
+
+    void onDelivered() {
+        pending.fetch_sub(1, std::memory_order_relaxed);
+        delivered.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void onDropped() {
+        pending.fetch_sub(1, std::memory_order_relaxed);
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const std::string name;
+    const SignalPriority priority;
+    std::atomic<uint32_t> connections{0};
+    std::atomic<uint32_t> pending{0};       // 已发射、尚未投递给槽函数的事件
+    std::atomic<uint32_t> max_pending{0};
+    std::atomic<uint64_t> emitted{0};
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> dropped{0};       // 被 DropOldest / CoalesceLatest 丢弃的事件
+};
+
+// 所有 Signal 的统计，用于通过 API 查看各个信号的积压和丢弃情况
+class SignalRegistry {
+public:
+    static SignalRegistry& instance() {
+        static SignalRegistry registry;
+        return registry;
+    }
+
+    void add(const std::shared_ptr<SignalStats>& stats) {
+        std::lock_guard<std::mutex> lock(mutex);
+        signals.push_back(stats);
+    }
+
+    void remove(const SignalStats* stats) {
+        std::lock_guard<std::mutex> lock(mutex);
+        signals.erase(std::remove_if(signals.begin(), signals.end(),
+                                     [stats](const std::weak_ptr<SignalStats>& s) {
+                                         auto p = s.lock();
+                                         return !p || p.get() == stats;
+                                     }),
+                      signals.end());
+    }
+
+    std::vector<std::shared_ptr<const SignalStats>> list() {
+        std::vector<std::shared_ptr<const SignalStats>> result;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& s : signals) {
+            if (auto p = s.lock()) {
+                result.push_back(p);
+            }
+        }
+        return result;
+    }
+
+private:
+    SignalRegistry() {}
+
+    std::mutex mutex;
+    std::vector<std::weak_ptr<SignalStats>> signals;
+};
@@ -0,0 +1,667 @@
+#include "json.h"
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <cctype>
+
+// 最大嵌套深度，防止恶意请求耗尽栈空间
+static const int JSON_MAX_DEPTH = 64;
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool parseHex4(const char* p, uint32_t& out) {
+    out = 0;
+    for (int i = 0; i < 4; i++) {
+        int v = hexValue(p[i]);
+        if (v < 0) {
+            return false;
+        }
+        out = (out << 4) | v;
+    }
+    return true;
+}
+
+static void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += (char)cp;
+    } else if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+// 反转义字符串内容（已在解析阶段校验过格式）
+static void unescape(const char* p, const char* end, std::string& out) {
+    out.reserve(out.size() + (end - p));
+    while (p < end) {
+        if (*p != '\\') {
+            const char* run = p;
+            while (p < end && *p != '\\') {
+                p++;
+            }
+            out.append(run, p - run);
+            continue;
+        }
+        p++;
+        switch (*p++) {
+        case '"':  out += '"';  break;
+        case '\\': out += '\\'; break;
+        case '/':  out += '/';  break;
+        case 'b':  out += '\b'; break;
+        case 'f':  out += '\f'; break;
+        case 'n':  out += '\n'; break;
+        case 'r':  out += '\r'; break;
+        case 't':  out += '\t'; break;
+        case 'u': {
+            uint32_t cp = 0;
+            parseHex4(p, cp);
+            p += 4;
+            // UTF-16 代理对
+            if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                uint32_t low = 0;
+                if (parseHex4(p + 2, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+            }
+            appendUtf8(out, cp);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// JsonDocument
+// ---------------------------------------------------------------------------
+
+JsonDocument::JsonDocument() : data(nullptr), size(0), pos(0), error_msg(nullptr), error_offset(0) {
+}
+
+bool JsonDocument::fail(const char* msg) {
+    if (!error_msg) {
+        error_msg = msg;
+        error_offset = pos;
+    }
+    return false;
+}
+
+void JsonDocument::skipSpace() {
+    while (pos < size && (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\n' || data[pos] == '\r')) {
+        pos++;
+    }
+}
+
+bool JsonDocument::parse(const char* data, size_t size) {
+    this->data = data;
+    this->size = size;
+    pos = 0;
+    tokens.clear();
+    error_msg = nullptr;
+    error_offset = 0;
+
+    // 粗略估计 token 数量，减少扩容次数
+    tokens.reserve(size / 8 + 4);
+
+    skipSpace();
+    if (!parseValue(0)) {
+        tokens.clear();
+        return false;
+    }
+    skipSpace();
+    if (pos != size) {
+        tokens.clear();
+        return fail("Unexpected trailing characters");
+    }
+    return true;
+}
+
+bool JsonDocument::parseString() {
+    // pos 指向起始引号
+    Token tok = {JSON_STRING, false, (uint32_t)(pos + 1), 0, 0, 0};
+    pos++;
+    while (pos < size) {
+        char c = data[pos];
+        if (c == '"') {
+            tok.end = pos;
+            pos++;
+            tok.next = tokens.size() + 1;
+            tokens.push_back(tok);
+            return true;
+        }
+        if ((unsigned char)c < 0x20) {
+            return fail("Control character in string");
+        }
+        if (c == '\\') {
+            tok.escaped = true;
+            pos++;
+            if (pos >= size) {
+                break;
+            }
+            c = data[pos];
+            if (c == 'u') {
+                uint32_t cp;
+                if (pos + 4 >= size || !parseHex4(data + pos + 1, cp)) {
+                    return fail("Invalid unicode escape");
+                }
+                pos += 4;
+            } else if (!strchr("\"\\/bfnrt", c)) {
+                return fail("Invalid escape character");
+            }
+        }
+        pos++;
+    }
+    return fail("Unterminated string");
+}
+
+bool JsonDocument::parseNumber() {
+    size_t start = pos;
+    if (data[pos] == '-') {
+        pos++;
+    }
+    if (pos >= size || !isdigit((unsigned char)data[pos])) {
+        return fail("Invalid number");
+    }
+    if (data[pos] == '0') {
+        pos++;
+    } else {
+        while (pos < size && isdigit((unsigned char)data[pos])) pos++;
+    }
+    if (pos < size && data[pos] == '.') {
+        pos++;
+        if (pos >= size || !isdigit((unsigned char)data[pos])) {
+            return fail("Invalid number");
+        }
+        while (pos < size && isdigit((unsigned char)data[pos])) pos++;
+    }
+    if (pos < size && (data[pos] == 'e' || data[pos] == 'E')) {
+        pos++;
+        if (pos < size && (data[pos] == '+' || data[pos] == '-')) pos++;
+        if (pos >= size || !isdigit((unsigned char)data[pos])) {
+            return fail("Invalid number");
+        }
+        while (pos < size && isdigit((unsigned char)data[pos])) pos++;
+    }
+    Token tok = {JSON_NUMBER, false, (uint32_t)start, (uint32_t)pos, 0, (uint32_t)tokens.size() + 1};
+    tokens.push_back(tok);
+    return true;
+}
+
+bool JsonDocument::parseLiteral(const char* word, uint8_t type) {
+    size_t len = strlen(word);
+    if (size - pos < len || memcmp(data + pos, word, len) != 0) {
+        return fail("Invalid literal");
+    }
+    Token tok = {type, false, (uint32_t)pos, (uint32_t)(pos + len), 0, (uint32_t)tokens.size() + 1};
+    tokens.push_back(tok);
+    pos += len;
+    return true;
+}
+
+bool JsonDocument::parseValue(int depth) {
+    if (pos >= size) {
+        return fail("Unexpected end of input");
+    }
+    if (depth > JSON_MAX_DEPTH) {
+        return fail("Nesting too deep");
+    }
+
+    char c = data[pos];
+    if (c == '"') {
+        return parseString();
+    }
+    if (c == '-' || isdigit((unsigned char)c)) {
+        return parseNumber();
+    }
+    if (c == 't') {
+        return parseLiteral("true", JSON_BOOL);
+    }
+    if (c == 'f') {
+        return parseLiteral("false", JSON_BOOL);
+    }
+    if (c == 'n') {
+        return parseLiteral("null", JSON_NULL);
+    }
+    if (c != '{' && c != '[') {
+        return fail("Unexpected character");
+    }
+
+    bool is_object = (c == '{');
+    char close = is_object ? '}' : ']';
+    size_t self = tokens.size();
+    Token tok = {(uint8_t)(is_object ? JSON_OBJECT : JSON_ARRAY), false, (uint32_t)pos, 0, 0, 0};
+    tokens.push_back(tok);
+    pos++;
+
+    uint32_t count = 0;
+    skipSpace();
+    if (pos < size && data[pos] == close) {
+        pos++;
+    } else {
+        while (true) {
+            skipSpace();
+            if (is_object) {
+                if (pos >= size || data[pos] != '"') {
+                    return fail("Expected object key");
+                }
+                if (!parseString()) {
+                    return false;
+                }
+                skipSpace();
+                if (pos >= size || data[pos] != ':') {
+                    return fail("Expected ':'");
+                }
+                pos++;
+                skipSpace();
+            }
+            if (!parseValue(depth + 1)) {
+                return false;
+            }
+            count++;
+            skipSpace();
+            if (pos >= size) {
+                return fail("Unexpected end of input");
+            }
+            if (data[pos] == ',') {
+                pos++;
+                continue;
+            }
+            if (data[pos] == close) {
+                pos++;
+                break;
+            }
+            return fail(is_object ? "Expected ',' or '}'" : "Expected ',' or ']'");
+        }
+    }
+
+    tokens[self].end = pos;
+    tokens[self].count = count;
+    tokens[self].next = tokens.size();
+    return true;
+}
+
+JsonValue JsonDocument::root() const {
+    if (tokens.empty()) {
+        return JsonValue();
+    }
+    return JsonValue(this, 0);
+}
+
+// ---------------------------------------------------------------------------
+// JsonValue
+// ---------------------------------------------------------------------------
+
+JsonType JsonValue::type() const {
+    if (!doc || index >= doc->tokens.size()) {
+        return JSON_INVALID;
+    }
+    return (JsonType)doc->tokens[index].type;
+}
+
+size_t JsonValue::size() const {
+    JsonType t = type();
+    if (t != JSON_ARRAY && t != JSON_OBJECT) {
+        return 0;
+    }
+    return doc->tokens[index].count;
+}
+
+JsonValue JsonValue::first() const {
+    JsonType t = type();
+    if ((t != JSON_ARRAY && t != JSON_OBJECT) || doc->tokens[index].count == 0) {
+        return JsonValue();
+    }
+    // 对象的第一个 token 是 key，值紧随其后
+    bool is_object = (t == JSON_OBJECT);
+    return JsonValue(doc, is_object ? index + 2 : index + 1, doc->tokens[index].next, is_object);
+}
+
+JsonValue JsonValue::next() const {
+    if (!valid() || limit == 0) {
+        return JsonValue();
+    }
+    uint32_t after = doc->tokens[index].next;
+    if (after >= limit) {
+        return JsonValue();
+    }
+    return JsonValue(doc, member ? after + 1 : after, limit, member);
+}
+
+std::string JsonValue::key() const {
+    if (!valid() || !member) {
+        return "";
+    }
+    // 对象成员的值前一个 token 一定是 key
+    const JsonDocument::Token& k = doc->tokens[index - 1];
+    std::string out;
+    if (k.escaped) {
+        unescape(doc->data + k.start, doc->data + k.end, out);
+    } else {
+        out.assign(doc->data + k.start, k.end - k.start);
+    }
+    return out;
+}
+
+JsonValue JsonValue::operator[](const char* key) const {
+    if (type() != JSON_OBJECT) {
+        return JsonValue();
+    }
+    size_t key_len = strlen(key);
+    const auto& tokens = doc->tokens;
+    uint32_t i = index + 1;
+    for (uint32_t n = 0; n < tokens[index].count; n++) {
+        const JsonDocument::Token& k = tokens[i];
+        bool match;
+        if (k.escaped) {
+            std::string unescaped;
+            unescape(doc->data + k.start, doc->data + k.end, unescaped);
+            match = (unescaped == key);
+        } else {
+            match = (k.end - k.start == key_len) && memcmp(doc->data + k.start, key, key_len) == 0;
+        }
+        if (match) {
+            return JsonValue(doc, i + 1, tokens[index].next, true);
+        }
+        i = tokens[i + 1].next;
+    }
+    return JsonValue();
+}
+
+JsonValue JsonValue::at(size_t i) const {
+    if (type() != JSON_ARRAY || i >= doc->tokens[index].count) {
+        return JsonValue();
+    }
+    uint32_t idx = index + 1;
+    while (i-- > 0) {
+        idx = doc->tokens[idx].next;
+    }
+    return JsonValue(doc, idx, doc->tokens[index].next, false);
+}
+
+const char* JsonValue::rawData() const {
+    if (!valid()) {
+        return "";
+    }
+    return doc->data + doc->tokens[index].start;
+}
+
+size_t JsonValue::rawSize() const {
+    if (!valid()) {
+        return 0;
+    }
+    const JsonDocument::Token& tok = doc->tokens[index];
+    return tok.end - tok.start;
+}
+
+std::string JsonValue::asString(const std::string& def) const {
+    if (type() != JSON_STRING) {
+        return def;
+    }
+    const JsonDocument::Token& tok = doc->tokens[index];
+    std::string out;
+    if (tok.escaped) {
+        unescape(doc->data + tok.start, doc->data + tok.end, out);
+    } else {
+        out.assign(doc->data + tok.start, tok.end - tok.start);
+    }
+    return out;
+}
+
+long long JsonValue::asInt(long long def) const {
+    if (type() != JSON_NUMBER) {
+        return def;
+    }
+    // 数字后面一定跟着分隔符或缓冲区结尾，不会越界读取
+    char buf[32];
+    size_t len = rawSize();
+    if (len >= sizeof(buf)) {
+        return def;
+    }
+    memcpy(buf, rawData(), len);
+    buf[len] = '\0';
+    if (strpbrk(buf, ".eE")) {
+        return (long long)strtod(buf, nullptr);
+    }
+    return strtoll(buf, nullptr, 10);
+}
+
+double JsonValue::asDouble(double def) const {
+    if (type() != JSON_NUMBER) {
+        return def;
+    }
+    char buf[64];
+    size_t len = rawSize();
+    if (len >= sizeof(buf)) {
+        return def;
+    }
+    memcpy(buf, rawData(), len);
+    buf[len] = '\0';
+    return strtod(buf, nullptr);
+}
+
+bool JsonValue::asBool(bool def) const {
+    JsonType t = type();
+    if (t == JSON_BOOL) {
+        return rawData()[0] == 't';
+    }
+    if (t == JSON_NUMBER) {
+        return asDouble() != 0;
+    }
+    return def;
+}
+
+bool JsonValue::toText(std::string& out) const {
+    switch (type()) {
+    case JSON_STRING:
+        out = asString();
+        return true;
+    case JSON_NUMBER:
+        out.assign(rawData(), rawSize());
+        return true;
+    case JSON_BOOL:
+        out = asBool() ? "1" : "0";
+        return true;
+    default:
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// JsonWriter
+// ---------------------------------------------------------------------------
+
+void JsonWriter::clear() {
+    buffer.clear();
+    scopes.clear();
+    after_key = false;
+}
+
+void JsonWriter::separator() {
+    if (after_key) {
+        after_key = false;
+        return;
+    }
+    if (!scopes.empty()) {
+        if (scopes.back()) {
+            buffer += ',';
+        }
+        scopes.back() = true;
+    }
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    separator();
+    buffer += '{';
+    scopes.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    buffer += '}';
+    if (!scopes.empty()) {
+        scopes.pop_back();
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    separator();
+    buffer += '[';
+    scopes.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    buffer += ']';
+    if (!scopes.empty()) {
+        scopes.pop_back();
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const char* name) {
+    separator();
+    escape(buffer, name, strlen(name));
+    buffer += ": ";
+    after_key = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const std::string& str) {
+    separator();
+    escape(buffer, str.data(), str.size());
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* str) {
+    if (!str) {
+        return null();
+    }
+    separator();
+    escape(buffer, str, strlen(str));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(int number) {
+    return value((long long)number);
+}
+
+JsonWriter& JsonWriter::value(unsigned int number) {
+    return value((uint64_t)number);
+}
+
+// 整数转十进制文本，比 snprintf 快得多（序列化时整数字段占大多数）
+static void append_uint(std::string& out, unsigned long long number, bool negative) {
+    char buf[24];
+    char* p = buf + sizeof(buf);
+    do {
+        *--p = (char)('0' + number % 10);
+        number /= 10;
+    } while (number != 0);
+    if (negative) {
+        *--p = '-';
+    }
+    out.append(p, buf + sizeof(buf) - p);
+}
+
+JsonWriter& JsonWriter::value(long long number) {
+    separator();
+    if (number < 0) {
+        append_uint(buffer, 0ULL - (unsigned long long)number, true);
+    } else {
+        append_uint(buffer, (unsigned long long)number, false);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(uint64_t number) {
+    separator();
+    append_uint(buffer, number, false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    // JSON 不支持 NaN 和无穷大
+    if (!std::isfinite(number)) {
+        return null();
+    }
+    separator();
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "%.6g", number);
+    buffer.append(buf, len);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    separator();
+    buffer += flag ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separator();
+    buffer += "null";
+    return *this;
+}
+
+JsonWriter& JsonWriter::raw(const std::string& json) {
+    separator();
+    buffer += json;
+    return *this;
+}
+
+void JsonWriter::escape(std::string& out, const char* str, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    const char* end = str + len;
+    while (str < end) {
+        // 连续的普通字符整段追加
+        const char* run = str;
+        while (str < end && (unsigned char)*str >= 0x20 && *str != '"' && *str != '\\') {
+            str++;
+        }
+        out.append(run, str - run);
+        if (str >= end) {
+            break;
+        }
+        char c = *str++;
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b";  break;
+        case '\f': out += "\\f";  break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            out += "\\u00";
+            out += hex[(c >> 4) & 0xF];
+            out += hex[c & 0xF];
+            break;
+        }
+    }
+    out += '"';
+}
+
+std::string JsonWriter::error(const std::string& message) {
+    JsonWriter writer;
+    writer.beginObject().member("error", message).endObject();
+    return writer.take();
+}
@@ -0,0 +1,172 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// 轻量 JSON 解析与序列化
+//
+// JsonDocument 在原始请求体上就地解析：只生成一个扁平的 token 数组记录各个值的位置，
+// 不复制字符串，读取字符串值时才按需反转义。解析期间原始缓冲区必须保持有效。
+// JsonWriter 向可复用的缓冲区追加输出，自动处理逗号和字符串转义。
+
+enum JsonType {
+    JSON_INVALID = 0,
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT,
+};
+
+class JsonDocument;
+
+// 指向文档中某个值的轻量句柄，可以按值传递
+class JsonValue {
+public:
+    JsonValue() : doc(nullptr), index(0), limit(0), member(false) {}
+
+    JsonType type() const;
+    bool valid() const { return type() != JSON_INVALID; }
+    bool isNull() const { return type() == JSON_NULL; }
+    bool isBool() const { return type() == JSON_BOOL; }
+    bool isNumber() const { return type() == JSON_NUMBER; }
+    bool isString() const { return type() == JSON_STRING; }
+    bool isArray() const { return type() == JSON_ARRAY; }
+    bool isObject() const { return type() == JSON_OBJECT; }
+
+    // 数组元素个数或对象成员个数
+    size_t size() const;
+
+    // 对象成员查找，不存在时返回无效值
+    JsonValue operator[](const char* key) const;
+
+    // 数组元素，越界时返回无效值
+    JsonValue at(size_t i) const;
+
+    // 遍历数组元素或对象成员：first() 得到第一个子值，next() 得到下一个兄弟值
+    // 对象成员的 key 通过 key() 获取
+    JsonValue first() const;
+    JsonValue next() const;
+    std::string key() const;
+
+    // 标量取值，类型不匹配时返回默认值
+    std::string asString(const std::string& def = "") const;
+    long long asInt(long long def = 0) const;
+    double asDouble(double def = 0) const;
+    bool asBool(bool def = false) const;
+
+    // 标量的文本形式：字符串为反转义后的内容，数字为原文，布尔值为 "1"/"0"
+    // 用于写入 ini 参数，数组和对象返回 false
+    bool toText(std::string& out) const;
+
+    // 值在原始缓冲区中的文本（字符串不含引号，未反转义）
+    const char* rawData() const;
+    size_t rawSize() const;
+
+private:
+    friend class JsonDocument;
+    JsonValue(const JsonDocument* doc, uint32_t index, uint32_t limit = 0, bool member = false)
+        : doc(doc), index(index), limit(limit), member(member) {}
+
+    const JsonDocument* doc;
+    uint32_t index;
+    uint32_t limit;     // 遍历时父节点子树的结尾，用于 next() 判断是否还有兄弟节点
+    bool member;        // 是否为对象成员（前一个 token 为 key）
+};
+
+class JsonDocument {
+public:
+    JsonDocument();
+
+    // 解析 JSON 文本，失败时通过 error()/errorOffset() 获取原因
+    bool parse(const char* data, size_t size);
+    bool parse(const std::string& text) { return parse(text.data(), text.size()); }
+
+    JsonValue root() const;
+
+    const char* error() const { return error_msg; }
+    size_t errorOffset() const { return error_offset; }
+
+private:
+    friend class JsonValue;
+
+    struct Token {
+        uint8_t type;
+        bool escaped;       // 字符串中含有转义字符
+        uint32_t start;     // 值在缓冲区中的起止位置（字符串不含引号）
+        uint32_t end;
+        uint32_t count;     // 数组元素个数或对象成员个数
+        uint32_t next;      // 整个子树之后的下一个 token 下标
+    };
+
+    bool parseValue(int depth);
+    bool parseString();
+    bool parseNumber();
+    bool parseLiteral(const char* word, uint8_t type);
+    void skipSpace();
+    bool fail(const char* msg);
+
+    const char* data;
+    size_t size;
+    size_t pos;
+    std::vector<Token> tokens;
+    const char* error_msg;
+    size_t error_offset;
+};
+
+// JSON 序列化器，输出格式与现有接口一致："key": value，元素之间用逗号分隔
+class JsonWriter {
+public:
+    JsonWriter() {}
+
+    // 清空内容但保留已分配的缓冲区，便于重复使用
+    void clear();
+    void reserve(size_t size) { buffer.reserve(size); }
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    // 对象成员的 key，后面必须紧跟一个值
+    JsonWriter& key(const char* name);
+
+    JsonWriter& value(const std::string& str);
+    JsonWriter& value(const char* str);
+    JsonWriter& value(int number);
+    JsonWriter& value(unsigned int number);
+    JsonWriter& value(long long number);
+    JsonWriter& value(uint64_t number);
+    JsonWriter& value(double number);
+    JsonWriter& value(bool flag);
+    JsonWriter& null();
+
+    // 追加已经序列化好的 JSON 值
+    JsonWriter& raw(const std::string& json);
+
+    // 常用的 key/value 组合
+    template <typename T>
+    JsonWriter& member(const char* name, const T& v) { return key(name).value(v); }
+
+    const std::string& str() const { return buffer; }
+    std::string take() { std::string out; out.swap(buffer); scopes.clear(); after_key = false; return out; }
+
+    // 将字符串转义后追加到 out（含两侧引号）
+    static void escape(std::string& out, const char* str, size_t len);
+
+    // 生成 {"error": "..."} 格式的错误信息
+    static std::string error(const std::string& message);
+
+private:
+    void separator();
+
+    std::string buffer;
+    std::vector<uint8_t> scopes;    // 每层是否已写入过元素
+    bool after_key = false;
+};
+
+#endif // JSON_H
@@ -0,0 +1,139 @@
+#include "alarm_history.h"
+#include "json.h"
+#include <chrono>
+#include <algorithm>
+#include <ctime>
+
+AlarmHistory::AlarmHistory(size_t capacity) : slots(std::max<size_t>(capacity, 1)), next_seq(1) {
+}
+
+void AlarmHistory::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    slots.assign(std::max<size_t>(capacity, 1), AlarmHistoryEntry());
+    next_seq = 1;
+}
+
+std::string AlarmHistory::serialize(uint64_t seq, const AlarmEvent& alarm, const std::string& snapshot_id) {
+    // 格式化时间戳
+    auto time_t_timestamp = std::chrono::system_clock::to_time_t(alarm.timestamp);
+    struct tm tm_timestamp;
+    localtime_r(&time_t_timestamp, &tm_timestamp);
+    
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm_timestamp);
+    
+    JsonWriter json;
+    json.reserve(320);
+    json.beginObject();
+    json.member("seq", seq);
+    json.member("timestamp", timestamp);
+    json.member("roi_id", alarm.roi_id);
+    json.member("roi_name", alarm.roiName());
+    json.member("group_id", alarm.group_id);
+    json.member("group_name", alarm.groupName());
+    json.member("track_id", alarm.track_id);
+    json.member("class_id", alarm.class_id);
+    json.member("class_name", alarm.className());
+    json.member("confidence", alarm.confidence);
+    json.key("box").beginObject();
+    json.member("x", alarm.box.x);
+    json.member("y", alarm.box.y);
+    json.member("width", alarm.box.width);
+    json.member("height", alarm.box.height);
+    json.endObject();
+    if (snapshot_id.empty()) {
+        json.key("snapshot_id").null();
+    } else {
+        json.member("snapshot_id", snapshot_id);
+    }
+    json.endObject();
+    
+    return json.take();
+}
+
+AlarmHistoryEntry AlarmHistory::push(const AlarmEvent& alarm, const std::string& snapshot_id) {
+    // 序号在锁内分配，序列化在锁外完成，避免阻塞查询
+    AlarmHistoryEntry entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entry.seq = next_seq++;
+    }
+    entry.json = std::make_shared<const std::string>(serialize(entry.seq, alarm, snapshot_id));
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    // 在序列化期间被 setCapacity 重置，丢弃本条记录
+    if (entry.seq >= next_seq) {
+        return entry;
+    }
+    AlarmHistoryEntry& slot = slots[(entry.seq - 1) % slots.size()];
+    // 并发插入时槽位可能已被更新的记录占用
+    if (slot.seq < entry.seq) {
+        slot = entry;
+    }
+    return entry;
+}
+
+uint64_t AlarmHistory::firstSeqLocked() const {
+    uint64_t count = std::min<uint64_t>(next_seq - 1, slots.size());
+    return next_seq - count;
+}
+
+void AlarmHistory::collectLocked(uint64_t from, uint64_t to, std::vector<AlarmHistoryEntry>& out) const {
+    out.reserve(to >= from ? to - from + 1 : 0);
+    for (uint64_t seq = from; seq <= to; ++seq) {
+        const AlarmHistoryEntry& slot = slots[(seq - 1) % slots.size()];
+        // 跳过尚未完成序列化的槽位
+        if (slot.seq == seq && slot.json) {
+            out.push_back(slot);
+        }
+    }
+}
+
+std::vector<AlarmHistoryEntry> AlarmHistory::since(uint64_t since, size_t limit, bool* has_more) {
+    std::vector<AlarmHistoryEntry> out;
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    uint64_t first = std::max(since + 1, firstSeqLocked());
+    uint64_t last = next_seq - 1;
+    if (limit > 0 && last >= first && last - first + 1 > limit) {
+        last = first + limit - 1;
+    }
+    if (has_more) {
+        *has_more = last < next_seq - 1;
+    }
+    collectLocked(first, last, out);
+    return out;
+}
+
+std::vector<AlarmHistoryEntry> AlarmHistory::latest(size_t limit) {
+    std::vector<AlarmHistoryEntry> out;
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    uint64_t first = firstSeqLocked();
+    uint64_t last = next_seq - 1;
+    if (limit > 0 && last >= first && last - first + 1 > limit) {
+        first = last - limit + 1;
+    }
+    collectLocked(first, last, out);
+    return out;
+}
+
+uint64_t AlarmHistory::firstSeq() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return firstSeqLocked();
+}
+
+uint64_t AlarmHistory::lastSeq() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return next_seq - 1;
+}
+
+size_t AlarmHistory::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return next_seq - firstSeqLocked();
+}
+
+size_t AlarmHistory::capacity() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return slots.size();
+}
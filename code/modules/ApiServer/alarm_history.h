@@ -0,0 +1,56 @@
+#ifndef ALARM_HISTORY_H
+#define ALARM_HISTORY_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include "../Video/roi_detector.h"
+
+// 告警历史记录（插入时序列化一次，之后只读）
+struct AlarmHistoryEntry {
+    uint64_t seq = 0;                           // 单调递增的序号，从1开始
+    std::shared_ptr<const std::string> json;    // 预先序列化好的 JSON 对象
+};
+
+// 固定容量的告警历史环形缓冲区
+// 插入为 O(1)，写满后覆盖最旧的记录；序号 seq 所在槽位为 (seq - 1) % capacity
+class AlarmHistory {
+public:
+    explicit AlarmHistory(size_t capacity = 100);
+
+    // 重新设置容量，已有记录会被清空（只在启动时调用）
+    void setCapacity(size_t capacity);
+
+    // 添加一条告警记录，返回分配的序号和序列化结果
+    AlarmHistoryEntry push(const AlarmEvent& alarm, const std::string& snapshot_id);
+
+    // 获取序号大于 since 的记录（按序号升序），最多 limit 条
+    // has_more 表示 limit 之后是否还有更新的记录
+    std::vector<AlarmHistoryEntry> since(uint64_t since, size_t limit, bool* has_more = nullptr);
+
+    // 获取最新的 limit 条记录（按序号升序）
+    std::vector<AlarmHistoryEntry> latest(size_t limit);
+
+    // 当前缓冲区内最旧/最新记录的序号，为空时 first > last
+    uint64_t firstSeq();
+    uint64_t lastSeq();
+
+    size_t size();
+    size_t capacity();
+
+private:
+    // 序列化单条告警为 JSON 对象
+    static std::string serialize(uint64_t seq, const AlarmEvent& alarm, const std::string& snapshot_id);
+
+    // 以下函数需持有 mutex
+    uint64_t firstSeqLocked() const;
+    void collectLocked(uint64_t from, uint64_t to, std::vector<AlarmHistoryEntry>& out) const;
+
+    std::vector<AlarmHistoryEntry> slots;
+    uint64_t next_seq;
+    std::mutex mutex;
+};
+
+#endif // ALARM_HISTORY_H
@@ -1,24 +1,26 @@
 #include "api_server.h"
-#include <sstream>
-#include <iomanip>
 #include <chrono>
+#include <cerrno>
 #include "log.h"
 #include "param.h"
+#include "param_snapshot.h"
+#include "SignalExecutor.h"
+#include "../Video/latency_tracer.h"
+#include "../Video/rate_controller.h"
 #include <sys/sysinfo.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 // 初始化全局 API 服务器实例
 ApiServer g_api_server;
 
-AlarmHistoryEntry::AlarmHistoryEntry(const AlarmInfo& alarm_info) : info(alarm_info) {
-    // 格式化时间戳
-    auto time_t_timestamp = std::chrono::system_clock::to_time_t(info.timestamp);
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t_timestamp), "%Y-%m-%d %H:%M:%S");
-    timestamp_str = ss.str();
-}
+// SSE 和 MJPEG 客户端占满上限时，仍保留给普通请求的工作线程数
+static const size_t kRequestWorkers = 4;
 
 ApiServer::ApiServer(int port) : port(port), running(false), roi_detector(nullptr), api_key(""),
-                               control(nullptr), led_module(nullptr), pantilt(nullptr) {
+                               sse_queue_size(64), sse_max_clients(4), snapshot_thumbnail(false),
+                               control(nullptr), led_module(nullptr), pantilt(nullptr),
+                               preview_cache(nullptr), mjpeg_clients(0), mjpeg_max_clients(2) {
 }
 
 ApiServer::~ApiServer() {
@@ -31,14 +33,39 @@ bool ApiServer::start() {
         return false;
     }
     
+    // 取值范围由参数表校验（见 param_schema.h）
+    ParamSnapshotPtr config = rk_param_snapshot();
+    
+    // 初始化告警历史记录
+    alarm_history.setCapacity(config->get(param_key::api_alarm_history_size));
+    
+    // 事件推送参数（每个 SSE 客户端长期占用一个 HTTP 工作线程，需限制数量）
+    sse_queue_size = config->get(param_key::api_sse_queue_size);
+    sse_max_clients = config->get(param_key::api_sse_max_clients);
+    mjpeg_max_clients = config->get(param_key::api_mjpeg_max_clients);
+    
+    // 初始化告警截图存储
+    std::string snapshot_dir = config->get(param_key::api_snapshot_dir);
+    int snapshot_max_kb = config->get(param_key::api_snapshot_max_kb);
+    snapshot_thumbnail = config->get(param_key::api_snapshot_thumbnail);
+    if (!snapshot_store.init(snapshot_dir, (size_t)snapshot_max_kb * 1024)) {
+        LOG_WARN("Snapshot store unavailable, alarm snapshots will not be kept\n");
+    }
+    
     // 创建 HTTP 服务器实例
+    // SSE 和 MJPEG 客户端长期占用工作线程，线程池按客户端上限扩容，另保留普通请求使用的线程
     server = std::make_unique<httplib::Server>();
+    size_t pool_size = std::max((size_t)CPPHTTPLIB_THREAD_POOL_COUNT,
+                                sse_max_clients + mjpeg_max_clients + kRequestWorkers);
+    server->new_task_queue = [pool_size] { return new httplib::ThreadPool(pool_size); };
+    LOG_INFO("API server: %zu worker threads\n", pool_size);
     
     // 初始化路由
     initRoutes();
     
-    // 启动服务器线程
+    // 启动服务器线程和告警处理线程
     running = true;
+    alarm_thread = std::thread(&ApiServer::alarmThread, this);
     server_thread = std::thread([this]() {
         LOG_INFO("Starting API server on port %d\n", port);
         server->listen("0.0.0.0", port);
@@ -54,42 +81,131 @@ void ApiServer::stop() {
     
     LOG_INFO("Stopping API server\n");
     
-    // 停止 HTTP 服务器
-    running = false;
+    // 停止 HTTP 服务器，先关闭事件订阅以唤醒阻塞中的 SSE 连接
+    {
+        std::lock_guard<std::mutex> lock(alarm_mutex);
+        running = false;
+    }
+    alarm_cv.notify_all();
+    event_hub.closeAll();
     if (server) {
         server->stop();
     }
     
-    // 等待服务器线程结束
+    // 等待服务器线程和告警处理线程结束
     if (server_thread.joinable()) {
         server_thread.join();
     }
+    if (alarm_thread.joinable()) {
+        alarm_thread.join();
+    }
     
     LOG_INFO("API server stopped\n");
 }
 
 void ApiServer::registerAlarmCallback() {
     if (roi_detector) {
-        roi_detector->registerAlarmCallback([this](const AlarmInfo& alarm) {
+        roi_detector->registerAlarmCallback([this](const AlarmEventPtr& alarm) {
             this->onAlarm(alarm);
         });
     }
 }
 
-void ApiServer::onAlarm(const AlarmInfo& alarm) {
-    // 记录告警到历史记录中
-    std::lock_guard<std::mutex> lock(alarm_history_mutex);
+void ApiServer::onAlarm(const AlarmEventPtr& alarm) {
+    if (!running) {
+        LOG_WARN("API server not running, alarm dropped\n");
+        return;
+    }
+    
+    // 添加告警到队列，缩略图编码和写盘在告警处理线程中完成
+    {
+        std::lock_guard<std::mutex> lock(alarm_mutex);
+        alarm_queue.push(alarm);
+    }
+    alarm_cv.notify_one();
+}
+
+void ApiServer::alarmThread() {
+    while (true) {
+        AlarmEventPtr alarm;
+        {
+            std::unique_lock<std::mutex> lock(alarm_mutex);
+            alarm_cv.wait(lock, [this]() {
+                return !alarm_queue.empty() || !running;
+            });
+            if (!running) {
+                break;
+            }
+            alarm = std::move(alarm_queue.front());
+            alarm_queue.pop();
+        }
+        processAlarm(alarm);
+    }
+}
+
+void ApiServer::processAlarm(const AlarmEventPtr& alarm) {
+    // 截图写入磁盘存储，历史记录中只保留截图ID
+    std::string snapshot_id;
+    if (!alarm->jpeg.empty()) {
+        std::vector<uchar> thumb;
+        if (snapshot_thumbnail) {
+            // 缩小到 1/4 后重新编码为缩略图（opencv-mobile 不支持按比例解码）
+            cv::Mat full = cv::imdecode(alarm->jpeg, cv::IMREAD_COLOR);
+            if (!full.empty()) {
+                cv::Mat small;
+                cv::resize(full, small, cv::Size(std::max(full.cols / 4, 1), std::max(full.rows / 4, 1)),
+                           0, 0, cv::INTER_AREA);
+                cv::imencode(".jpg", small, thumb, {cv::IMWRITE_JPEG_QUALITY, 70});
+            }
+        }
+        snapshot_id = snapshot_store.put(alarm->jpeg, thumb);
+    }
+    
+    // 记录告警到历史记录中（写满后覆盖最旧的记录）
+    AlarmHistoryEntry entry = alarm_history.push(*alarm, snapshot_id);
     
-    // 添加新的告警记录
-    alarm_history.emplace_back(alarm);
+    // 推送给事件订阅者，事件ID即历史记录序号，用于断线重连后续传
+    ServerEvent event;
+    event.id = entry.seq;
+    event.type = "alarm";
+    event.data = entry.json;
+    event_hub.publish(event);
     
-    // 如果历史记录超过最大数量，删除最旧的记录
-    if (alarm_history.size() > MAX_ALARM_HISTORY) {
-        alarm_history.erase(alarm_history.begin());
+    LOG_DEBUG("Added alarm to history, seq=%llu, class=%d(%s)\n",
+              (unsigned long long)entry.seq, alarm->class_id, alarm->className());
+}
+
+void ApiServer::onDetections(const DetectionSummaryPtr& summary) {
+    // 没有订阅检测摘要的客户端时不做序列化
+    if (!event_hub.hasDetectionSubscribers()) {
+        return;
     }
     
-    LOG_DEBUG("Added alarm to history, class=%d(%s), total history: %zu\n",
-              alarm.class_id, alarm.class_name.c_str(), alarm_history.size());
+    JsonWriter json;
+    json.beginObject();
+    json.member("frame", summary->frame_seq);
+    json.member("width", summary->width);
+    json.member("height", summary->height);
+    json.member("timestamp_ms", (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                    summary->timestamp.time_since_epoch()).count());
+    json.key("objects").beginArray();
+    for (const auto& obj : summary->objects) {
+        json.beginObject();
+        json.member("class_id", obj.class_id);
+        json.member("class_name", coco_cls_to_name(obj.class_id));
+        json.member("confidence", obj.confidence);
+        json.key("box").beginArray();
+        json.value(obj.box.x).value(obj.box.y).value(obj.box.width).value(obj.box.height);
+        json.endArray();
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+    
+    ServerEvent event;
+    event.type = "detection";
+    event.data = std::make_shared<const std::string>(json.take());
+    event_hub.publish(event, true);
 }
 
 bool ApiServer::validateApiKey(const httplib::Request& req, httplib::Response& res) {
@@ -159,6 +275,26 @@ void ApiServer::initRoutes() {
         }
     });
     
+    // 信号队列统计 API
+    server->Get("/api/system/signals", [this](const httplib::Request& req, httplib::Response& res) {
+        if (this->validateApiKey(req, res)) {
+            this->handleGetSignalStats(req, res);
+        }
+    });
+    
+    // 视频链路延迟 API
+    server->Get("/api/system/latency", [this](const httplib::Request& req, httplib::Response& res) {
+        if (this->validateApiKey(req, res)) {
+            this->handleGetLatencyStats(req, res);
+        }
+    });
+    
+    server->Post("/api/system/latency/reset", [this](const httplib::Request& req, httplib::Response& res) {
+        if (this->validateApiKey(req, res)) {
+            this->handleResetLatencyStats(req, res);
+        }
+    });
+    
     // 告警历史 API
     server->Get("/api/alarm/history", [this](const httplib::Request& req, httplib::Response& res) {
         if (this->validateApiKey(req, res)) {
@@ -166,6 +302,40 @@ void ApiServer::initRoutes() {
         }
     });
     
+    // 告警截图 API
+    server->Get(R"(/api/alarm/([0-9a-f]+)/snapshot)", [this](const httplib::Request& req, httplib::Response& res) {
+        if (this->validateApiKey(req, res)) {
+            this->handleGetAlarmSnapshot(req, res);
+        }
+    });
+    
+    // 视频预览 API（/api/video/snapshot 为兼容网页的别名）
+    server->Get(R"(/api/video/snapshot(\.jpg)?)", [this](const httplib::Request& req, httplib::Response& res) {
+        if (this->validateApiKey(req, res)) {
+            this->handleVideoSnapshot(req, res);
+        }
+    });
+    
+    server->Get("/api/video/mjpeg", [this](const httplib::Request& req, httplib::Response& res) {
+        if (this->validateApiKey(req, res)) {
+            this->handleVideoMjpeg(req, res);
+        }
+    });
+    
+    // 自适应码率状态 API
+    server->Get("/api/video/bitrate", [this](const httplib::Request& req, httplib::Response& res) {
+        if (this->validateApiKey(req, res)) {
+            this->handleGetBitrateStatus(req, res);
+        }
+    });
+    
+    // 事件推送 API（Server-Sent Events）
+    server->Get("/api/events", [this](const httplib::Request& req, httplib::Response& res) {
+        if (this->validateApiKey(req, res)) {
+            this->handleEvents(req, res);
+        }
+    });
+    
     // LED 控制 API
     server->Post("/api/led/control", [this](const httplib::Request& req, httplib::Response& res) {
         if (this->validateApiKey(req, res)) {
@@ -222,12 +392,20 @@ void ApiServer::initRoutes() {
             "<li><code>POST /api/roi/config</code> - Update ROI configuration</li>"
             "<li><code>POST /api/roi/reload</code> - Reload ROI configuration from file</li>"
             "<li><code>GET /api/system/status</code> - Get system status</li>"
-            "<li><code>GET /api/alarm/history</code> - Get alarm history</li>"
+            "<li><code>GET /api/system/signals</code> - Get signal queue depth, drop counters and executor overflow/slow-task counters</li>"
+            "<li><code>GET /api/system/latency</code> - Get per-stage video latency percentiles (<code>?recent=N</code> for per-frame traces)</li>"
+            "<li><code>POST /api/system/latency/reset</code> - Reset latency statistics</li>"
+            "<li><code>GET /api/alarm/history</code> - Get alarm history (<code>?since=&lt;seq&gt;&amp;limit=N</code>)</li>"
+            "<li><code>GET /api/alarm/{snapshot_id}/snapshot</code> - Get alarm snapshot (<code>?thumb=1</code> for thumbnail)</li>"
+            "<li><code>GET /api/video/snapshot.jpg</code> - Get a JPEG snapshot of the sub-stream</li>"
+            "<li><code>GET /api/video/mjpeg</code> - MJPEG preview of the sub-stream (<code>?fps=N</code>)</li>"
+            "<li><code>GET /api/video/bitrate</code> - Get adaptive bitrate targets, idle profile state and adaptation history of the RTSP streams</li>"
+            "<li><code>GET /api/events</code> - Server-Sent Events stream of alarms (<code>?detections=1</code> for detection summaries)</li>"
             "<li><code>POST /api/led/control</code> - Control LED</li>"
             "<li><code>POST /api/pantilt/control</code> - Control pan/tilt</li>"
             "<li><code>POST /api/video/control</code> - Control video streams</li>"
             "<li><code>GET /api/system/params</code> - Get system parameters</li>"
-            "<li><code>POST /api/system/params</code> - Set system parameters</li>"
+            "<li><code>POST /api/system/params</code> - Set system parameters (<code>{\"params\": {...}}</code> for an atomic batch)</li>"
             "</ul>"
             "<p>Authentication is required for all API endpoints. Please provide your API key using either:</p>"
             "<ul>"
@@ -252,32 +430,61 @@ void ApiServer::handleGetRoiConfig(const httplib::Request& req, httplib::Respons
     const auto& roi_groups = roi_detector->getRoiGroups();
     
     // 构建 JSON 响应
-    std::stringstream json;
-    json << "{";
+    JsonWriter json;
+    json.reserve(64 + roi_areas.size() * 220 + roi_groups.size() * 96);
+    json.beginObject();
     
     // ROI 区域
-    json << "\"roi_areas\": [";
-    for (size_t i = 0; i < roi_areas.size(); ++i) {
-        json << roiAreaToJson(roi_areas[i]);
-        if (i < roi_areas.size() - 1) {
-            json << ",";
-        }
+    json.key("roi_areas").beginArray();
+    for (const auto& roi : roi_areas) {
+        roiAreaToJson(json, roi);
     }
-    json << "],";
+    json.endArray();
     
     // ROI 组
-    json << "\"roi_groups\": [";
-    for (size_t i = 0; i < roi_groups.size(); ++i) {
-        json << roiGroupToJson(roi_groups[i]);
-        if (i < roi_groups.size() - 1) {
-            json << ",";
-        }
+    json.key("roi_groups").beginArray();
+    for (const auto& group : roi_groups) {
+        roiGroupToJson(json, group);
     }
-    json << "]";
+    json.endArray();
     
-    json << "}";
+    json.endObject();
     
-    res.set_content(json.str(), "application/json");
+    res.set_content(json.take(), "application/json");
+}
+
+// 解析请求体中的 JSON，失败时写入 400 响应
+static bool parseJsonBody(const httplib::Request& req, httplib::Response& res, JsonDocument& doc) {
+    if (req.body.empty()) {
+        res.status = 400;
+        res.set_content("{\"error\": \"Empty request body\"}", "application/json");
+        return false;
+    }
+    if (!doc.parse(req.body) || !doc.root().isObject()) {
+        res.status = 400;
+        std::string message = "Invalid JSON";
+        if (doc.error()) {
+            message += ": " + std::string(doc.error()) + " at offset " + std::to_string(doc.errorOffset());
+        }
+        res.set_content(JsonWriter::error(message), "application/json");
+        return false;
+    }
+    return true;
+}
+
+// 将整数数组转换为 ini 中使用的逗号分隔格式，含非整数元素时返回 false
+static bool joinIntArray(const JsonValue& array, std::string& out) {
+    out.clear();
+    for (JsonValue item = array.first(); item.valid(); item = item.next()) {
+        if (!item.isNumber()) {
+            return false;
+        }
+        if (!out.empty()) {
+            out += ",";
+        }
+        out += std::to_string(item.asInt());
+    }
+    return true;
 }
 
 void ApiServer::handleUpdateRoiConfig(const httplib::Request& req, httplib::Response& res) {
@@ -287,291 +494,127 @@ void ApiServer::handleUpdateRoiConfig(const httplib::Request& req, httplib::Resp
         return;
     }
     
-    if (req.body.empty()) {
+    JsonDocument doc;
+    if (!parseJsonBody(req, res, doc)) {
+        return;
+    }
+    JsonValue root = doc.root();
+    JsonValue roi_areas = root["roi_areas"];
+    JsonValue roi_groups = root["roi_groups"];
+    
+    if ((roi_areas.valid() && !roi_areas.isArray()) || (roi_groups.valid() && !roi_groups.isArray()) ||
+        (!roi_areas.valid() && !roi_groups.valid())) {
         res.status = 400;
-        res.set_content("{\"error\": \"Empty request body\"}", "application/json");
+        res.set_content("{\"error\": \"Invalid request format\"}", "application/json");
         return;
     }
     
-    // 解析 JSON 请求体
-    try {
-        // 这里我们使用简单的方式解析 JSON，未使用第三方 JSON 库
-        // 在实际项目中，建议使用 nlohmann/json 等库进行更健壮的解析
-        std::string config_file = rk_param_get_string("common:config_file", "ipc-terminal.ini");
-        bool success = false;
-        
-        // 解析 ROI 区域更新
-        if (req.body.find("\"roi_areas\"") != std::string::npos) {
-            std::string roi_areas_str = req.body.substr(req.body.find("\"roi_areas\""));
-            if (roi_areas_str.find('[') != std::string::npos && 
-                roi_areas_str.find(']') != std::string::npos) {
-                
-                // 提取数组内容
-                size_t start_pos = roi_areas_str.find('[');
-                size_t end_pos = roi_areas_str.find(']', start_pos);
-                std::string areas_array = roi_areas_str.substr(start_pos + 1, end_pos - start_pos - 1);
-                
-                // 处理每个 ROI 区域对象
-                size_t pos = 0;
-                size_t obj_start, obj_end;
-                int roi_count = 0;
-                
-                // 首先更新 ROI 区域的数量
-                while ((obj_start = areas_array.find('{', pos)) != std::string::npos) {
-                    obj_end = areas_array.find('}', obj_start);
-                    if (obj_end == std::string::npos) break;
-                    
-                    std::string roi_obj = areas_array.substr(obj_start, obj_end - obj_start + 1);
-                    roi_count++;
-                    pos = obj_end + 1;
-                }
-                
-                // 更新配置文件中的 ROI 数量
-                char value[16];
-                snprintf(value, sizeof(value), "%d", roi_count);
-                rk_param_set_string("ai.roi:count", value);
-                
-                // 现在处理每个 ROI 区域的内容
-                pos = 0;
-                int roi_index = 0;
-                while ((obj_start = areas_array.find('{', pos)) != std::string::npos) {
-                    obj_end = areas_array.find('}', obj_start);
-                    if (obj_end == std::string::npos) break;
-                    
-                    std::string roi_obj = areas_array.substr(obj_start, obj_end - obj_start + 1);
-                    
-                    // 解析 ROI 属性
-                    auto parseValue = [&](const std::string& key, const std::string& obj, bool is_string = false) -> std::string {
-                        std::string search = "\"" + key + "\":";
-                        size_t key_pos = obj.find(search);
-                        if (key_pos == std::string::npos) return "";
-                        
-                        size_t value_start = key_pos + search.length();
-                        // 跳过前导空格
-                        while (value_start < obj.length() && std::isspace(obj[value_start])) value_start++;
-                        
-                        if (is_string) {
-                            if (obj[value_start] != '"') return "";
-                            size_t value_end = obj.find('"', value_start + 1);
-                            if (value_end == std::string::npos) return "";
-                            return obj.substr(value_start + 1, value_end - value_start - 1);
-                        } else {
-                            size_t value_end = obj.find_first_of(",}", value_start);
-                            if (value_end == std::string::npos) return "";
-                            return obj.substr(value_start, value_end - value_start);
-                        }
-                    };
-                    
-                    // 解析基本属性
-                    std::string id = parseValue("id", roi_obj);
-                    std::string name = parseValue("name", roi_obj, true);
-                    std::string x = parseValue("x", roi_obj);
-                    std::string y = parseValue("y", roi_obj);
-                    std::string width = parseValue("width", roi_obj);
-                    std::string height = parseValue("height", roi_obj);
-                    std::string stay_time = parseValue("stay_time", roi_obj);
-                    std::string cooldown_time = parseValue("cooldown_time", roi_obj);
-                    std::string enabled = parseValue("enabled", roi_obj);
-                    std::string group_id = parseValue("group_id", roi_obj);
-                    
-                    // 解析类别数组
-                    std::string classes_str;
-                    size_t classes_start = roi_obj.find("\"classes\":");
-                    if (classes_start != std::string::npos) {
-                        size_t array_start = roi_obj.find('[', classes_start);
-                        size_t array_end = roi_obj.find(']', array_start);
-                        if (array_start != std::string::npos && array_end != std::string::npos) {
-                            classes_str = roi_obj.substr(array_start + 1, array_end - array_start - 1);
-                        }
-                    }
-                    
-                    // 更新配置文件
-                    char param_name[64];
-                    
-                    snprintf(param_name, sizeof(param_name), "ai.roi.%d:enabled", roi_index);
-                    rk_param_set_string(param_name, enabled.empty() ? "1" : enabled.c_str());
-                    
-                    if (!name.empty()) {
-                        snprintf(param_name, sizeof(param_name), "ai.roi.%d:name", roi_index);
-                        rk_param_set_string(param_name, name.c_str());
-                    }
-                    
-                    if (!x.empty()) {
-                        snprintf(param_name, sizeof(param_name), "ai.roi.%d:x", roi_index);
-                        rk_param_set_string(param_name, x.c_str());
-                    }
-                    
-                    if (!y.empty()) {
-                        snprintf(param_name, sizeof(param_name), "ai.roi.%d:y", roi_index);
-                        rk_param_set_string(param_name, y.c_str());
-                    }
-                    
-                    if (!width.empty()) {
-                        snprintf(param_name, sizeof(param_name), "ai.roi.%d:width", roi_index);
-                        rk_param_set_string(param_name, width.c_str());
-                    }
-                    
-                    if (!height.empty()) {
-                        snprintf(param_name, sizeof(param_name), "ai.roi.%d:height", roi_index);
-                        rk_param_set_string(param_name, height.c_str());
-                    }
-                    
-                    if (!stay_time.empty()) {
-                        snprintf(param_name, sizeof(param_name), "ai.roi.%d:stay_time", roi_index);
-                        rk_param_set_string(param_name, stay_time.c_str());
-                    }
-                    
-                    if (!cooldown_time.empty()) {
-                        snprintf(param_name, sizeof(param_name), "ai.roi.%d:cooldown_time", roi_index);
-                        rk_param_set_string(param_name, cooldown_time.c_str());
-                    }
-                    
-                    if (!classes_str.empty()) {
-                        snprintf(param_name, sizeof(param_name), "ai.roi.%d:classes", roi_index);
-                        rk_param_set_string(param_name, classes_str.c_str());
-                    }
-                    
-                    roi_index++;
-                    pos = obj_end + 1;
-                }
-                
-                success = true;
-            }
+    // 先校验全部内容，再写入参数，避免只更新了一半
+    std::vector<std::pair<std::string, std::string>> updates;
+    char param_name[64];
+    std::string text;
+    
+    // 标量字段原样写入 ini（布尔值转换为 1/0），值的内容由 rk_param_set_batch 统一校验
+    auto addField = [&](const char* section_fmt, int index, const JsonValue& obj, const char* key) -> bool {
+        JsonValue value = obj[key];
+        if (!value.valid() || value.isNull()) {
+            return true;
+        }
+        if (!value.toText(text)) {
+            return false;
+        }
+        snprintf(param_name, sizeof(param_name), section_fmt, index, key);
+        updates.emplace_back(param_name, text);
+        return true;
+    };
+    
+    auto addIntArray = [&](const char* section_fmt, int index, const JsonValue& obj,
+                           const char* key, const char* param_key) -> bool {
+        JsonValue value = obj[key];
+        if (!value.valid()) {
+            return true;
+        }
+        if (!value.isArray() || !joinIntArray(value, text)) {
+            return false;
         }
+        if (text.empty()) {
+            return true;
+        }
+        snprintf(param_name, sizeof(param_name), section_fmt, index, param_key);
+        updates.emplace_back(param_name, text);
+        return true;
+    };
+    
+    // ROI 区域
+    if (roi_areas.valid()) {
+        updates.emplace_back("ai.roi:count", std::to_string(roi_areas.size()));
         
-        // 解析 ROI 组更新
-        if (req.body.find("\"roi_groups\"") != std::string::npos) {
-            std::string roi_groups_str = req.body.substr(req.body.find("\"roi_groups\""));
-            if (roi_groups_str.find('[') != std::string::npos && 
-                roi_groups_str.find(']') != std::string::npos) {
-                
-                // 提取数组内容
-                size_t start_pos = roi_groups_str.find('[');
-                size_t end_pos = roi_groups_str.find(']', start_pos);
-                std::string groups_array = roi_groups_str.substr(start_pos + 1, end_pos - start_pos - 1);
-                
-                // 处理每个 ROI 组对象
-                size_t pos = 0;
-                size_t obj_start, obj_end;
-                int group_index = 0;
-                
-                // 首先更新 ROI 组的数量
-                while ((obj_start = groups_array.find('{', pos)) != std::string::npos) {
-                    obj_end = groups_array.find('}', obj_start);
-                    if (obj_end == std::string::npos) break;
-                    
-                    std::string group_obj = groups_array.substr(obj_start, obj_end - obj_start + 1);
-                    group_index++;
-                    pos = obj_end + 1;
-                }
-                
-                // 更新配置文件中的 ROI 组数量
-                char value[16];
-                snprintf(value, sizeof(value), "%d", group_index);
-                rk_param_set_string("ai.roi.group:count", value);
-                
-                // 现在处理每个 ROI 组的内容
-                pos = 0;
-                group_index = 0;
-                while ((obj_start = groups_array.find('{', pos)) != std::string::npos) {
-                    obj_end = groups_array.find('}', obj_start);
-                    if (obj_end == std::string::npos) break;
-                    
-                    std::string group_obj = groups_array.substr(obj_start, obj_end - obj_start + 1);
-                    
-                    // 解析 ROI 组属性
-                    auto parseValue = [&](const std::string& key, const std::string& obj, bool is_string = false) -> std::string {
-                        std::string search = "\"" + key + "\":";
-                        size_t key_pos = obj.find(search);
-                        if (key_pos == std::string::npos) return "";
-                        
-                        size_t value_start = key_pos + search.length();
-                        // 跳过前导空格
-                        while (value_start < obj.length() && std::isspace(obj[value_start])) value_start++;
-                        
-                        if (is_string) {
-                            if (obj[value_start] != '"') return "";
-                            size_t value_end = obj.find('"', value_start + 1);
-                            if (value_end == std::string::npos) return "";
-                            return obj.substr(value_start + 1, value_end - value_start - 1);
-                        } else {
-                            size_t value_end = obj.find_first_of(",}", value_start);
-                            if (value_end == std::string::npos) return "";
-                            return obj.substr(value_start, value_end - value_start);
-                        }
-                    };
-                    
-                    // 解析基本属性
-                    std::string id = parseValue("id", group_obj);
-                    std::string name = parseValue("name", group_obj, true);
-                    
-                    // 解析类别数组
-                    std::string classes_str;
-                    size_t classes_start = group_obj.find("\"classes\":");
-                    if (classes_start != std::string::npos) {
-                        size_t array_start = group_obj.find('[', classes_start);
-                        size_t array_end = group_obj.find(']', array_start);
-                        if (array_start != std::string::npos && array_end != std::string::npos) {
-                            classes_str = group_obj.substr(array_start + 1, array_end - array_start - 1);
-                        }
-                    }
-                    
-                    // 解析 ROI ID 数组
-                    std::string roi_ids_str;
-                    size_t roi_ids_start = group_obj.find("\"roi_ids\":");
-                    if (roi_ids_start != std::string::npos) {
-                        size_t array_start = group_obj.find('[', roi_ids_start);
-                        size_t array_end = group_obj.find(']', array_start);
-                        if (array_start != std::string::npos && array_end != std::string::npos) {
-                            roi_ids_str = group_obj.substr(array_start + 1, array_end - array_start - 1);
-                        }
-                    }
-                    
-                    // 更新配置文件
-                    char param_name[64];
-                    
-                    if (!name.empty()) {
-                        snprintf(param_name, sizeof(param_name), "ai.roi.group.%d:name", group_index);
-                        rk_param_set_string(param_name, name.c_str());
-                    }
-                    
-                    if (!classes_str.empty()) {
-                        snprintf(param_name, sizeof(param_name), "ai.roi.group.%d:classes", group_index);
-                        rk_param_set_string(param_name, classes_str.c_str());
-                    }
-                    
-                    if (!roi_ids_str.empty()) {
-                        snprintf(param_name, sizeof(param_name), "ai.roi.group.%d:rois", group_index);
-                        rk_param_set_string(param_name, roi_ids_str.c_str());
-                    }
-                    
-                    group_index++;
-                    pos = obj_end + 1;
-                }
-                
-                success = true;
+        int roi_index = 0;
+        for (JsonValue roi = roi_areas.first(); roi.valid(); roi = roi.next(), roi_index++) {
+            if (!roi.isObject()) {
+                res.status = 400;
+                res.set_content(JsonWriter::error("roi_areas[" + std::to_string(roi_index) + "] must be an object"),
+                                "application/json");
+                return;
+            }
+            
+            // 未指定 enabled 时默认启用
+            if (!roi["enabled"].valid()) {
+                snprintf(param_name, sizeof(param_name), "ai.roi.%d:enabled", roi_index);
+                updates.emplace_back(param_name, "1");
+            }
+            
+            static const char* fields[] = {"enabled", "name", "x", "y", "width", "height", "stay_time", "cooldown_time"};
+            bool ok = true;
+            for (const char* field : fields) {
+                ok = ok && addField("ai.roi.%d:%s", roi_index, roi, field);
+            }
+            ok = ok && addIntArray("ai.roi.%d:%s", roi_index, roi, "classes", "classes");
+            if (!ok) {
+                res.status = 400;
+                res.set_content(JsonWriter::error("Invalid field in roi_areas[" + std::to_string(roi_index) + "]"),
+                                "application/json");
+                return;
             }
         }
+    }
+    
+    // ROI 组
+    if (roi_groups.valid()) {
+        updates.emplace_back("ai.roi:groups", std::to_string(roi_groups.size()));
         
-        // 保存配置文件
-        rk_param_save();
-        
-        if (success) {
-            // 重新加载配置
-            bool reload_success = roi_detector->reloadConfig();
-            if (reload_success) {
-                res.set_content("{\"message\": \"Configuration updated and reloaded successfully\"}", "application/json");
-            } else {
-                res.status = 500;
-                res.set_content("{\"error\": \"Configuration updated but failed to reload\"}", "application/json");
+        int group_index = 0;
+        for (JsonValue group = roi_groups.first(); group.valid(); group = group.next(), group_index++) {
+            bool ok = group.isObject() &&
+                      addField("ai.roi.group.%d:%s", group_index, group, "name") &&
+                      addIntArray("ai.roi.group.%d:%s", group_index, group, "classes", "classes") &&
+                      addIntArray("ai.roi.group.%d:%s", group_index, group, "roi_ids", "rois");
+            if (!ok) {
+                res.status = 400;
+                res.set_content(JsonWriter::error("Invalid field in roi_groups[" + std::to_string(group_index) + "]"),
+                                "application/json");
+                return;
             }
-        } else {
-            res.status = 400;
-            res.set_content("{\"error\": \"Invalid request format\"}", "application/json");
         }
-    } catch (const std::exception& e) {
+    }
+    
+    // 一次性写入全部参数，配置文件延迟合并保存
+    int ret = rk_param_set_batch(updates, RK_PARAM_SAVE_DEFERRED);
+    if (ret != 0) {
+        res.status = (ret == -EINVAL) ? 400 : 500;
+        res.set_content(ret == -EINVAL ? "{\"error\": \"Invalid parameter value\"}"
+                                       : "{\"error\": \"Failed to update configuration\"}",
+                        "application/json");
+        return;
+    }
+    
+    // 重新加载配置
+    bool reload_success = roi_detector->reloadConfig();
+    if (reload_success) {
+        res.set_content("{\"message\": \"Configuration updated and reloaded successfully\"}", "application/json");
+    } else {
         res.status = 500;
-        res.set_content("{\"error\": \"Exception occurred: " + std::string(e.what()) + "\"}", "application/json");
+        res.set_content("{\"error\": \"Configuration updated but failed to reload\"}", "application/json");
     }
 }
 
@@ -619,110 +662,491 @@ void ApiServer::handleGetSystemStatus(const httplib::Request& req, httplib::Resp
     int uptime_seconds = info.uptime % 60;
     
     // 获取告警数量
-    size_t alarm_count = 0;
-    {
-        std::lock_guard<std::mutex> lock(alarm_history_mutex);
-        alarm_count = alarm_history.size();
-    }
+    size_t alarm_count = alarm_history.size();
     
     // 构建 JSON 响应
-    std::stringstream json;
-    json << "{";
-    json << "\"memory\": {";
-    json << "\"total\": " << total_ram << ",";
-    json << "\"free\": " << free_ram << ",";
-    json << "\"used\": " << used_ram << ",";
-    json << "\"usage_percent\": " << ram_usage;
-    json << "},";
-    
-    json << "\"load\": {";
-    json << "\"1min\": " << load_1 << ",";
-    json << "\"5min\": " << load_5 << ",";
-    json << "\"15min\": " << load_15;
-    json << "},";
-    
-    json << "\"uptime\": {";
-    json << "\"days\": " << uptime_days << ",";
-    json << "\"hours\": " << uptime_hours << ",";
-    json << "\"minutes\": " << uptime_minutes << ",";
-    json << "\"seconds\": " << uptime_seconds << ",";
-    json << "\"total_seconds\": " << info.uptime;
-    json << "},";
-    
-    json << "\"alarm_count\": " << alarm_count;
-    
-    json << "}";
-    
-    res.set_content(json.str(), "application/json");
+    JsonWriter json;
+    json.beginObject();
+    
+    json.key("memory").beginObject();
+    json.member("total", (long long)total_ram);
+    json.member("free", (long long)free_ram);
+    json.member("used", (long long)used_ram);
+    json.member("usage_percent", ram_usage);
+    json.endObject();
+    
+    json.key("load").beginObject();
+    json.member("1min", load_1);
+    json.member("5min", load_5);
+    json.member("15min", load_15);
+    json.endObject();
+    
+    json.key("uptime").beginObject();
+    json.member("days", uptime_days);
+    json.member("hours", uptime_hours);
+    json.member("minutes", uptime_minutes);
+    json.member("seconds", uptime_seconds);
+    json.member("total_seconds", (long long)info.uptime);
+    json.endObject();
+    
+    json.member("alarm_count", (uint64_t)alarm_count);
+    
+    json.endObject();
+    
+    res.set_content(json.take(), "application/json");
+}
+
+void ApiServer::handleGetSignalStats(const httplib::Request& req, httplib::Response& res) {
+    JsonWriter json;
+    json.beginObject();
+    
+    // 执行器中各优先级队列的当前深度、溢出和等待次数、慢事件统计
+    SignalExecutor& executor = SignalExecutor::instance();
+    json.key("executor").beginObject();
+    for (size_t i = 0; i < (size_t)SignalPriority::Count; i++) {
+        SignalPriority priority = (SignalPriority)i;
+        json.key(signalPriorityName(priority)).beginObject();
+        json.member("depth", (uint64_t)executor.queueDepth(priority));
+        json.member("overflowed", executor.overflowed(priority));
+        json.member("producer_waits", executor.producerWaits(priority));
+        json.member("slow_tasks", executor.slowTasks(priority));
+        json.member("max_task_us", executor.maxTaskUs(priority));
+        json.endObject();
+    }
+    json.endObject();
+    
+    json.key("signals").beginArray();
+    for (const auto& stats : SignalRegistry::instance().list()) {
+        json.beginObject();
+        json.member("name", stats->name);
+        json.member("priority", signalPriorityName(stats->priority));
+        json.member("connections", (unsigned int)stats->connections.load());
+        json.member("pending", (unsigned int)stats->pending.load());
+        json.member("max_pending", (unsigned int)stats->max_pending.load());
+        json.member("emitted", (uint64_t)stats->emitted.load());
+        json.member("delivered", (uint64_t)stats->delivered.load());
+        json.member("dropped", (uint64_t)stats->dropped.load());
+        json.endObject();
+    }
+    json.endArray();
+    
+    json.endObject();
+    res.set_content(json.take(), "application/json");
+}
+
+static void writeLatencyPercentiles(JsonWriter& json, const char* name, const LatencyPercentiles& value) {
+    json.key(name).beginObject();
+    json.member("count", value.count);
+    json.member("p50_us", value.p50);
+    json.member("p95_us", value.p95);
+    json.member("p99_us", value.p99);
+    json.member("max_us", value.max);
+    json.endObject();
+}
+
+void ApiServer::handleGetLatencyStats(const httplib::Request& req, httplib::Response& res) {
+    // 可选参数：recent=N 附带最近 N 帧的逐阶段时间（默认 16）
+    size_t recent = 16;
+    if (req.has_param("recent")) {
+        long long value = atoll(req.get_param_value("recent").c_str());
+        if (value < 0) {
+            res.status = 400;
+            res.set_content("{\"error\": \"Invalid recent\"}", "application/json");
+            return;
+        }
+        recent = (size_t)value;
+    }
+    
+    LatencyTracer& tracer = LatencyTracer::instance();
+    JsonWriter json;
+    json.beginObject();
+    
+    json.key("stages").beginArray();
+    for (const auto& stats : tracer.stats()) {
+        json.beginObject();
+        json.member("pipe", latencyPipeName(stats.pipe));
+        json.member("stage", latencyStageName(stats.stage));
+        writeLatencyPercentiles(json, "since_capture", stats.since_capture);
+        writeLatencyPercentiles(json, "duration", stats.duration);
+        json.endObject();
+    }
+    json.endArray();
+    
+    // 单帧明细：各阶段相对采集时间的偏移
+    json.key("recent").beginArray();
+    for (const auto& trace : tracer.recent(recent)) {
+        json.beginObject();
+        json.member("pipe", latencyPipeName(trace.pipe));
+        json.member("pts_us", trace.pts_us);
+        json.key("stages_us").beginObject();
+        for (size_t s = 0; s < (size_t)LatencyStage::Count; s++) {
+            uint64_t t = trace.stage_us[s];
+            if (t != 0) {
+                json.member(latencyStageName((LatencyStage)s), t >= trace.pts_us ? t - trace.pts_us : (uint64_t)0);
+            }
+        }
+        json.endObject();
+        json.endObject();
+    }
+    json.endArray();
+    
+    json.endObject();
+    res.set_content(json.take(), "application/json");
+}
+
+void ApiServer::handleResetLatencyStats(const httplib::Request& req, httplib::Response& res) {
+    LatencyTracer::instance().reset();
+    res.set_content("{\"message\": \"Latency statistics reset\"}", "application/json");
+}
+
+void ApiServer::handleGetBitrateStatus(const httplib::Request& req, httplib::Response& res) {
+    RateController& controller = RateController::instance();
+    JsonWriter json;
+    json.beginObject();
+    
+    json.key("channels").beginArray();
+    for (const auto& status : controller.status()) {
+        json.beginObject();
+        json.member("venc", status.chn);
+        json.member("active", status.active);
+        json.member("state", status.state);
+        json.member("idle", status.idle);
+        json.member("target_kbps", status.target_kbps);
+        json.member("kbps", status.kbps);
+        json.member("max_kbps", status.max_kbps);
+        json.member("min_kbps", status.min_kbps);
+        json.member("fps", status.fps);
+        json.member("gop", status.gop);
+        json.member("sent_kbps", status.sent_kbps);
+        json.member("tx_ratio", status.tx_ratio);
+        json.member("backlog_bytes", status.backlog_bytes);
+        json.endObject();
+    }
+    json.endArray();
+    
+    // 最近的调整记录，按时间顺序
+    json.key("history").beginArray();
+    for (const auto& event : controller.history()) {
+        json.beginObject();
+        json.member("time_ms", event.time_ms);
+        json.member("venc", event.chn);
+        json.member("reason", event.reason);
+        json.member("from_kbps", event.from_kbps);
+        json.member("to_kbps", event.to_kbps);
+        json.member("fps", event.fps);
+        json.member("gop", event.gop);
+        json.endObject();
+    }
+    json.endArray();
+    
+    json.endObject();
+    res.set_content(json.take(), "application/json");
 }
 
 void ApiServer::handleGetAlarmHistory(const httplib::Request& req, httplib::Response& res) {
-    std::lock_guard<std::mutex> lock(alarm_history_mutex);
+    // 可选参数：since=<seq> 返回该序号之后的记录，limit=N 限制返回条数
+    size_t limit = 0;
+    if (req.has_param("limit")) {
+        long long value = atoll(req.get_param_value("limit").c_str());
+        if (value <= 0) {
+            res.status = 400;
+            res.set_content("{\"error\": \"Invalid limit\"}", "application/json");
+            return;
+        }
+        limit = (size_t)value;
+    }
+    
+    uint64_t last_seq = alarm_history.lastSeq();
+    uint64_t since = last_seq;
+    std::vector<AlarmHistoryEntry> entries;
+    bool has_more = false;
+    if (req.has_param("since")) {
+        // 按序号游标向后翻页，缓冲区已覆盖的记录会被跳过
+        since = strtoull(req.get_param_value("since").c_str(), nullptr, 10);
+        entries = alarm_history.since(since, limit, &has_more);
+    } else {
+        // 未指定游标时返回最新的记录
+        entries = alarm_history.latest(limit);
+    }
+    
+    // 客户端下次请求使用的游标（重启后序号重置时游标回退到当前最新序号）
+    uint64_t next_since = entries.empty() ? std::min(since, last_seq) : entries.back().seq;
+    uint64_t first_seq = alarm_history.firstSeq();
     
-    if (alarm_history.empty()) {
-        res.set_content("{\"history\": []}", "application/json");
+    JsonWriter json;
+    json.beginObject();
+    json.key("history").raw(alarmHistoryToJson(entries));
+    json.member("first_seq", first_seq);
+    json.member("last_seq", last_seq);
+    json.member("next_since", next_since);
+    json.member("has_more", has_more);
+    json.endObject();
+    
+    res.set_content(json.take(), "application/json");
+}
+
+void ApiServer::handleGetAlarmSnapshot(const httplib::Request& req, httplib::Response& res) {
+    std::string id = req.matches[1];
+    bool thumb = req.has_param("thumb") && req.get_param_value("thumb") != "0";
+    
+    // 文件在存储锁内打开并映射，发送期间被淘汰删除也不影响本次响应
+    int fd = -1;
+    size_t size = 0;
+    void* data = MAP_FAILED;
+    if (snapshot_store.open(id, thumb, fd, size)) {
+        data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    if (data == MAP_FAILED) {
+        res.status = 404;
+        res.set_content("{\"error\": \"Snapshot not found\"}", "application/json");
         return;
     }
     
-    res.set_content("{\"history\": " + alarmHistoryToJson() + "}", "application/json");
+    // 截图按内容寻址，ID 即可作为强 ETag，内容永不变化
+    std::string etag = "\"" + id + (thumb ? "-t" : "") + "\"";
+    res.set_header("ETag", etag);
+    res.set_header("Cache-Control", "private, max-age=31536000, immutable");
+    
+    auto it = req.headers.find("If-None-Match");
+    if (it != req.headers.end() && (it->second == etag || it->second == "*")) {
+        munmap(data, size);
+        res.status = 304;
+        return;
+    }
+    
+    // 直接从页缓存发送映射内容，不经过用户态缓冲区拷贝，响应结束后解除映射
+    res.set_content_provider(
+        size, "image/jpeg",
+        [data](size_t offset, size_t length, httplib::DataSink& sink) {
+            return sink.write((const char*)data + offset, length);
+        },
+        [data, size](bool success) {
+            munmap(data, size);
+        });
 }
 
-void ApiServer::handleLedControl(const httplib::Request& req, httplib::Response& res) {
-    if (!led_module || !control) {
+// 预览 JPEG 由子码流帧在 CPU / 独立编码通道编码，不经过隐私遮挡，开启遮挡时拒绝预览
+bool ApiServer::previewBlocked(httplib::Response& res) {
+    if (!rk_param_snapshot()->get(param_key::ai_privacy_enable)) {
+        return false;
+    }
+    res.status = 403;
+    res.set_content("{\"error\": \"Video preview disabled by privacy masking\"}", "application/json");
+    return true;
+}
+
+void ApiServer::handleVideoSnapshot(const httplib::Request& req, httplib::Response& res) {
+    if (!preview_cache) {
         res.status = 503;
-        res.set_content("{\"error\": \"LED module not available\"}", "application/json");
+        res.set_content("{\"error\": \"Video preview not available\"}", "application/json");
+        return;
+    }
+    if (previewBlocked(res)) {
         return;
     }
     
-    // 解析请求体，获取操作类型
-    if (req.body.empty()) {
-        res.status = 400;
-        res.set_content("{\"error\": \"Empty request body\"}", "application/json");
+    JpegFramePtr frame = preview_cache->getFresh(1000);
+    if (!frame) {
+        res.status = 503;
+        res.set_content("{\"error\": \"No video frame available\"}", "application/json");
         return;
     }
     
-    // 简单解析 JSON
-    std::string action;
-    int duration = 0;
+    // 直接发送共享的编码缓冲区，响应结束前由 lambda 持有引用
+    res.set_header("Cache-Control", "no-store");
+    res.set_content_provider(
+        frame->data.size(), "image/jpeg",
+        [frame](size_t offset, size_t length, httplib::DataSink& sink) {
+            return sink.write((const char*)frame->data.data() + offset, length);
+        });
+}
+
+void ApiServer::handleVideoMjpeg(const httplib::Request& req, httplib::Response& res) {
+    if (!preview_cache) {
+        res.status = 503;
+        res.set_content("{\"error\": \"Video preview not available\"}", "application/json");
+        return;
+    }
+    if (previewBlocked(res)) {
+        return;
+    }
     
-    // 解析 action 字段
-    size_t action_pos = req.body.find("\"action\"");
-    if (action_pos != std::string::npos) {
-        size_t value_start = req.body.find(':', action_pos) + 1;
-        // 跳过空白字符
-        while (value_start < req.body.length() && isspace(req.body[value_start])) {
-            value_start++;
-        }
-        
-        if (req.body[value_start] == '"') {
-            // 字符串值
-            size_t value_end = req.body.find('"', value_start + 1);
-            if (value_end != std::string::npos) {
-                action = req.body.substr(value_start + 1, value_end - value_start - 1);
+    // 每个 MJPEG 客户端长期占用一个 HTTP 工作线程，需限制数量
+    if (++mjpeg_clients > mjpeg_max_clients) {
+        mjpeg_clients--;
+        res.status = 503;
+        res.set_content("{\"error\": \"Too many preview clients\"}", "application/json");
+        return;
+    }
+    
+    // 每个客户端的帧率上限，不超过编码帧率
+    int fps = preview_cache->maxFps();
+    if (req.has_param("fps")) {
+        fps = std::min(std::max(atoi(req.get_param_value("fps").c_str()), 1), fps);
+    }
+    auto interval = std::chrono::microseconds(1000000 / fps);
+    
+    LOG_INFO("MJPEG client connected from %s, %d fps\n", req.remote_addr.c_str(), fps);
+    
+    uint64_t last_seq = 0;
+    auto next_due = std::chrono::steady_clock::now();
+    res.set_header("Cache-Control", "no-store");
+    res.set_chunked_content_provider(
+        "multipart/x-mixed-replace; boundary=frame",
+        [this, last_seq, next_due, interval](size_t offset, httplib::DataSink& sink) mutable {
+            if (!running) {
+                sink.done();
+                return true;
             }
-        }
+            
+            // 按客户端帧率节流，避免预览抢占编码资源
+            std::this_thread::sleep_until(next_due);
+            
+            JpegFramePtr frame = preview_cache->waitFrame(last_seq, 2000);
+            if (!frame) {
+                // 没有新帧（视频停止或暂停），保持连接等待
+                return true;
+            }
+            // 连接期间开启隐私遮挡时立即结束，不再发送未遮挡的画面
+            if (rk_param_snapshot()->get(param_key::ai_privacy_enable)) {
+                LOG_INFO("MJPEG stream closed: privacy masking enabled\n");
+                sink.done();
+                return true;
+            }
+            last_seq = frame->seq;
+            next_due = std::max(next_due + interval, std::chrono::steady_clock::now());
+            
+            char header[128];
+            int len = snprintf(header, sizeof(header),
+                               "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\n\r\n",
+                               frame->data.size());
+            return sink.write(header, len) &&
+                   sink.write((const char*)frame->data.data(), frame->data.size()) &&
+                   sink.write("\r\n", 2);
+        },
+        [this](bool success) {
+            mjpeg_clients--;
+            LOG_INFO("MJPEG client disconnected\n");
+        });
+}
+
+// 格式化一条 SSE 消息
+static void appendSseEvent(std::string& out, const ServerEvent& event) {
+    if (event.id > 0) {
+        out += "id: " + std::to_string(event.id) + "\n";
     }
+    out += "event: ";
+    out += event.type;
+    out += "\ndata: ";
+    out += *event.data;
+    out += "\n\n";
+}
+
+void ApiServer::handleEvents(const httplib::Request& req, httplib::Response& res) {
+    bool want_detections = req.has_param("detections") && req.get_param_value("detections") != "0";
     
-    // 解析 duration 字段（如果有）
-    size_t duration_pos = req.body.find("\"duration\"");
-    if (duration_pos != std::string::npos) {
-        size_t value_start = req.body.find(':', duration_pos) + 1;
-        // 跳过空白字符
-        while (value_start < req.body.length() && isspace(req.body[value_start])) {
-            value_start++;
+    // 先订阅再读取历史，保证补发与实时事件之间不会漏掉告警
+    auto subscriber = event_hub.subscribe(sse_queue_size, want_detections, sse_max_clients);
+    if (!subscriber) {
+        res.status = 503;
+        res.set_content("{\"error\": \"Too many event subscribers\"}", "application/json");
+        return;
+    }
+    
+    // 断线重连时浏览器通过 Last-Event-ID 请求头带上最后收到的事件ID，
+    // 首次连接也可以用 last_event_id 参数指定
+    std::string last_event_id = req.get_header_value("Last-Event-ID");
+    if (last_event_id.empty() && req.has_param("last_event_id")) {
+        last_event_id = req.get_param_value("last_event_id");
+    }
+    
+    // sent_seq 只记录实际补发过的最大序号，用于跳过订阅队列中重复的告警；
+    // 没有补发时从 0 开始，订阅之后产生的告警全部发送
+    std::string backlog = "retry: 3000\n\n";
+    uint64_t sent_seq = 0;
+    if (!last_event_id.empty()) {
+        uint64_t since = strtoull(last_event_id.c_str(), nullptr, 10);
+        uint64_t first_seq = alarm_history.firstSeq();
+        if (since + 1 < first_seq) {
+            // 部分告警已被环形缓冲区覆盖，通知客户端存在缺口
+            ServerEvent gap;
+            gap.type = "gap";
+            gap.data = std::make_shared<const std::string>(
+                "{\"from\": " + std::to_string(since + 1) + ",\"to\": " + std::to_string(first_seq - 1) + "}");
+            appendSseEvent(backlog, gap);
         }
-        
-        size_t value_end = req.body.find_first_of(",}", value_start);
-        if (value_end != std::string::npos) {
-            std::string duration_str = req.body.substr(value_start, value_end - value_start);
-            try {
-                duration = std::stoi(duration_str);
-            } catch (const std::exception& e) {
-                duration = 0;
-            }
+        for (const auto& entry : alarm_history.since(since, 0)) {
+            ServerEvent event;
+            event.id = entry.seq;
+            event.type = "alarm";
+            event.data = entry.json;
+            appendSseEvent(backlog, event);
+            sent_seq = entry.seq;
         }
     }
     
+    LOG_INFO("Event subscriber connected from %s, %zu active\n",
+             req.remote_addr.c_str(), event_hub.subscriberCount());
+    
+    res.set_header("Cache-Control", "no-cache");
+    res.set_header("X-Accel-Buffering", "no");
+    res.set_chunked_content_provider(
+        "text/event-stream",
+        [this, subscriber, backlog, sent_seq](size_t offset, httplib::DataSink& sink) mutable {
+            if (!backlog.empty()) {
+                bool ok = sink.write(backlog.data(), backlog.size());
+                backlog.clear();
+                backlog.shrink_to_fit();
+                return ok;
+            }
+            
+            ServerEvent event;
+            if (!subscriber->wait(event, 15000)) {
+                if (subscriber->isClosed() || !running) {
+                    sink.done();
+                    return true;
+                }
+                // 定期发送注释行保活，同时用于发现已断开的连接
+                static const char keepalive[] = ": keepalive\n\n";
+                return sink.write(keepalive, sizeof(keepalive) - 1);
+            }
+            
+            // 跳过已经作为历史补发过的告警
+            if (event.id > 0 && event.id <= sent_seq) {
+                return true;
+            }
+            
+            std::string out;
+            appendSseEvent(out, event);
+            return sink.write(out.data(), out.size());
+        },
+        [this, subscriber](bool success) {
+            if (subscriber->dropped() > 0) {
+                LOG_WARN("Event subscriber dropped %llu events (slow client)\n",
+                         (unsigned long long)subscriber->dropped());
+            }
+            event_hub.unsubscribe(subscriber);
+            LOG_INFO("Event subscriber disconnected\n");
+        });
+}
+
+void ApiServer::handleLedControl(const httplib::Request& req, httplib::Response& res) {
+    if (!led_module || !control) {
+        res.status = 503;
+        res.set_content("{\"error\": \"LED module not available\"}", "application/json");
+        return;
+    }
+    
+    // 解析请求体，获取操作类型
+    JsonDocument doc;
+    if (!parseJsonBody(req, res, doc)) {
+        return;
+    }
+    
+    std::string action = doc.root()["action"].asString();
+    int duration = (int)doc.root()["duration"].asInt(0);
+    
     if (action.empty()) {
         res.status = 400;
         res.set_content("{\"error\": \"Missing 'action' field\"}", "application/json");
@@ -765,53 +1189,13 @@ void ApiServer::handlePantiltControl(const httplib::Request& req, httplib::Respo
     }
     
     // 解析请求体，获取操作类型
-    if (req.body.empty()) {
-        res.status = 400;
-        res.set_content("{\"error\": \"Empty request body\"}", "application/json");
+    JsonDocument doc;
+    if (!parseJsonBody(req, res, doc)) {
         return;
     }
     
-    // 简单解析 JSON
-    std::string action;
-    int degree = 0;
-    
-    // 解析 action 字段
-    size_t action_pos = req.body.find("\"action\"");
-    if (action_pos != std::string::npos) {
-        size_t value_start = req.body.find(':', action_pos) + 1;
-        // 跳过空白字符
-        while (value_start < req.body.length() && isspace(req.body[value_start])) {
-            value_start++;
-        }
-        
-        if (req.body[value_start] == '"') {
-            // 字符串值
-            size_t value_end = req.body.find('"', value_start + 1);
-            if (value_end != std::string::npos) {
-                action = req.body.substr(value_start + 1, value_end - value_start - 1);
-            }
-        }
-    }
-    
-    // 解析 degree 字段（如果有）
-    size_t degree_pos = req.body.find("\"degree\"");
-    if (degree_pos != std::string::npos) {
-        size_t value_start = req.body.find(':', degree_pos) + 1;
-        // 跳过空白字符
-        while (value_start < req.body.length() && isspace(req.body[value_start])) {
-            value_start++;
-        }
-        
-        size_t value_end = req.body.find_first_of(",}", value_start);
-        if (value_end != std::string::npos) {
-            std::string degree_str = req.body.substr(value_start, value_end - value_start);
-            try {
-                degree = std::stoi(degree_str);
-            } catch (const std::exception& e) {
-                degree = 0;
-            }
-        }
-    }
+    std::string action = doc.root()["action"].asString();
+    int degree = (int)doc.root()["degree"].asInt(0);
     
     if (action.empty()) {
         res.status = 400;
@@ -858,53 +1242,13 @@ void ApiServer::handleVideoControl(const httplib::Request& req, httplib::Respons
     }
     
     // 解析请求体，获取操作类型
-    if (req.body.empty()) {
-        res.status = 400;
-        res.set_content("{\"error\": \"Empty request body\"}", "application/json");
+    JsonDocument doc;
+    if (!parseJsonBody(req, res, doc)) {
         return;
     }
     
-    // 简单解析 JSON
-    std::string action;
-    int pipe = 0; // 默认为 pipe0
-    
-    // 解析 action 字段
-    size_t action_pos = req.body.find("\"action\"");
-    if (action_pos != std::string::npos) {
-        size_t value_start = req.body.find(':', action_pos) + 1;
-        // 跳过空白字符
-        while (value_start < req.body.length() && isspace(req.body[value_start])) {
-            value_start++;
-        }
-        
-        if (req.body[value_start] == '"') {
-            // 字符串值
-            size_t value_end = req.body.find('"', value_start + 1);
-            if (value_end != std::string::npos) {
-                action = req.body.substr(value_start + 1, value_end - value_start - 1);
-            }
-        }
-    }
-    
-    // 解析 pipe 字段（如果有）
-    size_t pipe_pos = req.body.find("\"pipe\"");
-    if (pipe_pos != std::string::npos) {
-        size_t value_start = req.body.find(':', pipe_pos) + 1;
-        // 跳过空白字符
-        while (value_start < req.body.length() && isspace(req.body[value_start])) {
-            value_start++;
-        }
-        
-        size_t value_end = req.body.find_first_of(",}", value_start);
-        if (value_end != std::string::npos) {
-            std::string pipe_str = req.body.substr(value_start, value_end - value_start);
-            try {
-                pipe = std::stoi(pipe_str);
-            } catch (const std::exception& e) {
-                pipe = 0;
-            }
-        }
-    }
+    std::string action = doc.root()["action"].asString();
+    int pipe = (int)doc.root()["pipe"].asInt(0); // 默认为 pipe0
     
     if (action.empty()) {
         res.status = 400;
@@ -982,235 +1326,174 @@ void ApiServer::handleGetSystemParams(const httplib::Request& req, httplib::Resp
     }
     
     // 构建 JSON 响应
-    std::stringstream json;
-    json << "{";
+    JsonWriter json;
+    json.reserve(params.size() * 48);
+    json.beginObject();
     
     if (!section.empty()) {
-        json << "\"section\": \"" << section << "\",";
+        json.member("section", section);
     }
     
-    json << "\"params\": {";
-    
-    for (size_t i = 0; i < params.size(); ++i) {
-        const auto& param = params[i];
-        json << "\"" << param.first << "\": \"" << param.second << "\"";
-        if (i < params.size() - 1) {
-            json << ",";
-        }
+    json.key("params").beginObject();
+    for (const auto& param : params) {
+        json.member(param.first.c_str(), param.second);
     }
+    json.endObject();
     
-    json << "}}";
+    json.endObject();
     
-    res.set_content(json.str(), "application/json");
+    res.set_content(json.take(), "application/json");
 }
 
 void ApiServer::handleSetSystemParam(const httplib::Request& req, httplib::Response& res) {
-    if (req.body.empty()) {
-        res.status = 400;
-        res.set_content("{\"error\": \"Empty request body\"}", "application/json");
+    JsonDocument doc;
+    if (!parseJsonBody(req, res, doc)) {
         return;
     }
     
-    // 解析请求体，获取参数名和值
-    std::string param_name;
+    // 支持两种格式：
+    //   单个参数 {"param_name": "...", "param_value": ..., "save": true}
+    //   批量参数 {"params": {"section:key": value, ...}, "save": true}
+    // 值可以是字符串、数字或布尔值，批量参数全部成功或全部不生效
+    JsonValue root = doc.root();
+    JsonValue params = root["params"];
+    bool batch = params.valid();
+    bool save_to_file = root["save"].asBool(false);
+    std::vector<std::pair<std::string, std::string>> updates;
     std::string param_value;
-    bool save_to_file = false;
-    
-    // 解析 param_name 字段
-    size_t name_pos = req.body.find("\"param_name\"");
-    if (name_pos != std::string::npos) {
-        size_t value_start = req.body.find(':', name_pos) + 1;
-        // 跳过空白字符
-        while (value_start < req.body.length() && isspace(req.body[value_start])) {
-            value_start++;
-        }
-        
-        if (req.body[value_start] == '"') {
-            // 字符串值
-            size_t value_end = req.body.find('"', value_start + 1);
-            if (value_end != std::string::npos) {
-                param_name = req.body.substr(value_start + 1, value_end - value_start - 1);
-            }
-        }
-    }
     
-    // 解析 param_value 字段
-    size_t value_pos = req.body.find("\"param_value\"");
-    if (value_pos != std::string::npos) {
-        size_t value_start = req.body.find(':', value_pos) + 1;
-        // 跳过空白字符
-        while (value_start < req.body.length() && isspace(req.body[value_start])) {
-            value_start++;
+    if (batch) {
+        if (!params.isObject() || params.size() == 0) {
+            res.status = 400;
+            res.set_content("{\"error\": \"'params' must be a non-empty object\"}", "application/json");
+            return;
         }
-        
-        if (req.body[value_start] == '"') {
-            // 字符串值
-            size_t value_end = req.body.find('"', value_start + 1);
-            if (value_end != std::string::npos) {
-                param_value = req.body.substr(value_start + 1, value_end - value_start - 1);
-            }
-        } else if (isdigit(req.body[value_start]) || req.body[value_start] == '-') {
-            // 数字值
-            size_t value_end = req.body.find_first_of(",}", value_start);
-            if (value_end != std::string::npos) {
-                param_value = req.body.substr(value_start, value_end - value_start);
+        for (JsonValue value = params.first(); value.valid(); value = value.next()) {
+            if (!value.toText(param_value)) {
+                res.status = 400;
+                res.set_content(JsonWriter::error("Invalid value for '" + value.key() + "'"), "application/json");
+                return;
             }
+            updates.emplace_back(value.key(), param_value);
         }
-    }
-    
-    // 解析 save 字段（如果有）
-    size_t save_pos = req.body.find("\"save\"");
-    if (save_pos != std::string::npos) {
-        size_t value_start = req.body.find(':', save_pos) + 1;
-        // 跳过空白字符
-        while (value_start < req.body.length() && isspace(req.body[value_start])) {
-            value_start++;
+    } else {
+        std::string param_name = root["param_name"].asString();
+        root["param_value"].toText(param_value);
+        
+        if (param_name.empty()) {
+            res.status = 400;
+            res.set_content("{\"error\": \"Missing 'param_name' field\"}", "application/json");
+            return;
         }
         
-        size_t value_end = req.body.find_first_of(",}", value_start);
-        if (value_end != std::string::npos) {
-            std::string save_str = req.body.substr(value_start, value_end - value_start);
-            save_to_file = (save_str == "true");
+        if (param_value.empty()) {
+            res.status = 400;
+            res.set_content("{\"error\": \"Missing 'param_value' field\"}", "application/json");
+            return;
         }
+        updates.emplace_back(param_name, param_value);
     }
     
-    if (param_name.empty()) {
-        res.status = 400;
-        res.set_content("{\"error\": \"Missing 'param_name' field\"}", "application/json");
-        return;
-    }
-    
-    if (param_value.empty()) {
-        res.status = 400;
-        res.set_content("{\"error\": \"Missing 'param_value' field\"}", "application/json");
+    // 设置参数值，需要保存时延迟合并写入，连续修改只写一次 flash
+    int ret = rk_param_set_batch(updates, save_to_file ? RK_PARAM_SAVE_DEFERRED : RK_PARAM_NO_SAVE);
+    if (ret != 0) {
+        res.status = (ret == -EINVAL) ? 400 : 500;
+        res.set_content(ret == -EINVAL ? "{\"error\": \"Invalid parameter name or value\"}"
+                                       : "{\"error\": \"Failed to update parameter\"}",
+                        "application/json");
         return;
     }
     
-    // 检查是否有权限修改该参数
-    if (param_name.find("api:key") != std::string::npos) {
-        // 修改 API 密钥是特殊情况，需要额外处理
-        api_key = param_value;
-        LOG_INFO("API key updated\n");
+    for (const auto& update : updates) {
+        if (update.first == "api:key") {
+            // 修改 API 密钥是特殊情况，需要额外处理
+            api_key = update.second;
+            LOG_INFO("API key updated\n");
+        }
     }
     
-    // 设置参数值
-    bool success = rk_param_set_string(param_name.c_str(), param_value.c_str());
-    
-    if (success) {
-        // 如果需要，保存参数到文件
-        if (save_to_file) {
-            rk_param_save();
+    // 构建包含更新后参数值的响应
+    JsonWriter json;
+    json.beginObject();
+    json.member("message", batch ? "Parameters updated successfully" : "Parameter updated successfully");
+    if (batch) {
+        json.key("params").beginObject();
+        for (const auto& update : updates) {
+            json.member(update.first.c_str(), update.second);
         }
-        
-        // 构建包含更新后参数值的响应
-        std::stringstream json;
-        json << "{";
-        json << "\"message\": \"Parameter updated successfully\",";
-        json << "\"param_name\": \"" << param_name << "\",";
-        json << "\"param_value\": \"" << param_value << "\",";
-        json << "\"saved_to_file\": " << (save_to_file ? "true" : "false");
-        json << "}";
-        
-        res.set_content(json.str(), "application/json");
+        json.endObject();
     } else {
-        res.status = 500;
-        res.set_content("{\"error\": \"Failed to update parameter\"}", "application/json");
+        json.member("param_name", updates[0].first);
+        json.member("param_value", updates[0].second);
     }
+    json.member("saved_to_file", save_to_file);
+    json.endObject();
+    
+    res.set_content(json.take(), "application/json");
 }
 
-std::string ApiServer::roiAreaToJson(const RoiArea& roi) {
-    std::stringstream json;
-    
-    json << "{";
-    json << "\"id\": " << roi.id << ",";
-    json << "\"name\": \"" << roi.name << "\",";
-    json << "\"x\": " << roi.x << ",";
-    json << "\"y\": " << roi.y << ",";
-    json << "\"width\": " << roi.width << ",";
-    json << "\"height\": " << roi.height << ",";
-    json << "\"stay_time\": " << roi.stay_time << ",";
-    json << "\"cooldown_time\": " << roi.cooldown_time << ",";
-    json << "\"enabled\": " << (roi.enabled ? "true" : "false") << ",";
-    json << "\"group_id\": " << roi.group_id << ",";
+void ApiServer::roiAreaToJson(JsonWriter& json, const RoiArea& roi) {
+    json.beginObject();
+    json.member("id", roi.id);
+    json.member("name", roi.name);
+    json.member("x", roi.x);
+    json.member("y", roi.y);
+    json.member("width", roi.width);
+    json.member("height", roi.height);
+    json.member("stay_time", roi.stay_time);
+    json.member("cooldown_time", roi.cooldown_time);
+    json.member("enabled", roi.enabled);
+    json.member("group_id", roi.group_id);
     
     // 类别数组
-    json << "\"classes\": [";
-    for (size_t i = 0; i < roi.classes.size(); ++i) {
-        json << roi.classes[i];
-        if (i < roi.classes.size() - 1) {
-            json << ",";
-        }
+    json.key("classes").beginArray();
+    for (int class_id : roi.classes) {
+        json.value(class_id);
     }
-    json << "]";
+    json.endArray();
     
-    json << "}";
-    
-    return json.str();
+    json.endObject();
 }
 
-std::string ApiServer::roiGroupToJson(const RoiGroup& group) {
-    std::stringstream json;
-    
-    json << "{";
-    json << "\"id\": " << group.id << ",";
-    json << "\"name\": \"" << group.name << "\",";
+void ApiServer::roiGroupToJson(JsonWriter& json, const RoiGroup& group) {
+    json.beginObject();
+    json.member("id", group.id);
+    json.member("name", group.name);
     
     // 类别数组
-    json << "\"classes\": [";
-    for (size_t i = 0; i < group.classes.size(); ++i) {
-        json << group.classes[i];
-        if (i < group.classes.size() - 1) {
-            json << ",";
-        }
+    json.key("classes").beginArray();
+    for (int class_id : group.classes) {
+        json.value(class_id);
     }
-    json << "],";
+    json.endArray();
     
     // ROI ID 数组
-    json << "\"roi_ids\": [";
-    for (size_t i = 0; i < group.roi_ids.size(); ++i) {
-        json << group.roi_ids[i];
-        if (i < group.roi_ids.size() - 1) {
-            json << ",";
-        }
+    json.key("roi_ids").beginArray();
+    for (int roi_id : group.roi_ids) {
+        json.value(roi_id);
     }
-    json << "]";
-    
-    json << "}";
+    json.endArray();
     
-    return json.str();
+    json.endObject();
 }
 
-std::string ApiServer::alarmHistoryToJson() {
-    std::stringstream json;
+std::string ApiServer::alarmHistoryToJson(const std::vector<AlarmHistoryEntry>& entries) {
+    // 各条记录在插入时已序列化，这里只做拼接
+    size_t total = 2;
+    for (const auto& entry : entries) {
+        total += entry.json->size() + 1;
+    }
     
-    json << "[";
-    for (size_t i = 0; i < alarm_history.size(); ++i) {
-        const auto& entry = alarm_history[i];
-        const auto& alarm = entry.info;
-        
-        json << "{";
-        json << "\"timestamp\": \"" << entry.timestamp_str << "\",";
-        json << "\"roi_id\": " << alarm.roi_id << ",";
-        json << "\"roi_name\": \"" << alarm.roi_name << "\",";
-        json << "\"group_id\": " << alarm.group_id << ",";
-        json << "\"group_name\": \"" << alarm.group_name << "\",";
-        json << "\"track_id\": " << alarm.track_id << ",";
-        json << "\"class_id\": " << alarm.class_id << ",";
-        json << "\"class_name\": \"" << alarm.class_name << "\",";
-        json << "\"confidence\": " << alarm.confidence << ",";
-        json << "\"box\": {";
-        json << "\"x\": " << alarm.box.x << ",";
-        json << "\"y\": " << alarm.box.y << ",";
-        json << "\"width\": " << alarm.box.width << ",";
-        json << "\"height\": " << alarm.box.height;
-        json << "}";
-        json << "}";
-        
-        if (i < alarm_history.size() - 1) {
-            json << ",";
+    std::string json;
+    json.reserve(total);
+    json += "[";
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i > 0) {
+            json += ",";
         }
+        json += *entries[i].json;
     }
-    json << "]";
+    json += "]";
     
-    return json.str();
-}
\ No newline at end of file
+    return json;
+}
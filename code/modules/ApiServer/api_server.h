@@ -7,22 +7,21 @@
 #include <memory>
 #include <vector>
 #include <mutex>
+#include <queue>
+#include <condition_variable>
 #include "httplib.h"
+#include "json.h"
 #include "../Video/roi_detector.h"
 #include "../Video/alarm_pusher.h"
+#include "../Video/jpeg_cache.h"
 #include "../Control/Control.h"
 #include "../Led/Led.h"
 #include "../Pantilt/Pantilt.h"
+#include "snapshot_store.h"
+#include "alarm_history.h"
+#include "event_hub.h"
 #include "global.h"
 
-// 告警历史记录结构
-struct AlarmHistoryEntry {
-    AlarmInfo info;
-    std::string timestamp_str;
-    
-    AlarmHistoryEntry(const AlarmInfo& alarm_info);
-};
-
 class ApiServer {
 public:
     ApiServer(int port = 8080);
@@ -40,8 +39,11 @@ public:
     // 注册告警回调，用于记录告警历史
     void registerAlarmCallback();
     
-    // 处理告警事件，记录到历史记录中
-    void onAlarm(const AlarmInfo& alarm);
+    // 接收告警事件，交给告警处理线程（在 AI 线程中调用，不做耗时处理）
+    void onAlarm(const AlarmEventPtr& alarm);
+    
+    // 处理单帧检测结果，推送给订阅了检测摘要的客户端
+    void onDetections(const DetectionSummaryPtr& summary);
     
     // 设置 API 密钥，用于认证
     void setApiKey(const std::string& key) { api_key = key; }
@@ -54,6 +56,9 @@ public:
     
     // 设置云台模块的引用
     void setPantilt(Pantilt* pt) { pantilt = pt; }
+    
+    // 设置视频预览图来源
+    void setPreviewSource(JpegCache* cache) { preview_cache = cache; }
 
 private:
     // HTTP 服务器实例
@@ -62,6 +67,12 @@ private:
     // 服务器线程
     std::thread server_thread;
     
+    // 告警处理线程：生成缩略图、写入截图存储、记录历史并推送
+    std::thread alarm_thread;
+    std::queue<AlarmEventPtr> alarm_queue;
+    std::mutex alarm_mutex;
+    std::condition_variable alarm_cv;
+    
     // 服务器运行标志
     std::atomic<bool> running;
     
@@ -74,14 +85,21 @@ private:
     // API 密钥，用于认证
     std::string api_key;
     
-    // 告警历史记录
-    std::vector<AlarmHistoryEntry> alarm_history;
+    // 告警历史记录（环形缓冲区，容量由 api:alarm_history_size 配置）
+    AlarmHistory alarm_history;
+    
+    // 事件推送（SSE）订阅管理
+    EventHub event_hub;
+    
+    // 每个 SSE 客户端的事件队列长度与最大客户端数量
+    size_t sse_queue_size;
+    size_t sse_max_clients;
     
-    // 告警历史记录互斥锁
-    std::mutex alarm_history_mutex;
+    // 告警截图磁盘存储
+    SnapshotStore snapshot_store;
     
-    // 最大历史记录数量
-    static const int MAX_ALARM_HISTORY = 100;
+    // 是否在告警时生成缩略图
+    bool snapshot_thumbnail;
     
     // 控制模块的引用
     Control* control;
@@ -92,9 +110,22 @@ private:
     // 云台模块的引用
     Pantilt* pantilt;
     
+    // 视频预览图缓存的引用
+    JpegCache* preview_cache;
+    
+    // 当前 MJPEG 客户端数量及上限
+    std::atomic<int> mjpeg_clients;
+    int mjpeg_max_clients;
+    
     // 初始化 API 路由
     void initRoutes();
     
+    // 告警处理线程函数
+    void alarmThread();
+    
+    // 处理一条告警，记录到历史记录中
+    void processAlarm(const AlarmEventPtr& alarm);
+    
     // 验证 API 密钥
     bool validateApiKey(const httplib::Request& req, httplib::Response& res);
     
@@ -110,9 +141,27 @@ private:
     // 处理系统状态查询请求
     void handleGetSystemStatus(const httplib::Request& req, httplib::Response& res);
     
+    // 获取信号队列深度和丢弃统计
+    void handleGetSignalStats(const httplib::Request& req, httplib::Response& res);
+    
+    // 获取视频链路各阶段的延迟分布
+    void handleGetLatencyStats(const httplib::Request& req, httplib::Response& res);
+    
+    // 清空延迟统计
+    void handleResetLatencyStats(const httplib::Request& req, httplib::Response& res);
+    
+    // 获取 RTSP 码流的自适应码率状态和调整记录
+    void handleGetBitrateStatus(const httplib::Request& req, httplib::Response& res);
+    
     // 处理告警历史查询请求
     void handleGetAlarmHistory(const httplib::Request& req, httplib::Response& res);
     
+    // 处理告警截图请求
+    void handleGetAlarmSnapshot(const httplib::Request& req, httplib::Response& res);
+    
+    // 处理事件推送（SSE）订阅请求
+    void handleEvents(const httplib::Request& req, httplib::Response& res);
+    
     // LED控制相关
     void handleLedControl(const httplib::Request& req, httplib::Response& res);
     
@@ -122,18 +171,23 @@ private:
     // 视频流控制相关
     void handleVideoControl(const httplib::Request& req, httplib::Response& res);
     
+    // 视频预览（单帧快照与 MJPEG 流）
+    bool previewBlocked(httplib::Response& res);
+    void handleVideoSnapshot(const httplib::Request& req, httplib::Response& res);
+    void handleVideoMjpeg(const httplib::Request& req, httplib::Response& res);
+    
     // 系统参数管理
     void handleGetSystemParams(const httplib::Request& req, httplib::Response& res);
     void handleSetSystemParam(const httplib::Request& req, httplib::Response& res);
     
-    // 将 ROI 区域转换为 JSON 字符串
-    std::string roiAreaToJson(const RoiArea& roi);
+    // 将 ROI 区域序列化为 JSON 对象
+    void roiAreaToJson(JsonWriter& json, const RoiArea& roi);
     
-    // 将 ROI 组转换为 JSON 字符串
-    std::string roiGroupToJson(const RoiGroup& group);
+    // 将 ROI 组序列化为 JSON 对象
+    void roiGroupToJson(JsonWriter& json, const RoiGroup& group);
     
-    // 将告警历史记录转换为 JSON 字符串
-    std::string alarmHistoryToJson();
+    // 将告警历史记录拼接为 JSON 数组
+    std::string alarmHistoryToJson(const std::vector<AlarmHistoryEntry>& entries);
 };
 
 // 全局 API 服务器实例
@@ -0,0 +1,99 @@
+#include "event_hub.h"
+#include <algorithm>
+#include <chrono>
+
+EventSubscriber::EventSubscriber(size_t max_queue, bool want_detections)
+    : max_queue(std::max<size_t>(max_queue, 1)), want_detections(want_detections),
+      closed(false), dropped_count(0) {
+}
+
+void EventSubscriber::push(const ServerEvent& event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (closed) {
+        return;
+    }
+    // 慢客户端不能拖住发布者，队列满时丢弃最旧的事件
+    while (queue.size() >= max_queue) {
+        queue.pop_front();
+        dropped_count++;
+    }
+    queue.push_back(event);
+    cond.notify_one();
+}
+
+void EventSubscriber::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    cond.notify_all();
+}
+
+bool EventSubscriber::isClosed() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return closed;
+}
+
+bool EventSubscriber::wait(ServerEvent& event, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() {
+        return !queue.empty() || closed;
+    });
+    if (closed || queue.empty()) {
+        return false;
+    }
+    event = std::move(queue.front());
+    queue.pop_front();
+    return true;
+}
+
+EventHub::EventHub() : detection_subscribers(0) {
+}
+
+std::shared_ptr<EventSubscriber> EventHub::subscribe(size_t max_queue, bool want_detections, size_t max_subscribers) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (subscribers.size() >= max_subscribers) {
+        return nullptr;
+    }
+    auto subscriber = std::make_shared<EventSubscriber>(max_queue, want_detections);
+    subscribers.push_back(subscriber);
+    if (want_detections) {
+        detection_subscribers++;
+    }
+    return subscriber;
+}
+
+void EventHub::unsubscribe(const std::shared_ptr<EventSubscriber>& subscriber) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = std::find(subscribers.begin(), subscribers.end(), subscriber);
+    if (it == subscribers.end()) {
+        return;
+    }
+    if (subscriber->wantDetections()) {
+        detection_subscribers--;
+    }
+    subscriber->close();
+    subscribers.erase(it);
+}
+
+void EventHub::publish(const ServerEvent& event, bool detection) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& subscriber : subscribers) {
+        if (detection && !subscriber->wantDetections()) {
+            continue;
+        }
+        subscriber->push(event);
+    }
+}
+
+void EventHub::closeAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& subscriber : subscribers) {
+        subscriber->close();
+    }
+    subscribers.clear();
+    detection_subscribers = 0;
+}
+
+size_t EventHub::subscriberCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return subscribers.size();
+}
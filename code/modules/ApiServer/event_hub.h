@@ -0,0 +1,76 @@
+#ifndef EVENT_HUB_H
+#define EVENT_HUB_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+// 推送给订阅者的事件
+struct ServerEvent {
+    uint64_t id = 0;                            // 事件ID（告警为历史记录序号，检测摘要为0）
+    const char* type = "";                      // 事件类型，对应 SSE 的 event 字段
+    std::shared_ptr<const std::string> data;    // 已序列化的事件内容，所有订阅者共享
+};
+
+// 单个订阅者的有界事件队列，队列满时丢弃最旧的事件
+class EventSubscriber {
+public:
+    EventSubscriber(size_t max_queue, bool want_detections);
+
+    // 等待下一个事件，超时或订阅被关闭时返回 false
+    bool wait(ServerEvent& event, int timeout_ms);
+
+    bool wantDetections() const { return want_detections; }
+    bool isClosed();
+
+    // 因队列满而丢弃的事件数量
+    uint64_t dropped() const { return dropped_count; }
+
+private:
+    friend class EventHub;
+
+    void push(const ServerEvent& event);
+    void close();
+
+    const size_t max_queue;
+    const bool want_detections;
+    std::deque<ServerEvent> queue;
+    bool closed;
+    std::atomic<uint64_t> dropped_count;
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+// 事件分发中心，将告警和检测摘要扇出给所有订阅者
+class EventHub {
+public:
+    EventHub();
+
+    // 添加订阅者，超过最大订阅数时返回空指针
+    std::shared_ptr<EventSubscriber> subscribe(size_t max_queue, bool want_detections, size_t max_subscribers);
+
+    void unsubscribe(const std::shared_ptr<EventSubscriber>& subscriber);
+
+    // 发布事件，detection 为 true 时只发送给订阅了检测摘要的客户端
+    void publish(const ServerEvent& event, bool detection = false);
+
+    // 关闭所有订阅（服务器停止时调用）
+    void closeAll();
+
+    size_t subscriberCount();
+
+    // 是否有订阅检测摘要的客户端，没有时可跳过序列化
+    bool hasDetectionSubscribers() const { return detection_subscribers > 0; }
+
+private:
+    std::vector<std::shared_ptr<EventSubscriber>> subscribers;
+    std::atomic<int> detection_subscribers;
+    std::mutex mutex;
+};
+
+#endif // EVENT_HUB_H
@@ -0,0 +1,284 @@
+#include "snapshot_store.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "log.h"
+
+static const size_t SNAPSHOT_ID_LEN = 16;   // 64位哈希的十六进制长度
+static const char *THUMB_SUFFIX = "_thumb.jpg";
+static const char *JPEG_SUFFIX = ".jpg";
+
+// FNV-1a 64位哈希，用作内容寻址的截图ID
+static uint64_t fnv1a64(const unsigned char *data, size_t len) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// 逐级创建目录
+static bool make_dirs(const std::string& path) {
+    std::string current;
+    size_t pos = 0;
+    while (pos != std::string::npos) {
+        pos = path.find('/', pos + 1);
+        current = path.substr(0, pos);
+        if (current.empty()) {
+            continue;
+        }
+        if (mkdir(current.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SnapshotStore::SnapshotStore() : max_bytes(0), total_bytes(0), ready(false) {
+}
+
+SnapshotStore::~SnapshotStore() {
+}
+
+bool SnapshotStore::isValidId(const std::string& id) {
+    if (id.size() != SNAPSHOT_ID_LEN) {
+        return false;
+    }
+    for (char c : id) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string SnapshotStore::filePath(const std::string& id, bool thumb) const {
+    return dir + "/" + id + (thumb ? THUMB_SUFFIX : JPEG_SUFFIX);
+}
+
+bool SnapshotStore::init(const std::string& dir, size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    this->dir = dir;
+    this->max_bytes = max_bytes;
+    total_bytes = 0;
+    lru.clear();
+    index.clear();
+    ready = false;
+
+    if (!make_dirs(dir)) {
+        LOG_ERROR("Failed to create snapshot directory %s: %s\n", dir.c_str(), strerror(errno));
+        return false;
+    }
+
+    DIR *dp = opendir(dir.c_str());
+    if (!dp) {
+        LOG_ERROR("Failed to open snapshot directory %s: %s\n", dir.c_str(), strerror(errno));
+        return false;
+    }
+
+    // 扫描已有截图，按修改时间恢复LRU顺序
+    struct Found {
+        std::string id;
+        size_t bytes = 0;
+        bool has_thumb = false;
+        time_t mtime = 0;
+    };
+    std::unordered_map<std::string, Found> found;
+
+    struct dirent *ent;
+    while ((ent = readdir(dp)) != NULL) {
+        std::string name = ent->d_name;
+        std::string path = dir + "/" + name;
+
+        // 清理上次异常退出留下的临时文件
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".tmp") == 0) {
+            unlink(path.c_str());
+            continue;
+        }
+
+        std::string id = name.substr(0, SNAPSHOT_ID_LEN);
+        std::string suffix = name.size() > SNAPSHOT_ID_LEN ? name.substr(SNAPSHOT_ID_LEN) : "";
+        bool is_thumb = (suffix == THUMB_SUFFIX);
+        if (!isValidId(id) || (!is_thumb && suffix != JPEG_SUFFIX)) {
+            continue;
+        }
+
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+
+        auto& f = found[id];
+        f.id = id;
+        f.bytes += st.st_size;
+        if (is_thumb) {
+            f.has_thumb = true;
+        } else {
+            f.mtime = st.st_mtime;
+        }
+    }
+    closedir(dp);
+
+    std::vector<Found> sorted;
+    for (auto& kv : found) {
+        if (kv.second.mtime == 0) {
+            // 只有缩略图没有原图，视为残留文件
+            unlink(filePath(kv.first, true).c_str());
+            continue;
+        }
+        sorted.push_back(kv.second);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Found& a, const Found& b) {
+        return a.mtime < b.mtime;
+    });
+    for (const auto& f : sorted) {
+        lru.push_front({f.id, f.bytes, f.has_thumb});
+        index[f.id] = lru.begin();
+        total_bytes += f.bytes;
+    }
+
+    evictLocked();
+    ready = true;
+
+    LOG_INFO("Snapshot store %s: %zu snapshots, %zu bytes (limit %zu)\n",
+             dir.c_str(), lru.size(), total_bytes, max_bytes);
+    return true;
+}
+
+bool SnapshotStore::writeFile(const std::string& path, const std::vector<unsigned char>& data) {
+    // 先写临时文件再 rename，避免断电后留下不完整的截图
+    std::string tmp_path = path + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open %s: %s\n", tmp_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Failed to write %s: %s\n", tmp_path.c_str(), strerror(errno));
+            close(fd);
+            unlink(tmp_path.c_str());
+            return false;
+        }
+        written += n;
+    }
+    close(fd);
+
+    if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+        LOG_ERROR("Failed to rename %s: %s\n", tmp_path.c_str(), strerror(errno));
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void SnapshotStore::removeFiles(const Entry& entry) {
+    unlink(filePath(entry.id, false).c_str());
+    if (entry.has_thumb) {
+        unlink(filePath(entry.id, true).c_str());
+    }
+}
+
+void SnapshotStore::evictLocked() {
+    // 从最久未使用的截图开始淘汰，至少保留最新的一张
+    while (total_bytes > max_bytes && lru.size() > 1) {
+        const Entry& victim = lru.back();
+        removeFiles(victim);
+        total_bytes -= victim.bytes;
+        index.erase(victim.id);
+        lru.pop_back();
+    }
+}
+
+std::string SnapshotStore::put(const std::vector<unsigned char>& jpeg,
+                               const std::vector<unsigned char>& thumb) {
+    if (jpeg.empty()) {
+        return "";
+    }
+
+    char id_buf[SNAPSHOT_ID_LEN + 1];
+    snprintf(id_buf, sizeof(id_buf), "%016llx",
+             (unsigned long long)fnv1a64(jpeg.data(), jpeg.size()));
+    std::string id = id_buf;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!ready) {
+        return "";
+    }
+
+    // 相同内容已存在，只更新LRU顺序
+    auto it = index.find(id);
+    if (it != index.end()) {
+        lru.splice(lru.begin(), lru, it->second);
+        return id;
+    }
+
+    if (!writeFile(filePath(id, false), jpeg)) {
+        return "";
+    }
+
+    Entry entry = {id, jpeg.size(), false};
+    if (!thumb.empty() && writeFile(filePath(id, true), thumb)) {
+        entry.has_thumb = true;
+        entry.bytes += thumb.size();
+    }
+
+    lru.push_front(entry);
+    index[id] = lru.begin();
+    total_bytes += entry.bytes;
+
+    evictLocked();
+    return id;
+}
+
+bool SnapshotStore::open(const std::string& id, bool thumb, int& fd, size_t& size) {
+    if (!isValidId(id)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(id);
+    if (it == index.end() || (thumb && !it->second->has_thumb)) {
+        return false;
+    }
+
+    std::string path = filePath(id, thumb);
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    size = st.st_size;
+
+    lru.splice(lru.begin(), lru, it->second);
+    return true;
+}
+
+size_t SnapshotStore::totalBytes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return total_bytes;
+}
+
+size_t SnapshotStore::count() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lru.size();
+}
@@ -0,0 +1,60 @@
+#ifndef SNAPSHOT_STORE_H
+#define SNAPSHOT_STORE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+// 告警截图磁盘存储
+// 以JPEG内容的哈希作为ID（相同内容只存一份），总大小超过上限时按LRU淘汰
+class SnapshotStore {
+public:
+    SnapshotStore();
+    ~SnapshotStore();
+
+    // 初始化存储目录并扫描已有文件，max_bytes 为存储总大小上限
+    bool init(const std::string& dir, size_t max_bytes);
+
+    // 写入一张JPEG截图，返回截图ID，失败时返回空字符串
+    // thumb 非空时一并保存缩略图，与原图一起淘汰
+    std::string put(const std::vector<unsigned char>& jpeg,
+                    const std::vector<unsigned char>& thumb = std::vector<unsigned char>());
+
+    // 查找并打开截图文件，命中时更新LRU顺序；不存在或打开失败返回 false
+    // 文件在锁内打开，之后即使被淘汰删除，已打开的描述符仍可读取完整内容，由调用者关闭
+    bool open(const std::string& id, bool thumb, int& fd, size_t& size);
+
+    // 检查ID格式是否合法（防止路径穿越）
+    static bool isValidId(const std::string& id);
+
+    // 当前占用的字节数与截图数量
+    size_t totalBytes();
+    size_t count();
+
+private:
+    struct Entry {
+        std::string id;
+        size_t bytes;       // 原图与缩略图的总大小
+        bool has_thumb;
+    };
+
+    std::string filePath(const std::string& id, bool thumb) const;
+    bool writeFile(const std::string& path, const std::vector<unsigned char>& data);
+    void removeFiles(const Entry& entry);
+    void evictLocked();
+
+    std::string dir;
+    size_t max_bytes;
+    size_t total_bytes;
+    bool ready;
+
+    // LRU 链表，表头为最近使用
+    std::list<Entry> lru;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    std::mutex mutex;
+};
+
+#endif // SNAPSHOT_STORE_H
@@ -67,7 +67,7 @@ public:
     Control();
     ~Control();
 
-    Signal<ControlSignal> signal_control_received;
+    Signal<ControlSignal> signal_control_received{"control_received", SignalPriority::High};
 
     // 接收网络数据槽函数
     void onNetworkReceived(const std::string& data);
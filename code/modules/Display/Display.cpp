@@ -70,7 +70,7 @@ Display::~Display() {
  * 
  * @param frame 要显示的帧。
  */
-void Display::push_frame(const cv::Mat& frame) {
+void Display::push_frame(const VideoFrameRef& frame) {
     if (flag_quit) {
         return;
     }
@@ -81,9 +81,8 @@ void Display::push_frame(const cv::Mat& frame) {
 
     {
         std::lock_guard<std::mutex> lock(mtx_display);
-        if (frame_queue.size() < 10) { // 限制队列长度，避免内存占用过多
-            frame_queue.push(frame);
-        }
+        // 替换掉尚未显示的旧帧，避免占用帧池中的缓冲区
+        pending_frame = frame;
     }
     cond_var_display.notify_one(); // 唤醒显示线程
 }
@@ -94,6 +93,9 @@ void Display::push_frame(const cv::Mat& frame) {
 void Display::pause() {
     std::lock_guard<std::mutex> lock(mtx_display);
     flag_pause = true;
+    if (demand_callback) {
+        demand_callback(false);
+    }
 }
 
 /**
@@ -103,13 +105,29 @@ void Display::resume() {
     {
         std::lock_guard<std::mutex> lock(mtx_display);
         flag_pause = false;
-        while (!frame_queue.empty()) {
-            frame_queue.pop(); // 清空队列
+        pending_frame.reset(); // 丢弃暂停前的帧
+        if (demand_callback) {
+            demand_callback(!flag_quit);
         }
     }
     cond_var_display.notify_one(); // 唤醒显示线程继续工作
 }
 
+/**
+ * @brief 设置需求回调。
+ *
+ * 回调在持有显示锁时调用，只能做轻量处理。
+ *
+ * @param callback 显示可用且未暂停时参数为 true。
+ */
+void Display::set_demand_callback(std::function<void(bool)> callback) {
+    std::lock_guard<std::mutex> lock(mtx_display);
+    demand_callback = std::move(callback);
+    if (demand_callback) {
+        demand_callback(!flag_quit && !flag_pause);
+    }
+}
+
 /**
  * @brief 显示线程的运行函数。
  */
@@ -119,7 +137,7 @@ void Display::display_on_fb() {
 
         // 等待队列有数据或退出信号
         cond_var_display.wait(ulock, [this] {
-            return !frame_queue.empty() || flag_quit;
+            return pending_frame || flag_quit;
         });
 
         // 如果设置了退出标志，退出线程
@@ -135,30 +153,33 @@ void Display::display_on_fb() {
         }
 
         // 取出一帧
-        cv::Mat frame = frame_queue.front();
-        frame_queue.pop();
+        VideoFrameRef video_frame = std::move(pending_frame);
+        pending_frame.reset();
 
         ulock.unlock(); // 解锁以允许其他线程推送帧
 
-        if (frame.empty()) {
-            LOG_WARN("Empty frame received\n");
-            return;
+        if (!video_frame) {
+            continue;
         }
 
-        if (frame.type() != CV_8UC3) {
-            LOG_ERROR("Frame type mismatch, expect CV_8UC3 but got %d\n", frame.type());
+        if (video_frame->format != FrameFormat::BGR888) {
+            LOG_ERROR("Frame format mismatch, expect BGR888 but got %d\n", (int)video_frame->format);
             return;
         }
-        
+
+        // 帧数据由多个消费者共享，只读取，不在原地修改
+        cv::Mat frame = video_frame->mat();
         cv::Mat resized_frame;
         if (frame.rows != height || frame.cols != width) {
             cv::resize(frame, resized_frame, cv::Size(width, height));
         } else {
-            resized_frame = frame.clone();
+            resized_frame = frame;
         }
 
         cv::Mat rgb565_frame;
         cv::cvtColor(resized_frame, rgb565_frame, cv::COLOR_BGR2BGR565);
+        resized_frame.release();
+        video_frame.reset();    // 转换完成即归还帧池
 
         if (framebuffer_set_frame_rgb565((uint16_t*)rgb565_frame.data, width, height) != 0) {
             LOG_ERROR("Failed to set frame to framebuffer\n");
@@ -1,12 +1,13 @@
 #pragma once
 
-#include <queue>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <functional>
 #include <opencv2/opencv.hpp>
 
 #include "global.h"
+#include "frame_pool.h"
 
 class Display {
 public:
@@ -20,8 +21,8 @@ public:
         *bit_depth = this->bit_depth;
     }
 
-    // 接收帧并将其放入队列
-    void push_frame(const cv::Mat& frame);
+    // 接收帧，只保留最新的一帧，显示线程来不及显示的旧帧直接归还帧池
+    void push_frame(const VideoFrameRef& frame);
 
     // 暂停显示
     void pause();
@@ -29,6 +30,9 @@ public:
     // 继续显示
     void resume();
 
+    // 设置需求回调，显示可用且未暂停时为 true；设置时立即按当前状态调用一次，暂停和继续时再次调用
+    void set_demand_callback(std::function<void(bool)> callback);
+
 private:
     // 显示线程的运行函数
     void display_on_fb();
@@ -37,9 +41,10 @@ private:
     std::thread display_thread;
     bool flag_pause;
     bool flag_quit;
+    std::function<void(bool)> demand_callback;
 
-    // 线程安全的队列和同步机制
-    std::queue<cv::Mat> frame_queue;
+    // 待显示的帧及同步机制
+    VideoFrameRef pending_frame;
     std::mutex mtx_display;
     std::condition_variable cond_var_display;
 
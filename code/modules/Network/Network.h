@@ -29,7 +29,7 @@ public:
     // 从Control类接收数据并放入发送队列
     void send_data(const std::string& data);
 
-    Signal<std::string> signal_network_received;
+    Signal<std::string> signal_network_received{"network_received", SignalPriority::High};
 
 private:
     void run(); // 类运行线程
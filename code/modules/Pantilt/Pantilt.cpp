@@ -1,4 +1,5 @@
 #include "Pantilt.h"
+#include "param_snapshot.h"
 
 /**
  * @brief Pantilt 类构造函数。
@@ -17,22 +18,40 @@ Pantilt::Pantilt() {
     pwm_set_polarity(PWM9_M1, "normal");  // 设置 PWM9 输出极性为正常
     // pwm_enable(PWM9_M1, 1);  // 启用 PWM9
 
-    preset_pan = rk_param_get_int("ptz:preset_pan", 0);  // 读取俯仰预置点
-    preset_tilt = rk_param_get_int("ptz:preset_tilt", 0);  // 读取旋转预置点
-    preset_home_enable = rk_param_get_int("ptz:preset_home_enable", 0);  // 读取回位使能
-    preset_home_time = rk_param_get_int("ptz:preset_home_time", 30);  // 读取回位时间
+    applyConfig(*rk_param_snapshot());
 
-    if (preset_pan < left_limit || preset_pan > right_limit) {
-        preset_pan = 0;
-    }
-    if (preset_tilt < up_limit || preset_tilt > down_limit) {
-        preset_tilt = 0;
-    }
-    if (preset_home_time < 0) {
-        preset_home_time = 0;
+    reset();  // 初始化舵机角度
+
+    // 预置点修改后立即生效，回位使能切换时启动或停止归位检查线程
+    param_subscription = rk_param_subscribe("ptz", [this](const ParamChangePtr& change) {
+        applyConfig(*change->snapshot);
+    });
+}
+
+/**
+ * @brief 从参数快照读取预置点和回位设置。
+ */
+void Pantilt::applyConfig(const ParamSnapshot& config) {
+    // 取值范围由参数表校验，超出舵机行程的配置会报错并使用默认值
+    int pan = config.get(param_key::ptz_preset_pan);  // 读取俯仰预置点
+    int tilt = config.get(param_key::ptz_preset_tilt);  // 读取旋转预置点
+    int home_enable = config.get(param_key::ptz_preset_home_enable);  // 读取回位使能
+    int home_time = config.get(param_key::ptz_preset_home_time);  // 读取回位时间
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_home_position);
+        preset_pan = pan;
+        preset_tilt = tilt;
+        preset_home_time = home_time;
     }
+    // 唤醒归位线程，按新的回位时间重新计时
+    cv_home_position.notify_all();
 
-    reset();  // 初始化舵机角度
+    if (home_enable == preset_home_enable) {
+        return;
+    }
+    preset_home_enable = home_enable;
+    stopHomePositionThread();
 
     // 启动归位检查线程
     if (preset_home_enable) {
@@ -41,10 +60,28 @@ Pantilt::Pantilt() {
     }
 }
 
+/**
+ * @brief 停止归位检查线程。
+ */
+void Pantilt::stopHomePositionThread() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_home_position);
+        home_position_thread_run = false;
+    }
+    cv_home_position.notify_all();
+
+    if (home_position_thread.joinable()) {
+        home_position_thread.join();
+    }
+}
+
 /**
  * @brief Pantilt 类析构函数。
  */
 Pantilt::~Pantilt() {
+    // 先退订，之后参数通知线程不会再访问本对象
+    rk_param_unsubscribe(param_subscription);
+
     reset();  // 复位舵机
 
     pwm_enable(PWM8_M1, 0);  // 禁用 PWM8
@@ -53,12 +90,7 @@ Pantilt::~Pantilt() {
     pwm_enable(PWM9_M1, 0);  // 禁用 PWM9
     pwm_deinit(PWM9_M1);
 
-    home_position_thread_run = false;
-    cv_home_position.notify_all();
-
-    if (home_position_thread.joinable()) {
-        home_position_thread.join();
-    }
+    stopHomePositionThread();
 
     LOG_DEBUG("Pantilt module deinitialized\n");
 }
@@ -296,7 +328,7 @@ void Pantilt::homePositionCheck() {
         std::unique_lock<std::mutex> lock(mtx_home_position);
 
         // 如果当前不在归位位置，等待 preset_home_time 秒，检查线程退出或是否已归位
-        cv_home_position.wait_for(lock, std::chrono::seconds(preset_home_time), [this] {
+        cv_home_position.wait_for(lock, std::chrono::seconds(preset_home_time.load()), [this] {
             return !home_position_thread_run || has_operation;  // 等待条件：线程退出或有操作
         });
 
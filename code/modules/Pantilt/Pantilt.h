@@ -5,11 +5,14 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 
 extern "C" {
     #include "pwm.h"
 }
 
+class ParamSnapshot;
+
 class Pantilt {
 public:
     Pantilt();
@@ -47,11 +50,12 @@ private:
     const int min_duty_cycle_ns = 500000;
     const int max_duty_cycle_ns = 2500000;
 
-    // 云台预置点及回位时间
-    int preset_pan = 0;
-    int preset_tilt = 0;
+    // 云台预置点及回位时间，可在参数通知线程中更新
+    std::atomic<int> preset_pan{0};
+    std::atomic<int> preset_tilt{0};
     int preset_home_enable = 0;
-    int preset_home_time = 0;
+    std::atomic<int> preset_home_time{0};
+    int param_subscription = 0;     // [ptz] 变更订阅
 
     // 是否有操作
     bool has_operation = false;  
@@ -71,6 +75,12 @@ private:
     // 检查并自动归位
     void homePositionCheck();
 
+    // 停止归位检查线程
+    void stopHomePositionThread();
+
+    // 应用 [ptz] 配置
+    void applyConfig(const ParamSnapshot& config);
+
     // 辅助函数：将角度映射为 PWM 占空比
     unsigned int mapAngleToDutyCycle(int angle, int max_angle);
 };
@@ -1,4 +1,24 @@
 #include "Video.h"
+#include "param_snapshot.h"
+
+// 取一帧编码码流发送到 RTSP，并记录 GetStream 和发送完成的时间
+// trace 中没有采集时间时使用码流的 PTS（VI 绑定 VENC 时即为 VI 采集时间）
+static void rtsp_send_frame_traced(int vencChannelId, VENC_STREAM_S *stFrame, FrameTrace &trace)
+{
+    if (rtsp_get_stream(vencChannelId, stFrame) != 0) {
+        return;
+    }
+    trace.mark(LatencyStage::EncodeGetStream);
+    if (trace.pts_us == 0) {
+        trace.pts_us = stFrame->pstPack->u64PTS;
+    }
+    rtsp_tx_stream(vencChannelId, stFrame);
+    trace.mark(LatencyStage::RtspTx);
+    LatencyTracer::instance().submit(trace);
+    RateController::instance().onFrameSent(vencChannelId, stFrame->pstPack->u32Len,
+                                           trace.stage_us[(size_t)LatencyStage::RtspTx] -
+                                               trace.stage_us[(size_t)LatencyStage::EncodeGetStream]);
+}
 
 Video::Video()
 {
@@ -10,7 +30,7 @@ Video::Video()
 
     // 初始化ROI检测器
     roi_detector = std::make_unique<RoiDetector>();
-    roi_detector->registerAlarmCallback([this](const AlarmInfo& alarm) {
+    roi_detector->registerAlarmCallback([this](const AlarmEventPtr& alarm) {
         this->handleAlarm(alarm);
     });
     
@@ -18,6 +38,22 @@ Video::Video()
     g_alarm_pusher.init();
     g_alarm_pusher.start();
 
+    letterbox_scale = 0;
+    letterbox_offset_x = 0;
+    letterbox_offset_y = 0;
+    letterbox_src_width = 0;
+    letterbox_src_height = 0;
+
+    // AI 直接使用子码流已经转换好的 BGR 帧，不再单独占用 VI 通道和做颜色转换；
+    // 推理跟不上时只保留最新的一帧
+    ParamSnapshotPtr config = rk_param_snapshot();
+    ai_from_substream = config->get(param_key::ai_enable) && config->get(param_key::ai_input_substream);
+    if (ai_from_substream) {
+        signal_video_frame.connect([this](const VideoFrameRef& frame) {
+            this->onAiFrame(frame);
+        }, DeliveryPolicy::CoalesceLatest);
+    }
+
     rkaiq_init();
     rkmpi_sys_init();
     vi_dev_init();
@@ -26,7 +62,8 @@ Video::Video()
     video_thread0 = std::make_unique<std::thread>(&Video::video_pipe0, this);
     video_thread1 = std::make_unique<std::thread>(&Video::video_pipe1, this);
     
-    int ai_enable = rk_param_get_int("ai:enable", 0);
+    // 隐私遮挡由 AI 线程维护，只开启遮挡时也启动
+    bool ai_enable = config->get(param_key::ai_enable) || config->get(param_key::ai_privacy_enable);
     if (ai_enable) {
         video_thread2 = std::make_unique<std::thread>(&Video::video_pipe2, this);
     }
@@ -59,8 +96,9 @@ void Video::video_pipe0()
     int pipeId = 0;
     int viChannelId = 0;
     int vencChannelId = 0;
-    int video_width = rk_param_get_int("video.0:width", 2304);
-    int video_height = rk_param_get_int("video.0:height", 1296);
+    ParamSnapshotPtr config = rk_param_snapshot();
+    int video_width = config->get(param_key::video0_width);
+    int video_height = config->get(param_key::video0_height);
     // int video_width = 2304;
     // int video_height = 1296;
 
@@ -70,6 +108,7 @@ void Video::video_pipe0()
 
     vi_chn_init(pipeId, viChannelId, video_width, video_height, RK_FMT_YUV420SP);
     venc_init(vencChannelId, video_width, video_height, RK_VIDEO_ID_AVC, RK_FMT_YUV420SP);
+    RateController::instance().attach(vencChannelId);
 
     MPP_CHN_S vi_chn, venc_chn;
     bind_vi_to_venc(pipeId, &vi_chn, &venc_chn);
@@ -79,7 +118,8 @@ void Video::video_pipe0()
     while (video_run_ && pipe0_run_)
     {
         // 获取编码后的帧，发送到 RTSP 服务器
-        rtsp_send_frame(vencChannelId, &stFrame);
+        FrameTrace trace(LatencyPipe::Main);
+        rtsp_send_frame_traced(vencChannelId, &stFrame, trace);
 
         // 释放编码后的帧
         venc_release_frame(vencChannelId, &stFrame);
@@ -90,6 +130,7 @@ void Video::video_pipe0()
     // wait for ai rgn to deinit
     usleep(500 * 1000);
     unbind_vi_to_venc(pipeId, &vi_chn, &venc_chn);
+    RateController::instance().detach(vencChannelId);
     venc_deinit(vencChannelId);
     vi_chn_deinit(pipeId, viChannelId);
     free(stFrame.pstPack);
@@ -101,11 +142,17 @@ void Video::video_pipe1()
     int pipeId = 0;
     int viChannelId = 1;
     int vencChannelId = 1;
-    int video_width = rk_param_get_int("video.1:width", 704);
-    int video_height = rk_param_get_int("video.1:height", 576);
+    ParamSnapshotPtr config = rk_param_snapshot();
+    int video_width = config->get(param_key::video1_width);
+    int video_height = config->get(param_key::video1_height);
     // int video_width = 704;
     // int video_height = 576;
 
+    if (config->get(param_key::video1_venc_bind)) {
+        video_pipe1_bound(config);
+        return;
+    }
+
 #if FPS_SHOW
     char fps_text[16];
     float fps = 0;
@@ -119,9 +166,16 @@ void Video::video_pipe1()
     VIDEO_FRAME_INFO_S stViFrame;
     stFrame.pstPack = (VENC_PACK_S *)malloc(sizeof(VENC_PACK_S));
 
-    MB_BLK src_blk;
-    MB_POOL src_Pool;
-    create_MB_pool(&src_blk, &src_Pool, video_width, video_height);
+    // 帧池中的缓冲区依次用于颜色转换、编码和发布，消费者释放最后一个引用后才会被复用；
+    // 另留一块不发布的备用缓冲区，消费者占满帧池时视频编码不受影响
+    std::shared_ptr<FramePool> frame_pool = FramePool::create(video_width, video_height, FrameFormat::BGR888,
+                                                              kFramePoolSize + (ai_from_substream ? kAiFrameRefs : 0) + 1);
+    if (!frame_pool) {
+        free(stFrame.pstPack);
+        return;
+    }
+    VideoFrameRef spare_frame = frame_pool->acquire();
+    uint64_t pool_exhausted = 0;
 
     // Build venc_frame
     VIDEO_FRAME_INFO_S venc_frame;
@@ -131,48 +185,157 @@ void Video::video_pipe1()
     venc_frame.stVFrame.u32VirHeight = video_height;
     venc_frame.stVFrame.enPixelFormat = RK_FMT_RGB888;
     venc_frame.stVFrame.u32FrameFlag = 160;
-    venc_frame.stVFrame.pMbBlk = src_blk;
-    unsigned char *venc_data = (unsigned char *)RK_MPI_MB_Handle2VirAddr(src_blk);
-    cv::Mat frame(cv::Size(video_width, video_height), CV_8UC3, venc_data);
     cv::Mat yuv420sp(video_height + video_height / 2, video_width, CV_8UC1);
-    cv::Mat bgr(video_height, video_width, CV_8UC3);
 
     vi_chn_init(pipeId, viChannelId, video_width, video_height, RK_FMT_YUV420SP);
     venc_init(vencChannelId, video_width, video_height, RK_VIDEO_ID_AVC, RK_FMT_RGB888);
+    RateController::instance().attach(vencChannelId);
+
+    // 预览图 JPEG 编码，只在有 HTTP 观看者时工作
+    int previewVencChannelId = 3;
+    preview_cache.start(video_width, video_height,
+                        config->get(param_key::video1_preview_fps),
+                        config->get(param_key::video1_preview_quality),
+                        config->get(param_key::video1_preview_jpeg_hw) ? previewVencChannelId : -1);
 
     while (video_run_ && pipe1_run_)
     {
         void *vi_data = vi_get_frame(pipeId, viChannelId, video_width, video_height, &stViFrame);
+        FrameTrace trace(LatencyPipe::Sub, stViFrame.stVFrame.u64PTS);
+        trace.mark(LatencyStage::ViGet);
+
+        VideoFrameRef frame = frame_pool->acquire();
+        bool publish = (bool)frame;
+        if (!publish) {
+            if (pool_exhausted++ % 100 == 0) {
+                LOG_WARN("Video frame pool exhausted (%llu times), frame not published\n",
+                         (unsigned long long)pool_exhausted);
+            }
+            frame = spare_frame;
+        }
+        frame->pts_us = stViFrame.stVFrame.u64PTS;
 
+        // 直接转换到帧缓冲区中，编码和所有消费者都使用这一份数据
+        cv::Mat bgr = frame->mat();
         yuv420sp.data = (unsigned char *)vi_data;
-        bgr.data = venc_data;
         cv::cvtColor(yuv420sp, bgr, cv::COLOR_YUV420sp2BGR);
-        cv::resize(bgr, frame, cv::Size(video_width, video_height), 0, 0, cv::INTER_LINEAR);
-        // cv::resize(bgr, frame, cv::Size(video_width ,video_height), 0, 0, cv::INTER_NEAREST);
+        vi_release_frame(pipeId, viChannelId, &stViFrame);
+        trace.mark(LatencyStage::Convert);
 #if FPS_SHOW
         sprintf(fps_text, "fps = %.2f", fps);
-        cv::putText(frame, fps_text,
+        cv::putText(bgr, fps_text,
                     cv::Point(x_scaled, y_scaled),
                     cv::FONT_HERSHEY_SIMPLEX, 1,
                     cv::Scalar(0, 255, 0), 1);
 #endif
-        memcpy(venc_data, frame.data, video_width * video_height * 3);
-        signal_video_frame.emit(frame);
+        if (publish) {
+            signal_video_frame.emit(frame);
+            preview_cache.offer(frame);
+        }
 
+        venc_frame.stVFrame.pMbBlk = frame->blk;
         venc_encode_frame(vencChannelId, &venc_frame);
-        rtsp_send_frame(vencChannelId, &stFrame);
+        trace.mark(LatencyStage::EncodeSubmit);
+        rtsp_send_frame_traced(vencChannelId, &stFrame, trace);
 #if FPS_SHOW
         RK_U64 nowUs = TEST_COMM_GetNowUs();
         fps = (float)1000000 / (float)(nowUs - venc_frame.stVFrame.u64PTS);
 #endif
-        vi_release_frame(pipeId, viChannelId, &stViFrame);
         venc_release_frame(vencChannelId, &stFrame);
     }
 
+    preview_cache.stop();
+    RateController::instance().detach(vencChannelId);
+    venc_deinit(vencChannelId);
+    vi_chn_deinit(pipeId, viChannelId);
+    free(stFrame.pstPack);
+}
+
+// 子码流由 VI 直接绑定 VENC 编码，CPU 不参与；
+// 显示和预览需要的 BGR 帧另外从 VI 通道读取，只在有消费者时按 branch_fps 转换
+void Video::video_pipe1_bound(const ParamSnapshotPtr& config)
+{
+    int pipeId = 0;
+    int viChannelId = 1;
+    int vencChannelId = 1;
+    int video_width = config->get(param_key::video1_width);
+    int video_height = config->get(param_key::video1_height);
+    uint64_t branch_interval_us = 1000000 / config->get(param_key::video1_branch_fps);
+
+    VENC_STREAM_S stFrame;
+    VIDEO_FRAME_INFO_S stViFrame;
+    stFrame.pstPack = (VENC_PACK_S *)malloc(sizeof(VENC_PACK_S));
+
+    // 分支不参与编码，帧池用完时跳过本次转换即可，不需要备用缓冲区
+    std::shared_ptr<FramePool> frame_pool = FramePool::create(video_width, video_height, FrameFormat::BGR888,
+                                                              kFramePoolSize + (ai_from_substream ? kAiFrameRefs : 0));
+    cv::Mat yuv420sp(video_height + video_height / 2, video_width, CV_8UC1);
+
+    // VI 通道保留 1 帧供分支读取，其余帧直接送入 VENC
+    vi_chn_init_with_depth(pipeId, viChannelId, video_width, video_height, RK_FMT_YUV420SP, 1);
+    venc_init(vencChannelId, video_width, video_height, RK_VIDEO_ID_AVC, RK_FMT_YUV420SP);
+    RateController::instance().attach(vencChannelId);
+
+    MPP_CHN_S vi_chn, venc_chn;
+    bind_vi_chn_to_venc(viChannelId, vencChannelId, &vi_chn, &venc_chn);
+
+    // 预览图 JPEG 编码，只在有 HTTP 观看者时工作
+    int previewVencChannelId = 3;
+    preview_cache.start(video_width, video_height,
+                        config->get(param_key::video1_preview_fps),
+                        config->get(param_key::video1_preview_quality),
+                        config->get(param_key::video1_preview_jpeg_hw) ? previewVencChannelId : -1);
+
+    LOG_INFO("Video pipe 1 bound to VENC %d, branch max %llu fps\n",
+             vencChannelId, (unsigned long long)(1000000 / branch_interval_us));
+
+    uint64_t next_branch_us = 0;
+    while (video_run_ && pipe1_run_)
+    {
+        // 获取编码后的帧，发送到 RTSP 服务器
+        FrameTrace trace(LatencyPipe::Sub);
+        rtsp_send_frame_traced(vencChannelId, &stFrame, trace);
+        venc_release_frame(vencChannelId, &stFrame);
+
+        // 没有消费者或未到转换时间时不读取 VI 帧
+        uint64_t now = TEST_COMM_GetNowUs();
+        if (!frame_pool || now < next_branch_us) {
+            continue;
+        }
+        if (frame_demand.load(std::memory_order_relaxed) == 0 && !preview_cache.hasDemand()) {
+            continue;
+        }
+        VideoFrameRef frame = frame_pool->acquire();
+        if (!frame) {
+            continue;
+        }
+        void *vi_data = vi_get_frame(pipeId, viChannelId, video_width, video_height, &stViFrame);
+        if (vi_data == NULL) {
+            continue;
+        }
+        next_branch_us = now + branch_interval_us;
+
+        // 分支帧单独记录，只包含取帧和颜色转换
+        FrameTrace branch_trace(LatencyPipe::Sub, stViFrame.stVFrame.u64PTS);
+        branch_trace.mark(LatencyStage::ViGet);
+        frame->pts_us = stViFrame.stVFrame.u64PTS;
+        cv::Mat bgr = frame->mat();
+        yuv420sp.data = (unsigned char *)vi_data;
+        cv::cvtColor(yuv420sp, bgr, cv::COLOR_YUV420sp2BGR);
+        vi_release_frame(pipeId, viChannelId, &stViFrame);
+        branch_trace.mark(LatencyStage::Convert);
+        LatencyTracer::instance().submit(branch_trace);
+
+        signal_video_frame.emit(frame);
+        preview_cache.offer(frame);
+    }
+
+    preview_cache.stop();
+    unbind_vi_chn_to_venc(&vi_chn, &venc_chn);
+    RateController::instance().detach(vencChannelId);
     venc_deinit(vencChannelId);
     vi_chn_deinit(pipeId, viChannelId);
     free(stFrame.pstPack);
-    destroy_MB_pool(&src_blk, &src_Pool);
 }
 
 void Video::video_pipe2()
@@ -196,13 +359,29 @@ void Video::video_pipe2()
     // 70: 'toaster', 71: 'sink', 72: 'refrigerator', 73: 'book', 74: 'clock', 
     // 75: 'vase', 76: 'scissors', 77: 'teddy bear', 78: 'hair drier', 79: 'toothbrush'
 
-    int ai_od_enable = rk_param_get_int("ai.od:enable", 0);
-    int line_pixel = rk_param_get_int("ai.od:line_pixel", 2);
+    // 模型路径等字符串指向快照，整个线程期间持有同一份快照
+    ParamSnapshotPtr config = rk_param_snapshot();
+    // 只开启隐私遮挡时本线程也会启动，不做目标检测
+    bool ai_od_enable = config->get(param_key::ai_enable) && config->get(param_key::ai_od_enable);
+    int line_pixel = config->get(param_key::ai_od_line_pixel);
+
+    // 人员隐私遮挡，区域句柄在这里一次性创建。不依赖目标检测开关，
+    // 在第一帧检测结果之前、以及检测不可用时遮挡整幅画面
+    PrivacyMask privacy_mask;
+    if (config->get(param_key::ai_privacy_enable)) {
+        // wait for venc to start
+        usleep(500 * 1000);
+        if (privacy_mask.init()) {
+            privacy_mask.cover();
+        } else {
+            LOG_ERROR("privacy mask could not be created, streams are NOT masked\n");
+        }
+    }
 
     if (ai_od_enable) {
-        int people_detect = rk_param_get_int("ai.od:people_detect", 0);     // class 0
-        int vehicle_detect = rk_param_get_int("ai.od:vehicle_detect", 0);   // class 1,2,3,4,5,7,8
-        int pet_detect = rk_param_get_int("ai.od:pet_detect", 0);           // class 15,16
+        bool people_detect = config->get(param_key::ai_od_people_detect);     // class 0
+        bool vehicle_detect = config->get(param_key::ai_od_vehicle_detect);   // class 1,2,3,4,5,7,8
+        bool pet_detect = config->get(param_key::ai_od_pet_detect);           // class 15,16
         
         // detect classes set
         std::unordered_set<int> detect_classes;
@@ -223,16 +402,16 @@ void Video::video_pipe2()
             detect_classes.insert(16);
         }
 
-        int ai_follow_enable = rk_param_get_int("ai.follow:enable", 0);
-        int ai_follow_people = rk_param_get_int("ai.follow:people_follow", 0);
-        int ai_follow_vehicle = rk_param_get_int("ai.follow:vehicle_follow", 0);
-        int ai_follow_pet = rk_param_get_int("ai.follow:pet_follow", 0);
-        int ai_follow_tolerance_width = rk_param_get_int("ai.follow:tolerance_width", 100);
-        int ai_follow_tolerance_height = rk_param_get_int("ai.follow:tolerance_height", 100);
-        int ai_follow_roi_x = rk_param_get_int("ai.follow:roi_x", 0);
-        int ai_follow_roi_y = rk_param_get_int("ai.follow:roi_y", 0);
-        int ai_follow_roi_width = rk_param_get_int("ai.follow:roi_width", 2304);
-        int ai_follow_roi_height = rk_param_get_int("ai.follow:roi_height", 1296);
+        bool ai_follow_enable = config->get(param_key::ai_follow_enable);
+        bool ai_follow_people = config->get(param_key::ai_follow_people);
+        bool ai_follow_vehicle = config->get(param_key::ai_follow_vehicle);
+        bool ai_follow_pet = config->get(param_key::ai_follow_pet);
+        int ai_follow_tolerance_width = config->get(param_key::ai_follow_tolerance_width);
+        int ai_follow_tolerance_height = config->get(param_key::ai_follow_tolerance_height);
+        int ai_follow_roi_x = config->get(param_key::ai_follow_roi_x);
+        int ai_follow_roi_y = config->get(param_key::ai_follow_roi_y);
+        int ai_follow_roi_width = config->get(param_key::ai_follow_roi_width);
+        int ai_follow_roi_height = config->get(param_key::ai_follow_roi_height);
 
         // follow classes set
         std::unordered_set<int> follow_classes;
@@ -262,22 +441,23 @@ void Video::video_pipe2()
 
         // Rknn model
         int sX, sY, eX, eY;
-        char text[16];
         rknn_app_context_t rknn_app_ctx;
         object_detect_result_list od_results;
         
         // 从配置文件读取模型路径，如果配置文件未指定，则使用默认路径
-        const char *model_path = rk_param_get_string("ai.model:path", "./model/yolov5.rknn");
-        const char *label_path = rk_param_get_string("ai.model:label", "./model/coco_80_labels_list.txt");
+        const char *model_path = config->get(param_key::ai_model_path);
+        const char *label_path = config->get(param_key::ai_model_label);
         
         // 检查模型文件是否存在
         if (access(model_path, F_OK) != 0) {
             LOG_ERROR("AI model file %s does not exist\n", model_path);
             // 如果模型文件不存在，直接返回，不初始化AI功能
+            privacy_hold_cover(privacy_mask, "AI model missing");
             return;
         }
         if (access(label_path, F_OK) != 0) {
             LOG_ERROR("AI label file %s does not exist\n", label_path);
+            privacy_hold_cover(privacy_mask, "AI label file missing");
             return;
         }
         
@@ -286,11 +466,13 @@ void Video::video_pipe2()
         // 初始化AI模型，如果失败则直接返回
         if (init_yolov5_model(model_path, &rknn_app_ctx) != 0) {
             LOG_ERROR("Failed to initialize AI model\n");
+            privacy_hold_cover(privacy_mask, "AI model failed to load");
             return;
         }
         if (init_post_process(label_path) != 0) {
             LOG_ERROR("Failed to initialize post process\n");
             release_yolov5_model(&rknn_app_ctx);
+            privacy_hold_cover(privacy_mask, "AI post process failed to load");
             return;
         }
 
@@ -312,8 +494,8 @@ void Video::video_pipe2()
         // int video_height = 640;
         int video_width = MODEL_WIDTH;
         int video_height = MODEL_HEIGHT;
-        int rgn_video_width = 2304;
-        int rgn_video_height = 1296;
+        int rgn_video_width = config->get(param_key::video0_width);
+        int rgn_video_height = config->get(param_key::video0_height);
         int rgn_square_size = rgn_video_width * rgn_video_height;
 
         // video frame container
@@ -321,25 +503,83 @@ void Video::video_pipe2()
         cv::Mat yuv420sp(video_height + video_height / 2, video_width, CV_8UC1);
         cv::Mat bgr(video_height, video_width, CV_8UC3);
 
-        vi_chn_init(pipeId, viChannelId, video_width, video_height, RK_FMT_YUV420SP);
+        // letterbox 直接写入模型输入内存
+        cv::Mat model_input(MODEL_HEIGHT, MODEL_WIDTH, CV_8UC3, rknn_app_ctx.input_mems[0]->virt_addr);
+        letterbox_scale = 0;
+
+        if (ai_from_substream) {
+            LOG_INFO("AI input taken from sub-stream frames\n");
+            set_frame_demand(FrameConsumer::Ai, true);
+        } else {
+            vi_chn_init(pipeId, viChannelId, video_width, video_height, RK_FMT_YUV420SP);
+        }
+
+        uint64_t frame_seq = 0;
+
+        // OSD 检测框的跟踪器，只用于估计目标速度，绘制时按延迟外推
+        BYTETracker osd_tracker;
+        std::vector<Object> osd_objects;
+
+        std::vector<Object> privacy_people;
+
+        // 主码流 ROI 编码：人员和车辆
+        RoiEncoder roi_encoder;
+        roi_encoder.init(0);
+        std::vector<Object> roi_subjects;
+        const std::unordered_set<int> roi_classes = {0, 1, 2, 3, 4, 5, 7, 8};
+        // 主码流空闲档按人员和车辆判断，不受 OSD 检测类别开关和 ROI 编码开关影响
+        bool activity = false;
 
         while (video_run_ && pipe2_run_)
         {
-            // usleep(100 * 1000);
-            // get vi frame
-            yuv420sp.data = (unsigned char *)vi_get_frame(pipeId, viChannelId, video_width, video_height, &stViFrame);
-            cv::cvtColor(yuv420sp, bgr, cv::COLOR_YUV420sp2BGR);
-            // cv::resize(bgr, bgr, cv::Size(video_width, video_height), 0, 0, cv::INTER_LINEAR);
-
-            // letterbox
-            cv::Mat letterboxImage = letterbox(bgr, video_width, video_height);
-            memcpy(rknn_app_ctx.input_mems[0]->virt_addr, letterboxImage.data, MODEL_HEIGHT * MODEL_HEIGHT * 3);
+            FrameTrace trace(LatencyPipe::Ai);
+            if (ai_from_substream) {
+                // 子码流帧保持源图像比例缩放到模型输入，转换完立即归还
+                VideoFrameRef frame = waitAiFrame(500);
+                if (!frame) {
+                    continue;
+                }
+                trace.pts_us = frame->pts_us;
+                trace.mark(LatencyStage::ViGet);
+                letterbox(frame->mat(), model_input);
+            } else {
+                // usleep(100 * 1000);
+                // get vi frame
+                yuv420sp.data = (unsigned char *)vi_get_frame(pipeId, viChannelId, video_width, video_height, &stViFrame);
+                trace.pts_us = stViFrame.stVFrame.u64PTS;
+                trace.mark(LatencyStage::ViGet);
+                cv::cvtColor(yuv420sp, bgr, cv::COLOR_YUV420sp2BGR);
+                vi_release_frame(pipeId, viChannelId, &stViFrame);
+                trace.mark(LatencyStage::Convert);
+                // cv::resize(bgr, bgr, cv::Size(video_width, video_height), 0, 0, cv::INTER_LINEAR);
+
+                // letterbox
+                letterbox(bgr, model_input);
+            }
+            trace.mark(LatencyStage::Preprocess);
 
             // inference
-            inference_yolov5_model(&rknn_app_ctx, &od_results);
+            if (run_yolov5_model(&rknn_app_ctx) < 0) {
+                continue;
+            }
+            trace.mark(LatencyStage::Inference);
+            post_process_yolov5_model(&rknn_app_ctx, &od_results);
+            trace.mark(LatencyStage::PostProcess);
 
             // draw osd
             std::vector<RgnDrawParams> tasks(20);
+            size_t first_box = tasks.size();
+            osd_objects.clear();
+            privacy_people.clear();
+            roi_subjects.clear();
+            activity = false;
+
+            // 本帧检测结果摘要
+            auto summary = std::make_shared<DetectionSummary>();
+            summary->frame_seq = ++frame_seq;
+            summary->width = rgn_video_width;
+            summary->height = rgn_video_height;
+            summary->timestamp = std::chrono::system_clock::now();
             // printf("od_results.count: %d\n", od_results.count);
 
             // init follow target info
@@ -363,21 +603,41 @@ void Video::video_pipe2()
                 {
                     object_detect_result *det_result = &(od_results.results[i]);
 
+                    sX = (int)(det_result->box.left);
+                    sY = (int)(det_result->box.top);
+                    eX = (int)(det_result->box.right);
+                    eY = (int)(det_result->box.bottom);
+                    mapCoordinates(&sX, &sY);
+                    mapCoordinates(&eX, &eY);
+                    sX = (int)((float)sX / (float)letterbox_src_width * rgn_video_width);
+                    sY = (int)((float)sY / (float)letterbox_src_height * rgn_video_height);
+                    eX = (int)((float)eX / (float)letterbox_src_width * rgn_video_width);
+                    eY = (int)((float)eY / (float)letterbox_src_height * rgn_video_height);
+
+                    // 隐私遮挡不受检测类别开关影响，所有人员都遮挡
+                    if (privacy_mask.enabled() && det_result->cls_id == 0)
+                    {
+                        Object person;
+                        person.rect = cv::Rect(sX, sY, eX - sX, eY - sY);
+                        person.label = det_result->cls_id;
+                        person.prob = det_result->prop;
+                        privacy_people.push_back(person);
+                    }
+
+                    activity = activity || roi_classes.count(det_result->cls_id) > 0;
+                    if (roi_encoder.enabled() && roi_classes.count(det_result->cls_id) > 0)
+                    {
+                        Object subject;
+                        subject.rect = cv::Rect(sX, sY, eX - sX, eY - sY);
+                        subject.label = det_result->cls_id;
+                        subject.prob = det_result->prop;
+                        roi_subjects.push_back(subject);
+                    }
+
                     if (detect_classes.count(det_result->cls_id) > 0)
                     {
                         // if (det_result->cls_id > 8) continue;
 
-                        sX = (int)(det_result->box.left);
-                        sY = (int)(det_result->box.top);
-                        eX = (int)(det_result->box.right);
-                        eY = (int)(det_result->box.bottom);
-                        mapCoordinates(&sX, &sY);
-                        mapCoordinates(&eX, &eY);
-                        sX = (int)((float)sX / (float)video_width * rgn_video_width);
-                        sY = (int)((float)sY / (float)video_height * rgn_video_height);
-                        eX = (int)((float)eX / (float)video_width * rgn_video_width);
-                        eY = (int)((float)eY / (float)video_height * rgn_video_height);
-                        
                         RgnDrawParams task;
                         task.RgnHandle = RgnHandle;
                         task.x = sX;
@@ -385,9 +645,20 @@ void Video::video_pipe2()
                         task.w = eX - sX;
                         task.h = eY - sY;
                         task.line_pixel = line_pixel;
-                        snprintf(text, sizeof(text), "%s %.1f", coco_cls_to_name(det_result->cls_id), det_result->prop * 100.0f);
-                        task.label = text;
+                        snprintf(task.label, sizeof(task.label), "%s", coco_cls_to_name(det_result->cls_id));
+                        task.vx = 0;
+                        task.vy = 0;
+                        task.score = det_result->prop;
+                        task.track_id = 0;
                         tasks.push_back(task);
+
+                        Object object;
+                        object.rect = cv::Rect(sX, sY, eX - sX, eY - sY);
+                        object.label = det_result->cls_id;
+                        object.prob = det_result->prop;
+                        osd_objects.push_back(object);
+
+                        summary->objects.push_back({det_result->cls_id, det_result->prop, cv::Rect(sX, sY, eX - sX, eY - sY)});
                     }
 
                     // 更新跟随目标坐标，若有多个目标则选择置信度最高的目标，
@@ -450,9 +721,25 @@ void Video::video_pipe2()
                     }
                 }
             }
-            rgn_add_draw_tasks_batch(tasks);
+            // 跟踪结果与输入一一对应，把速度和跟踪 ID 填入对应的检测框
+            if (!osd_objects.empty()) {
+                std::vector<Object> tracked = osd_tracker.update(osd_objects, trace.pts_us);
+                for (size_t k = 0; k < tracked.size() && first_box + k < tasks.size(); k++) {
+                    tasks[first_box + k].vx = tracked[k].vx;
+                    tasks[first_box + k].vy = tracked[k].vy;
+                    tasks[first_box + k].track_id = tracked[k].track_id;
+                }
+            }
+
+            privacy_mask.update(privacy_people, trace.pts_us);
+            roi_encoder.update(roi_subjects, trace.pts_us);
 
-            vi_release_frame(pipeId, viChannelId, &stViFrame);
+            // 画布更新由绘制线程按同一个采集时间记录，检测框也按该时间外推
+            rgn_add_draw_tasks_batch(tasks, trace.pts_us);
+            trace.mark(LatencyStage::DrawEnqueue);
+            LatencyTracer::instance().submit(trace);
+            signal_detections.emit(summary);
+            RateController::instance().setActivity(0, activity);
 
             if (ai_follow_enable && is_follow_target_detected)
             {
@@ -493,10 +780,37 @@ void Video::video_pipe2()
             }
         }
 
+        // AI 停止后没有活动信号，主码流回到正常档
+        RateController::instance().setActivity(0, true);
         rgn_draw_nn_deinit();
-        vi_chn_deinit(pipeId, viChannelId);
+        privacy_mask.deinit();
+        roi_encoder.deinit();
+        if (ai_from_substream) {
+            set_frame_demand(FrameConsumer::Ai, false);
+        } else {
+            vi_chn_deinit(pipeId, viChannelId);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx_ai_frame);
+            ai_frame.reset();
+        }
         release_yolov5_model(&rknn_app_ctx);
         deinit_post_process();
+    } else {
+        privacy_hold_cover(privacy_mask, "object detection is disabled");
+    }
+}
+
+// 隐私遮挡开启但目标检测不可用时遮挡整幅画面，保持到本线程停止
+void Video::privacy_hold_cover(PrivacyMask& mask, const char* reason)
+{
+    if (!mask.enabled()) {
+        return;
+    }
+    LOG_ERROR("privacy mask: %s, covering the whole frame\n", reason);
+    mask.cover();
+    while (video_run_ && pipe2_run_) {
+        usleep(100 * 1000);
     }
 }
 
@@ -511,8 +825,9 @@ void Video::video_pipe0_start() {
         }
         pipe0_run_ = true;  // 设置运行标志位
         video_thread0 = std::make_unique<std::thread>(&Video::video_pipe0, this);
-        // 若 AI 使能则启动 AI 线程
-        int ai_enable = rk_param_get_int("ai:enable", 0);
+        // 若 AI 或隐私遮挡使能则启动 AI 线程
+        ParamSnapshotPtr config = rk_param_snapshot();
+        bool ai_enable = config->get(param_key::ai_enable) || config->get(param_key::ai_privacy_enable);
         if (ai_enable && !pipe2_run_) {
             pipe2_run_ = true;
             video_thread2 = std::make_unique<std::thread>(&Video::video_pipe2, this);
@@ -586,7 +901,8 @@ void Video::video_pipe2_start() {
     {
         // 线程2依赖线程0
         std::lock_guard<std::mutex> lock(mtx_video);
-        int ai_enable = rk_param_get_int("ai:enable", 0);
+        ParamSnapshotPtr config = rk_param_snapshot();
+        bool ai_enable = config->get(param_key::ai_enable) || config->get(param_key::ai_privacy_enable);
         // 若ai未使能或者线程2已经启动或者线程1未启动则直接返回
         if (!ai_enable) {
             LOG_ERROR("AI is disabled\n");
@@ -641,11 +957,7 @@ bool Video::reload_roi_config() {
     
     if (success) {
         LOG_INFO("ROI configuration reloaded successfully\n");
-        
-        // 重新初始化告警推送模块，读取可能更新的推送设置
-        g_alarm_pusher.stop();
-        g_alarm_pusher.init();
-        g_alarm_pusher.start();
+        // 告警推送设置通过 [alarm] 参数订阅自动更新，无需重启推送模块
     } else {
         LOG_ERROR("Failed to reload ROI configuration\n");
     }
@@ -654,48 +966,85 @@ bool Video::reload_roi_config() {
 }
 
 // 处理告警事件
-void Video::handleAlarm(const AlarmInfo& alarm) {
+void Video::handleAlarm(const AlarmEventPtr& alarm) {
     // 将告警信息推送到告警处理模块
     g_alarm_pusher.onAlarm(alarm);
     
     LOG_DEBUG("Alarm triggered: class=%d(%s), confidence=%.2f, position=(%d,%d,%d,%d)\n",
-            alarm.class_id, alarm.class_name.c_str(), alarm.confidence, 
-            alarm.box.x, alarm.box.y, alarm.box.width, alarm.box.height);
+            alarm->class_id, alarm->className(), alarm->confidence, 
+            alarm->box.x, alarm->box.y, alarm->box.width, alarm->box.height);
 }
 
 // 实现letterbox预处理，用于AI模型推理前的图像预处理
-cv::Mat Video::letterbox(const cv::Mat &image, int w, int h) {
+// 按比例缩放到 dst 中央，其余部分为黑边，并记录布局供 mapCoordinates 还原坐标
+void Video::letterbox(const cv::Mat &image, cv::Mat &dst) {
     int image_width = image.cols;
     int image_height = image.rows;
-    
-    // 创建正方形图像
-    cv::Mat square = cv::Mat::zeros(h, w, CV_8UC3);
-    
+
     // 计算缩放比例
-    float scale = std::min((float)w / image_width, (float)h / image_height);
-    
+    float scale = std::min((float)dst.cols / image_width, (float)dst.rows / image_height);
+
     // 计算缩放后的尺寸
     int scaled_width = int(image_width * scale);
     int scaled_height = int(image_height * scale);
-    
-    // 缩放图像
-    cv::Mat resized;
-    cv::resize(image, resized, cv::Size(scaled_width, scaled_height));
-    
+
     // 计算偏移量，使图像居中
-    int offset_x = (w - scaled_width) / 2;
-    int offset_y = (h - scaled_height) / 2;
-    
-    // 将缩放后的图像复制到正方形图像的中心
-    resized.copyTo(square(cv::Rect(offset_x, offset_y, scaled_width, scaled_height)));
-    
-    return square;
+    int offset_x = (dst.cols - scaled_width) / 2;
+    int offset_y = (dst.rows - scaled_height) / 2;
+
+    // 布局不变时黑边不会被改写，只在布局变化时清空一次
+    if (scale != letterbox_scale || offset_x != letterbox_offset_x || offset_y != letterbox_offset_y) {
+        dst.setTo(cv::Scalar(0, 0, 0));
+        letterbox_scale = scale;
+        letterbox_offset_x = offset_x;
+        letterbox_offset_y = offset_y;
+    }
+    letterbox_src_width = image_width;
+    letterbox_src_height = image_height;
+
+    // 直接缩放到目标区域，尺寸相同时只复制
+    cv::Mat target = dst(cv::Rect(offset_x, offset_y, scaled_width, scaled_height));
+    if (scaled_width == image_width && scaled_height == image_height) {
+        image.copyTo(target);
+    } else {
+        cv::resize(image, target, target.size());
+    }
 }
 
-// 坐标映射，用于AI检测结果的坐标转换
+// 坐标映射，把模型输入中的坐标还原到 letterbox 之前的源图像坐标
 void Video::mapCoordinates(int *x, int *y) {
-    // 保持原坐标不变（如果有特殊的坐标映射需求，可以在此实现）
-    // 这个函数的目的是在模型输出的坐标和显示坐标之间进行转换
-    // 如果没有特殊需求，可以保持不变
-    return;
+    if (letterbox_scale <= 0) {
+        return;
+    }
+    int sx = (int)((*x - letterbox_offset_x) / letterbox_scale);
+    int sy = (int)((*y - letterbox_offset_y) / letterbox_scale);
+    *x = std::min(std::max(sx, 0), letterbox_src_width);
+    *y = std::min(std::max(sy, 0), letterbox_src_height);
+}
+
+void Video::set_frame_demand(FrameConsumer consumer, bool demand) {
+    if (demand) {
+        frame_demand.fetch_or((uint32_t)consumer);
+    } else {
+        frame_demand.fetch_and(~(uint32_t)consumer);
+    }
+}
+
+void Video::onAiFrame(const VideoFrameRef& frame) {
+    if (!pipe2_run_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx_ai_frame);
+        ai_frame = frame;
+    }
+    cond_ai_frame.notify_one();
+}
+
+VideoFrameRef Video::waitAiFrame(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mtx_ai_frame);
+    cond_ai_frame.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() {
+        return (bool)ai_frame;
+    });
+    return std::move(ai_frame);
 }
\ No newline at end of file
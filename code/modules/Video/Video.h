@@ -5,6 +5,7 @@
 #include <thread>
 #include <memory>
 #include <chrono>
+#include <atomic>
 #include <unordered_set>
 
 #include <opencv2/core/core.hpp>
@@ -22,17 +23,32 @@
 #include "Signal.h"
 #include "roi_detector.h"
 #include "alarm_pusher.h"
+#include "jpeg_cache.h"
+#include "frame_pool.h"
+#include "param_snapshot.h"
+#include "latency_tracer.h"
+#include "privacy_mask.h"
+#include "rate_controller.h"
+#include "roi_encoder.h"
 
 // 前向声明
 class ApiServer;
 
 class Video {
 public:
+    // 子码流分支帧的消费者
+    enum class FrameConsumer : uint32_t {
+        Display = 1 << 0,
+        Ai = 1 << 1,
+    };
+
     Video();
     ~Video();
 
-    Signal<const cv::Mat&> signal_video_frame;
-    Signal<int, int> signal_adjust_pantilt;
+    // 子码流 BGR 帧，消费者持有引用即可，不需要复制
+    Signal<const VideoFrameRef&> signal_video_frame{"video_frame"};
+    Signal<int, int> signal_adjust_pantilt{"adjust_pantilt", SignalPriority::High};
+    Signal<DetectionSummaryPtr> signal_detections{"detections"};
 
     void video_pipe0_start();
     void video_pipe0_stop();
@@ -51,11 +67,28 @@ public:
     
     // 获取 ROI 检测器的引用（用于调试和配置）
     RoiDetector* get_roi_detector() { return roi_detector.get(); }
+    
+    // 获取子码流预览图缓存（用于 HTTP 快照和 MJPEG 预览）
+    JpegCache* get_preview_cache() { return &preview_cache; }
+
+    // 消费者声明是否需要 signal_video_frame 的帧；没有消费者需要、也没有预览观看者时，
+    // pipe1 不读取 VI 帧、不做颜色转换
+    void set_frame_demand(FrameConsumer consumer, bool demand);
 
 private:
+    // 子码流帧池大小：正在采集 1 帧，显示排队和显示中各 1 帧，JPEG 预览编码 1 帧
+    static constexpr int kFramePoolSize = 4;
+    // AI 使用子码流时另外占用的帧：信号排队 1 帧，等待推理 1 帧
+    static constexpr int kAiFrameRefs = 2;
+
     void video_pipe0();
     void video_pipe1();
+    void video_pipe1_bound(const ParamSnapshotPtr& config);
     void video_pipe2();
+    void privacy_hold_cover(PrivacyMask& mask, const char* reason);
+
+    // 各消费者的需求位，见 FrameConsumer
+    std::atomic<uint32_t> frame_demand{0};
 
     bool video_run_;
     bool pipe0_run_;
@@ -70,10 +103,28 @@ private:
     // ROI目标检测器
     std::unique_ptr<RoiDetector> roi_detector;
 
+    // 子码流 JPEG 预览缓存
+    JpegCache preview_cache;
+
+    // AI 输入取自子码流分支时，最新一帧由信号放入这里，等待推理线程取走
+    bool ai_from_substream;
+    VideoFrameRef ai_frame;
+    std::mutex mtx_ai_frame;
+    std::condition_variable cond_ai_frame;
+    void onAiFrame(const VideoFrameRef& frame);
+    VideoFrameRef waitAiFrame(int timeout_ms);
+
+    // 最近一次 letterbox 的布局，用于把检测框还原到源图像坐标
+    float letterbox_scale;
+    int letterbox_offset_x;
+    int letterbox_offset_y;
+    int letterbox_src_width;
+    int letterbox_src_height;
+
     // 处理告警事件
-    void handleAlarm(const AlarmInfo& alarm);
+    void handleAlarm(const AlarmEventPtr& alarm);
 
     // 视频预处理函数
-    cv::Mat letterbox(const cv::Mat &image, int w, int h);
+    void letterbox(const cv::Mat &image, cv::Mat &dst);
     void mapCoordinates(int *x, int *y);
 };
\ No newline at end of file
@@ -1,13 +1,14 @@
 #include "log.h"
 #include "param.h"
+#include "param_snapshot.h"
 #include <iostream>
 #include <vector>
 #include "httplib.h"  // 使用httplib库进行HTTP推送
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <ctime>
 #include "rknn/yolov5.h" 
 #include "alarm_pusher.h"
+#include "json.h"
 
 // Base64编码表
 static const std::string base64_chars = 
@@ -28,19 +29,29 @@ AlarmPusher::AlarmPusher() : running(false) {
 }
 
 AlarmPusher::~AlarmPusher() {
+    rk_param_unsubscribe(param_subscription);
     stop();
 }
 
 bool AlarmPusher::init() {
-    // 从配置文件读取服务器地址和认证令牌
-    server_url = rk_param_get_string("alarm:server_url", "http://localhost:8080");
-    auth_token = rk_param_get_string("alarm:auth_token", "");
-    
-    LOG_DEBUG("AlarmPusher initialized with server_url: %s\n", server_url.c_str());
+    // 从参数快照读取服务器地址和认证令牌，[alarm] 修改后自动生效
+    applyConfig(*rk_param_snapshot());
+    if (param_subscription == 0) {
+        param_subscription = rk_param_subscribe("alarm", [this](const ParamChangePtr& change) {
+            applyConfig(*change->snapshot);
+        });
+    }
     return true;
 }
 
-void AlarmPusher::onAlarm(const AlarmInfo& alarm) {
+void AlarmPusher::applyConfig(const ParamSnapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(config_mutex);
+    server_url = snapshot.get(param_key::alarm_server_url);
+    auth_token = snapshot.get(param_key::alarm_auth_token);
+    LOG_DEBUG("AlarmPusher config applied, server_url: %s\n", server_url.c_str());
+}
+
+void AlarmPusher::onAlarm(const AlarmEventPtr& alarm) {
     if (!running) {
         LOG_WARN("AlarmPusher not running, alarm dropped\n");
         return;
@@ -61,7 +72,7 @@ void AlarmPusher::onAlarm(const AlarmInfo& alarm) {
     }
     
     LOG_DEBUG("Alarm queued for pushing: class=%d(%s), confidence=%.2f\n", 
-              alarm.class_id, alarm.class_name.c_str(), alarm.confidence);
+              alarm->class_id, alarm->className(), alarm->confidence);
 }
 
 void AlarmPusher::start() {
@@ -98,7 +109,7 @@ void AlarmPusher::pushThread() {
     LOG_DEBUG("AlarmPusher push thread started\n");
     
     while (running) {
-        AlarmInfo alarm;
+        AlarmEventPtr alarm;
         bool has_alarm = false;
         
         // 从队列中获取告警
@@ -116,7 +127,7 @@ void AlarmPusher::pushThread() {
             }
             
             if (!alarm_queue.empty()) {
-                alarm = alarm_queue.front();
+                alarm = std::move(alarm_queue.front());
                 alarm_queue.pop();
                 has_alarm = true;
             }
@@ -134,7 +145,7 @@ void AlarmPusher::pushThread() {
                     std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_INTERVAL_MS));
                 }
                 
-                success = pushToServer(alarm);
+                success = pushToServer(*alarm);
             }
             
             if (!success) {
@@ -146,7 +157,15 @@ void AlarmPusher::pushThread() {
     LOG_DEBUG("AlarmPusher push thread stopped\n");
 }
 
-bool AlarmPusher::pushToServer(const AlarmInfo& alarm) {
+bool AlarmPusher::pushToServer(const AlarmEvent& alarm) {
+    std::string server_url;
+    std::string auth_token;
+    {
+        std::lock_guard<std::mutex> lock(config_mutex);
+        server_url = this->server_url;
+        auth_token = this->auth_token;
+    }
+
     if (server_url.empty()) {
         LOG_ERROR("Server URL is not set\n");
         return false;
@@ -185,28 +204,32 @@ bool AlarmPusher::pushToServer(const AlarmInfo& alarm) {
             host = host.substr(0, path_pos);
         }
 
-        // 构建请求体
-        std::string json_body = "{";
-        json_body += "\"roi_id\": " + std::to_string(alarm.roi_id) + ",";
-        json_body += "\"roi_name\": \"" + alarm.roi_name + "\",";
-        json_body += "\"track_id\": " + std::to_string(alarm.track_id) + ",";
-        json_body += "\"class_id\": " + std::to_string(alarm.class_id) + ",";
-        json_body += "\"class_name\": \"" + alarm.class_name + "\",";
-        json_body += "\"confidence\": " + std::to_string(alarm.confidence) + ",";
-        
         // 转换时间戳为ISO8601格式
-        auto timestamp = alarm.timestamp;
-        auto time_t_timestamp = std::chrono::system_clock::to_time_t(timestamp);
-        std::stringstream ss;
-        ss << std::put_time(std::gmtime(&time_t_timestamp), "%FT%TZ");
-        json_body += "\"timestamp\": \"" + ss.str() + "\"";
+        auto time_t_timestamp = std::chrono::system_clock::to_time_t(alarm.timestamp);
+        struct tm tm_timestamp;
+        gmtime_r(&time_t_timestamp, &tm_timestamp);
+        char timestamp[32];
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &tm_timestamp);
+
+        // 构建请求体，ROI名称等字符串统一转义
+        JsonWriter json;
+        json.reserve(256 + alarm.jpeg.size() * 4 / 3);
+        json.beginObject();
+        json.member("roi_id", alarm.roi_id);
+        json.member("roi_name", alarm.roiName());
+        json.member("track_id", alarm.track_id);
+        json.member("class_id", alarm.class_id);
+        json.member("class_name", alarm.className());
+        json.member("confidence", alarm.confidence);
+        json.member("timestamp", timestamp);
         
-        // 如果有图像，则转换为Base64并添加
-        if (!alarm.snapshot.empty()) {
-            json_body += ",\"image\": \"" + imageToBase64(alarm.snapshot) + "\"";
+        // 如果有截图，则将已编码的JPEG转换为Base64并添加
+        if (!alarm.jpeg.empty()) {
+            json.member("image", imageToBase64(alarm.jpeg));
         }
         
-        json_body += "}";
+        json.endObject();
+        std::string json_body = json.take();
 
         // 创建HTTP客户端
         httplib::Client cli(host, port);
@@ -248,21 +271,17 @@ bool AlarmPusher::pushToServer(const AlarmInfo& alarm) {
     return false;
 }
 
-std::string AlarmPusher::imageToBase64(const cv::Mat& image) {
-    if (image.empty()) {
+std::string AlarmPusher::imageToBase64(const std::vector<uchar>& jpeg) {
+    if (jpeg.empty()) {
         return "";
     }
 
-    // 首先将图像编码为JPEG格式
-    std::vector<uchar> buffer;
-    cv::imencode(".jpg", image, buffer);
-    
-    // 然后进行Base64编码
+    // JPEG已在告警生成时编码，这里只进行Base64编码
     std::string encoded;
-    encoded.reserve(((buffer.size() + 2) / 3) * 4); // Base64编码后的大小
+    encoded.reserve(((jpeg.size() + 2) / 3) * 4); // Base64编码后的大小
     
     int val = 0, valb = -6;
-    for (uchar c : buffer) {
+    for (uchar c : jpeg) {
         val = (val << 8) + c;
         valb += 8;
         while (valb >= 0) {
@@ -10,6 +10,8 @@
 #include <functional>
 #include "roi_detector.h"
 
+class ParamSnapshot;
+
 class AlarmPusher {
 public:
     AlarmPusher();
@@ -19,7 +21,7 @@ public:
     bool init();
     
     // 接收并处理告警事件
-    void onAlarm(const AlarmInfo& alarm);
+    void onAlarm(const AlarmEventPtr& alarm);
     
     // 启动推送线程
     void start();
@@ -28,7 +30,7 @@ public:
     void stop();
     
     // 注册回调函数处理告警事件
-    using AlarmHandlerCallback = std::function<void(const AlarmInfo&)>;
+    using AlarmHandlerCallback = std::function<void(const AlarmEventPtr&)>;
     void registerAlarmHandler(AlarmHandlerCallback callback);
 
 private:
@@ -36,16 +38,22 @@ private:
     void pushThread();
     
     // HTTP推送函数
-    bool pushToServer(const AlarmInfo& alarm);
+    bool pushToServer(const AlarmEvent& alarm);
+    
+    // 将已编码的JPEG数据转换为base64
+    std::string imageToBase64(const std::vector<uchar>& jpeg);
     
-    // 将图像转换为base64
-    std::string imageToBase64(const cv::Mat& image);
+    // 应用 [alarm] 配置
+    void applyConfig(const ParamSnapshot& snapshot);
     
+    // 推送配置，可在参数通知线程中更新
     std::string server_url;
     std::string auth_token;
+    std::mutex config_mutex;
+    int param_subscription = 0;     // [alarm] 变更订阅，init() 中只订阅一次
     
     std::thread push_thread;
-    std::queue<AlarmInfo> alarm_queue;
+    std::queue<AlarmEventPtr> alarm_queue;
     std::mutex queue_mutex;
     std::condition_variable queue_cv;
     std::atomic<bool> running;
@@ -0,0 +1,96 @@
+#include "frame_pool.h"
+#include <cstring>
+#include "luckfox_video.h"
+#include "log.h"
+
+size_t VideoFrame::size() const {
+    return format == FrameFormat::YUV420SP ? (size_t)stride * height * 3 / 2 : (size_t)stride * height;
+}
+
+cv::Mat VideoFrame::mat() const {
+    if (format == FrameFormat::YUV420SP) {
+        return cv::Mat(height + height / 2, width, CV_8UC1, data, stride);
+    }
+    return cv::Mat(height, width, CV_8UC3, data, stride);
+}
+
+void VideoFrame::release() {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    // 先取走帧池的引用再归还，归还后帧可能立即被生产者重新取出
+    std::shared_ptr<FramePool> keep = std::move(pool_ref);
+    keep->recycle(this);
+}
+
+std::shared_ptr<FramePool> FramePool::create(int width, int height, FrameFormat format, int count) {
+    std::shared_ptr<FramePool> pool(new FramePool());
+    int stride = format == FrameFormat::YUV420SP ? width : width * 3;
+    size_t size = format == FrameFormat::YUV420SP ? (size_t)stride * height * 3 / 2 : (size_t)stride * height;
+
+    MB_POOL_CONFIG_S config;
+    memset(&config, 0, sizeof(config));
+    config.u64MBSize = size;
+    config.u32MBCnt = count;
+    config.enAllocType = MB_ALLOC_TYPE_DMA;
+    pool->mb_pool = RK_MPI_MB_CreatePool(&config);
+    if (pool->mb_pool == MB_INVALID_POOLID) {
+        LOG_ERROR("Failed to create frame pool %dx%d x %d\n", width, height, count);
+        return nullptr;
+    }
+
+    for (int i = 0; i < count; i++) {
+        MB_BLK blk = RK_MPI_MB_GetMB(pool->mb_pool, size, RK_TRUE);
+        if (blk == NULL) {
+            LOG_ERROR("Failed to get frame buffer %d from pool\n", i);
+            return nullptr;
+        }
+        std::unique_ptr<VideoFrame> frame(new VideoFrame());
+        frame->blk = blk;
+        frame->data = (unsigned char*)RK_MPI_MB_Handle2VirAddr(blk);
+        frame->width = width;
+        frame->height = height;
+        frame->stride = stride;
+        frame->format = format;
+        frame->seq = 0;
+        frame->pts_us = 0;
+        pool->free_frames.push_back(frame.get());
+        pool->frames.push_back(std::move(frame));
+    }
+
+    LOG_INFO("Frame pool created: %dx%d, %d buffers, %zu bytes each\n", width, height, count, size);
+    return pool;
+}
+
+FramePool::~FramePool() {
+    for (auto& frame : frames) {
+        RK_MPI_MB_ReleaseMB(frame->blk);
+    }
+    if (mb_pool != MB_INVALID_POOLID) {
+        RK_MPI_MB_DestroyPool(mb_pool);
+    }
+}
+
+VideoFrameRef FramePool::acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (free_frames.empty()) {
+        return VideoFrameRef();
+    }
+    VideoFrame* frame = free_frames.back();
+    free_frames.pop_back();
+    frame->seq = ++next_seq;
+    frame->pts_us = 0;
+    frame->pool_ref = shared_from_this();
+    frame->refs.store(1, std::memory_order_relaxed);
+    return VideoFrameRef(frame);
+}
+
+int FramePool::available() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int)free_frames.size();
+}
+
+void FramePool::recycle(VideoFrame* frame) {
+    std::lock_guard<std::mutex> lock(mutex);
+    free_frames.push_back(frame);
+}
@@ -0,0 +1,110 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <opencv2/core/core.hpp>
+#include "rk_comm_mb.h"
+
+class FramePool;
+
+enum class FrameFormat : uint8_t {
+    BGR888,     // 与 RK_FMT_RGB888 内存布局一致，可以直接送入 VENC
+    YUV420SP,
+};
+
+// 视频帧：帧池中的一块 DMA 缓冲区及其元数据
+// 生产者取得后填充数据，发布后所有消费者共享同一块内存，只读不写
+class VideoFrame {
+public:
+    MB_BLK blk;             // 可以直接作为 pMbBlk 送入 VENC / RGA
+    unsigned char* data;
+    int width;
+    int height;
+    int stride;             // 每行字节数
+    FrameFormat format;
+    uint64_t seq;           // 帧序号，取出时由帧池分配
+    uint64_t pts_us;        // 采集时间（单调时钟，微秒）
+
+    size_t size() const;
+
+    // 包装成 cv::Mat，不复制数据
+    cv::Mat mat() const;
+
+private:
+    friend class FramePool;
+    friend class VideoFrameRef;
+
+    void addRef() { refs.fetch_add(1, std::memory_order_relaxed); }
+    void release();
+
+    std::atomic<int> refs{0};
+    std::shared_ptr<FramePool> pool_ref;    // 帧在使用中时保持帧池存活
+};
+
+// 帧的引用，复制时只增加引用计数，最后一个引用释放时缓冲区回到帧池
+class VideoFrameRef {
+public:
+    VideoFrameRef() : frame(nullptr) {}
+    VideoFrameRef(const VideoFrameRef& other) : frame(other.frame) {
+        if (frame) {
+            frame->addRef();
+        }
+    }
+    VideoFrameRef(VideoFrameRef&& other) noexcept : frame(other.frame) { other.frame = nullptr; }
+    ~VideoFrameRef() { reset(); }
+
+    VideoFrameRef& operator=(VideoFrameRef other) noexcept {
+        std::swap(frame, other.frame);
+        return *this;
+    }
+
+    void reset() {
+        if (frame) {
+            frame->release();
+            frame = nullptr;
+        }
+    }
+
+    VideoFrame* get() const { return frame; }
+    VideoFrame* operator->() const { return frame; }
+    VideoFrame& operator*() const { return *frame; }
+    explicit operator bool() const { return frame != nullptr; }
+
+private:
+    friend class FramePool;
+    explicit VideoFrameRef(VideoFrame* frame) : frame(frame) {}
+
+    VideoFrame* frame;
+};
+
+// 固定数量的 MB 缓冲区，取出的帧在所有引用释放后自动归还
+// 帧池对象在最后一帧归还后才真正释放内存，消费者可以比生产者线程活得更久
+class FramePool : public std::enable_shared_from_this<FramePool> {
+public:
+    static std::shared_ptr<FramePool> create(int width, int height, FrameFormat format, int count);
+    ~FramePool();
+
+    // 取一块空闲缓冲区，全部被占用时返回空引用，不阻塞
+    VideoFrameRef acquire();
+
+    int capacity() const { return (int)frames.size(); }
+    int available();
+
+private:
+    friend class VideoFrame;
+    FramePool() : mb_pool(MB_INVALID_POOLID) {}
+
+    void recycle(VideoFrame* frame);
+
+    MB_POOL mb_pool;
+    uint64_t next_seq = 0;
+    std::vector<std::unique_ptr<VideoFrame>> frames;
+    std::vector<VideoFrame*> free_frames;
+    std::mutex mutex;
+};
+
+#endif // FRAME_POOL_H
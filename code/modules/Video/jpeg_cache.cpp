@@ -0,0 +1,191 @@
+#include "jpeg_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include "luckfox_video.h"
+#include "log.h"
+
+// 超过该时间没有观看者请求时停止编码
+static const uint64_t DEMAND_TIMEOUT_US = 2 * 1000 * 1000;
+
+JpegCache::JpegCache() : width(0), height(0), max_fps(10), quality(70), venc_chn(-1), use_hw(false),
+                         running(false), last_demand_us(0), last_offer_us(0), encoding(false), next_seq(1) {
+}
+
+JpegCache::~JpegCache() {
+    stop();
+}
+
+bool JpegCache::start(int width, int height, int max_fps, int quality, int venc_chn) {
+    if (running) {
+        return false;
+    }
+
+    this->width = width;
+    this->height = height;
+    this->max_fps = std::max(max_fps, 1);
+    this->quality = std::min(std::max(quality, 1), 99);
+    this->venc_chn = venc_chn;
+    use_hw = false;
+
+    if (venc_chn >= 0) {
+        if (venc_jpeg_init(venc_chn, width, height, RK_FMT_RGB888, this->quality) == 0) {
+            use_hw = true;
+        } else {
+            LOG_WARN("JPEG VENC %d unavailable, falling back to software encoding\n", venc_chn);
+        }
+    }
+
+    running = true;
+    encode_thread = std::thread(&JpegCache::encodeLoop, this);
+
+    LOG_INFO("JPEG preview cache started: %dx%d, max %d fps, quality %d, %s encoder\n",
+             width, height, this->max_fps, this->quality, use_hw ? "hardware" : "software");
+    return true;
+}
+
+void JpegCache::stop() {
+    if (!running) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    cond_encode.notify_all();
+    cond_frame.notify_all();
+    if (encode_thread.joinable()) {
+        encode_thread.join();
+    }
+
+    if (use_hw) {
+        venc_deinit(venc_chn);
+        use_hw = false;
+    }
+    pending.reset();
+}
+
+void JpegCache::offer(const VideoFrameRef& frame) {
+    if (!running) {
+        return;
+    }
+
+    // 没有观看者时不做任何拷贝
+    uint64_t now = TEST_COMM_GetNowUs();
+    if (last_demand_us + DEMAND_TIMEOUT_US < now) {
+        return;
+    }
+    if (now - last_offer_us < 1000000 / (uint64_t)max_fps) {
+        return;
+    }
+    if (!frame || frame->width != width || frame->height != height || frame->format != FrameFormat::BGR888) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // 上一帧还在编码时丢弃本帧，不阻塞视频线程
+    if (encoding) {
+        return;
+    }
+    pending = frame;
+    last_offer_us = now;
+    encoding = true;
+    cond_encode.notify_one();
+}
+
+bool JpegCache::hasDemand() const {
+    return running && last_demand_us + DEMAND_TIMEOUT_US >= TEST_COMM_GetNowUs();
+}
+
+bool JpegCache::encodeHardware(const VideoFrame& src, std::vector<unsigned char>& out) {
+    VIDEO_FRAME_INFO_S frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.stVFrame.u32Width = width;
+    frame.stVFrame.u32Height = height;
+    frame.stVFrame.u32VirWidth = src.stride / 3;
+    frame.stVFrame.u32VirHeight = height;
+    frame.stVFrame.enPixelFormat = RK_FMT_RGB888;
+    frame.stVFrame.u32FrameFlag = 160;
+    frame.stVFrame.pMbBlk = src.blk;
+    frame.stVFrame.u64PTS = TEST_COMM_GetNowUs();
+
+    if (RK_MPI_VENC_SendFrame(venc_chn, &frame, 1000) != RK_SUCCESS) {
+        return false;
+    }
+
+    VENC_STREAM_S stream;
+    VENC_PACK_S pack;
+    memset(&stream, 0, sizeof(stream));
+    stream.pstPack = &pack;
+    if (RK_MPI_VENC_GetStream(venc_chn, &stream, 1000) != RK_SUCCESS) {
+        return false;
+    }
+
+    const unsigned char* data = (const unsigned char*)RK_MPI_MB_Handle2VirAddr(pack.pMbBlk);
+    out.assign(data, data + pack.u32Len);
+    RK_MPI_VENC_ReleaseStream(venc_chn, &stream);
+    return !out.empty();
+}
+
+void JpegCache::encodeLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond_encode.wait(lock, [this]() { return encoding || !running; });
+            if (!running) {
+                break;
+            }
+        }
+
+        // encoding 置位期间生产者不会修改 pending，这里无需持锁
+        auto frame = std::make_shared<JpegFrame>();
+        frame->pts_us = TEST_COMM_GetNowUs();
+        bool ok = use_hw && encodeHardware(*pending, frame->data);
+        if (!ok) {
+            ok = cv::imencode(".jpg", pending->mat(), frame->data, {cv::IMWRITE_JPEG_QUALITY, quality});
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        // 编码完成后立即归还帧
+        pending.reset();
+        encoding = false;
+        if (ok) {
+            frame->seq = next_seq++;
+            latest = std::move(frame);
+            cond_frame.notify_all();
+        }
+    }
+}
+
+JpegFramePtr JpegCache::waitFrame(uint64_t after_seq, int timeout_ms) {
+    last_demand_us = TEST_COMM_GetNowUs();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    cond_frame.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this, after_seq]() {
+        return (latest && latest->seq > after_seq) || !running;
+    });
+    if (latest && latest->seq > after_seq) {
+        return latest;
+    }
+    return nullptr;
+}
+
+JpegFramePtr JpegCache::getFresh(int timeout_ms) {
+    uint64_t now = TEST_COMM_GetNowUs();
+    last_demand_us = now;
+
+    uint64_t seq = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // 缓存的帧足够新时直接复用，否则等待下一帧
+        if (latest && now - latest->pts_us <= 2 * 1000000 / (uint64_t)max_fps) {
+            return latest;
+        }
+        if (latest) {
+            seq = latest->seq;
+        }
+    }
+    return waitFrame(seq, timeout_ms);
+}
@@ -0,0 +1,77 @@
+#ifndef JPEG_CACHE_H
+#define JPEG_CACHE_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <opencv2/core/core.hpp>
+#include "frame_pool.h"
+
+// 编码好的一帧 JPEG，所有观看者通过引用计数共享同一份数据
+struct JpegFrame {
+    uint64_t seq;                       // 帧序号，每编码一帧加一
+    uint64_t pts_us;                    // 编码时间（单调时钟，微秒）
+    std::vector<unsigned char> data;
+};
+
+using JpegFramePtr = std::shared_ptr<const JpegFrame>;
+
+// 预览图 JPEG 缓存（单生产者）
+// 视频线程每帧调用 offer()，只有在有观看者且距上次编码超过帧间隔时才取得该帧的引用并编码，
+// 编码在独立线程完成，不论观看者多少，每个帧间隔最多编码一次
+class JpegCache {
+public:
+    JpegCache();
+    ~JpegCache();
+
+    // 启动编码线程，venc_chn >= 0 时优先使用硬件 JPEG 编码，失败则回退到 cv::imencode
+    bool start(int width, int height, int max_fps, int quality, int venc_chn);
+    void stop();
+
+    // 生产者：提交一帧 BGR 图像，编码线程忙或没有观看者时直接返回，不复制数据
+    void offer(const VideoFrameRef& frame);
+
+    // 消费者：等待序号大于 after_seq 的新帧，超时返回空指针
+    JpegFramePtr waitFrame(uint64_t after_seq, int timeout_ms);
+
+    // 消费者：获取一帧新鲜的图像（缓存帧过旧时等待下一帧），超时返回空指针
+    JpegFramePtr getFresh(int timeout_ms);
+
+    // 编码帧率上限
+    int maxFps() const { return max_fps; }
+
+    // 最近是否有观看者请求预览图
+    bool hasDemand() const;
+
+private:
+    void encodeLoop();
+    bool encodeHardware(const VideoFrame& frame, std::vector<unsigned char>& out);
+
+    int width;
+    int height;
+    int max_fps;
+    int quality;
+    int venc_chn;
+    bool use_hw;
+
+    // 待编码的帧，本身位于 MB 内存中，可以零拷贝送入 VENC
+    VideoFrameRef pending;
+
+    std::atomic<bool> running;
+    std::atomic<uint64_t> last_demand_us;   // 最近一次有观看者请求的时间
+    uint64_t last_offer_us;
+    bool encoding;                          // 编码线程正在使用 pending
+    uint64_t next_seq;
+
+    JpegFramePtr latest;
+    std::thread encode_thread;
+    std::mutex mutex;
+    std::condition_variable cond_encode;
+    std::condition_variable cond_frame;
+};
+
+#endif // JPEG_CACHE_H
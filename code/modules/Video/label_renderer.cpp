@@ -0,0 +1,110 @@
+#include "label_renderer.h"
+#include <algorithm>
+#include <cstring>
+#include <opencv2/imgproc/imgproc.hpp>
+
+LabelRenderer::LabelRenderer(size_t max_sprites) : max_sprites(max_sprites) {}
+
+// 渲染标签：半透明黑色背景、白色文字和灰色边框
+const LabelRenderer::Sprite& LabelRenderer::sprite(const std::string& text) {
+    auto it = sprites.find(text);
+    if (it != sprites.end()) {
+        lru.splice(lru.begin(), lru, it->second.lru_pos);
+        return it->second;
+    }
+
+    int baseline = 0;
+    cv::Size text_size = cv::getTextSize(text, cv::FONT_HERSHEY_DUPLEX, 0.6, 1, &baseline);
+    int width = std::max(60, text_size.width + 16);
+    cv::Mat image(kLabelHeight, width, CV_8UC4, cv::Scalar(0, 0, 0, 180));
+    cv::putText(image, text, cv::Point(8, kLabelHeight / 2 + 6),
+                cv::FONT_HERSHEY_DUPLEX, 0.6, cv::Scalar(255, 255, 255, 255), 1, cv::LINE_AA);
+    cv::rectangle(image, cv::Rect(0, 0, width, kLabelHeight), cv::Scalar(100, 100, 100, 200), 1);
+
+    lru.push_front(text);
+    Sprite& entry = sprites[text];
+    entry.image = image;
+    entry.id = ++next_sprite_id;
+    entry.lru_pos = lru.begin();
+    return entry;
+}
+
+bool LabelRenderer::render(const RGN_CANVAS_INFO_S& canvas, const std::vector<LabelItem>& labels) {
+    unsigned char* base = (unsigned char*)(uintptr_t)canvas.u64VirAddr;
+    size_t stride = (size_t)canvas.u32VirWidth * 4;
+    cv::Rect bounds(0, 0, (int)canvas.stSize.u32Width, (int)canvas.stSize.u32Height);
+
+    // 第一次使用的缓冲区内容未知，整块清空
+    auto found = drawn.find(canvas.u64VirAddr);
+    bool changed = false;
+    if (found == drawn.end()) {
+        memset(base, 0, stride * canvas.u32VirHeight);
+        found = drawn.emplace(canvas.u64VirAddr, std::vector<Placed>()).first;
+        changed = true;
+    }
+    std::vector<Placed>& previous = found->second;
+
+    // 在放置本帧标签之前淘汰最久未使用的缓存，本帧用到的标签不会在绘制前被释放
+    while (sprites.size() > max_sprites) {
+        sprites.erase(lru.back());
+        lru.pop_back();
+    }
+
+    // 标签在检测框上方居中，上方空间不足时放在框内顶部
+    std::vector<Placed> current;
+    current.reserve(labels.size());
+    for (const auto& label : labels) {
+        if (label.text.empty()) {
+            continue;
+        }
+        const Sprite& entry = sprite(label.text);
+        const cv::Mat* image = &entry.image;
+        int x = label.box_x + (label.box_w - image->cols) / 2;
+        int y = label.box_y > kLabelHeight + kLabelMargin ? label.box_y - kLabelHeight - kLabelMargin
+                                                          : label.box_y + kLabelMargin;
+        x = std::max(0, std::min(x, bounds.width - image->cols));
+        y = std::max(0, std::min(y, bounds.height - image->rows));
+        cv::Rect rect = cv::Rect(x, y, image->cols, image->rows) & bounds;
+        if (rect.area() > 0) {
+            current.push_back({rect, entry.id, image});
+        }
+    }
+
+    auto same = [](const Placed& a, const Placed& b) { return a.rect == b.rect && a.sprite_id == b.sprite_id; };
+
+    // 清除消失或移动的标签
+    std::vector<cv::Rect> cleared;
+    for (const auto& old : previous) {
+        bool kept = std::any_of(current.begin(), current.end(), [&](const Placed& p) { return same(p, old); });
+        if (kept) {
+            continue;
+        }
+        for (int row = 0; row < old.rect.height; row++) {
+            memset(base + (size_t)(old.rect.y + row) * stride + (size_t)old.rect.x * 4, 0, (size_t)old.rect.width * 4);
+        }
+        cleared.push_back(old.rect);
+    }
+
+    // 绘制新标签，以及与被清除区域重叠的未变化标签
+    for (const auto& placed : current) {
+        bool kept = std::any_of(previous.begin(), previous.end(), [&](const Placed& p) { return same(p, placed); });
+        bool overlapped = std::any_of(cleared.begin(), cleared.end(),
+                                      [&](const cv::Rect& r) { return (r & placed.rect).area() > 0; });
+        if (kept && !overlapped) {
+            continue;
+        }
+        for (int row = 0; row < placed.rect.height; row++) {
+            memcpy(base + (size_t)(placed.rect.y + row) * stride + (size_t)placed.rect.x * 4,
+                   placed.image->ptr(row), (size_t)placed.rect.width * 4);
+        }
+        changed = true;
+    }
+
+    changed = changed || !cleared.empty();
+    previous.swap(current);
+    return changed;
+}
+
+void LabelRenderer::reset() {
+    drawn.clear();
+}
@@ -0,0 +1,63 @@
+#ifndef LABEL_RENDERER_H
+#define LABEL_RENDERER_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "sample_comm.h"
+
+// 一个检测框的标签，位置由检测框决定
+struct LabelItem {
+    int box_x;
+    int box_y;
+    int box_w;
+    std::string text;
+};
+
+// 检测框标签绘制
+//
+// 标签在 ARGB8888 画布上绘制，不再每帧分配整幅位图：
+//   - 每种标签文字只用 putText 渲染一次，结果按 LRU 缓存，之后逐行复制；
+//   - 每块画布缓冲区记录上次绘制过的矩形，下一帧只清除消失或移动的标签、绘制新出现的标签。
+// 只在 RGN 绘制线程中使用，不加锁。
+class LabelRenderer {
+public:
+    static constexpr int kLabelHeight = 28;
+    static constexpr int kLabelMargin = 2;
+
+    explicit LabelRenderer(size_t max_sprites = 64);
+
+    // 把一帧的标签绘制到画布，返回画布内容是否有变化（没有变化时不需要 UpdateCanvas）
+    bool render(const RGN_CANVAS_INFO_S& canvas, const std::vector<LabelItem>& labels);
+
+    // 画布重建后调用，清除所有缓冲区的记录
+    void reset();
+
+    size_t spriteCount() const { return sprites.size(); }
+
+private:
+    struct Sprite {
+        cv::Mat image;
+        uint32_t id;        // 每次渲染分配新编号，用于判断标签内容是否变化
+        std::list<std::string>::iterator lru_pos;
+    };
+
+    struct Placed {
+        cv::Rect rect;
+        uint32_t sprite_id;
+        const cv::Mat* image;   // 只在绘制当前帧时有效
+    };
+
+    const Sprite& sprite(const std::string& text);
+
+    size_t max_sprites;
+    uint32_t next_sprite_id = 0;
+    std::unordered_map<std::string, Sprite> sprites;
+    std::list<std::string> lru;                         // 最近使用的在前
+    std::map<uint64_t, std::vector<Placed>> drawn;      // 画布虚拟地址 -> 该缓冲区上的标签
+};
+
+#endif // LABEL_RENDERER_H
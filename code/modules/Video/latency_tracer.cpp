@@ -0,0 +1,191 @@
+#include "latency_tracer.h"
+
+static const char* kPipeNames[] = {"main", "sub", "ai"};
+static const char* kStageNames[] = {
+    "vi_get", "convert", "encode_submit", "encode_get_stream", "rtsp_tx",
+    "preprocess", "inference", "post_process", "draw_enqueue", "canvas_update",
+};
+
+static_assert(sizeof(kPipeNames) / sizeof(kPipeNames[0]) == (size_t)LatencyPipe::Count, "pipe name table mismatch");
+static_assert(sizeof(kStageNames) / sizeof(kStageNames[0]) == (size_t)LatencyStage::Count, "stage name table mismatch");
+
+const char* latencyPipeName(LatencyPipe pipe) {
+    return (size_t)pipe < (size_t)LatencyPipe::Count ? kPipeNames[(size_t)pipe] : "unknown";
+}
+
+const char* latencyStageName(LatencyStage stage) {
+    return (size_t)stage < (size_t)LatencyStage::Count ? kStageNames[(size_t)stage] : "unknown";
+}
+
+LatencyTracer& LatencyTracer::instance() {
+    static LatencyTracer tracer;
+    return tracer;
+}
+
+LatencyTracer::LatencyTracer() : head(0) {
+    reset();
+    for (auto& slot : ring) {
+        slot.seq.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t LatencyTracer::bucketOf(uint64_t value) {
+    if (value < 16) {
+        return (size_t)value;
+    }
+    int exp = 63 - __builtin_clzll(value);          // value 的最高位，>= 4
+    size_t sub = (size_t)(value >> (exp - 3)) & 7;  // 最高位之后的 3 位
+    size_t index = 16 + (size_t)(exp - 4) * 8 + sub;
+    return index < kBuckets ? index : kBuckets - 1;
+}
+
+// 桶的中间值
+uint64_t LatencyTracer::bucketValue(size_t index) {
+    if (index < 16) {
+        return index;
+    }
+    int exp = (int)(index - 16) / 8 + 4;
+    uint64_t sub = (index - 16) % 8;
+    uint64_t low = (8 + sub) << (exp - 3);
+    return low + ((uint64_t)1 << (exp - 3)) / 2;
+}
+
+void LatencyTracer::Histogram::add(uint64_t value) {
+    buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    uint64_t old = max.load(std::memory_order_relaxed);
+    while (value > old && !max.compare_exchange_weak(old, value, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyPercentiles LatencyTracer::Histogram::percentiles() const {
+    LatencyPercentiles result = {0, 0, 0, 0, 0};
+    uint32_t counts[kBuckets];
+    uint64_t total = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    result.count = total;
+    result.max = max.load(std::memory_order_relaxed);
+    if (total == 0) {
+        return result;
+    }
+
+    const uint64_t targets[3] = {(total * 50 + 99) / 100, (total * 95 + 99) / 100, (total * 99 + 99) / 100};
+    uint64_t* outputs[3] = {&result.p50, &result.p95, &result.p99};
+    uint64_t seen = 0;
+    size_t next = 0;
+    for (size_t i = 0; i < kBuckets && next < 3; i++) {
+        seen += counts[i];
+        while (next < 3 && seen >= targets[next]) {
+            // 桶中间值不超过实际最大值
+            uint64_t value = bucketValue(i);
+            *outputs[next++] = value < result.max ? value : result.max;
+        }
+    }
+    return result;
+}
+
+void LatencyTracer::Histogram::clear() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+void LatencyTracer::submit(const FrameTrace& trace) {
+    size_t pipe = (size_t)trace.pipe;
+    if (pipe >= (size_t)LatencyPipe::Count) {
+        return;
+    }
+
+    // 找到第一个阶段，PTS 未知或与当前时钟不一致时以它为起点
+    uint64_t first = 0;
+    for (size_t s = 0; s < (size_t)LatencyStage::Count && first == 0; s++) {
+        first = trace.stage_us[s];
+    }
+    if (first == 0) {
+        return;
+    }
+    uint64_t pts = (trace.pts_us != 0 && trace.pts_us <= first) ? trace.pts_us : first;
+    uint64_t last = trace.start_us != 0 ? trace.start_us : pts;
+
+    for (size_t s = 0; s < (size_t)LatencyStage::Count; s++) {
+        uint64_t t = trace.stage_us[s];
+        if (t == 0) {
+            continue;
+        }
+        since_capture[pipe][s].add(t >= pts ? t - pts : 0);
+        duration[pipe][s].add(t >= last ? t - last : 0);
+        last = t;
+    }
+
+    // 写入环形缓冲区：奇数序号表示正在写
+    uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = ring[index % kRingSize];
+    slot.seq.store(index * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.pipe.store(pipe, std::memory_order_relaxed);
+    slot.pts_us.store(pts, std::memory_order_relaxed);
+    slot.start_us.store(trace.start_us, std::memory_order_relaxed);
+    for (size_t s = 0; s < (size_t)LatencyStage::Count; s++) {
+        slot.stage_us[s].store(trace.stage_us[s], std::memory_order_relaxed);
+    }
+    slot.seq.store(index * 2 + 2, std::memory_order_release);
+}
+
+std::vector<LatencyStageStats> LatencyTracer::stats() const {
+    std::vector<LatencyStageStats> result;
+    for (size_t p = 0; p < (size_t)LatencyPipe::Count; p++) {
+        for (size_t s = 0; s < (size_t)LatencyStage::Count; s++) {
+            if (since_capture[p][s].count.load(std::memory_order_relaxed) == 0) {
+                continue;
+            }
+            LatencyStageStats stats;
+            stats.pipe = (LatencyPipe)p;
+            stats.stage = (LatencyStage)s;
+            stats.since_capture = since_capture[p][s].percentiles();
+            stats.duration = duration[p][s].percentiles();
+            result.push_back(stats);
+        }
+    }
+    return result;
+}
+
+std::vector<FrameTrace> LatencyTracer::recent(size_t count) const {
+    std::vector<FrameTrace> result;
+    uint64_t end = head.load(std::memory_order_acquire);
+    if (count > kRingSize) {
+        count = kRingSize;
+    }
+    uint64_t begin = end > count ? end - count : 0;
+    for (uint64_t index = begin; index < end; index++) {
+        const Slot& slot = ring[index % kRingSize];
+        uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != index * 2 + 2) {
+            continue;   // 正在写或已被覆盖
+        }
+        FrameTrace trace((LatencyPipe)slot.pipe.load(std::memory_order_relaxed),
+                         slot.pts_us.load(std::memory_order_relaxed));
+        trace.start_us = slot.start_us.load(std::memory_order_relaxed);
+        for (size_t s = 0; s < (size_t)LatencyStage::Count; s++) {
+            trace.stage_us[s] = slot.stage_us[s].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == seq) {
+            result.push_back(trace);
+        }
+    }
+    return result;
+}
+
+void LatencyTracer::reset() {
+    for (size_t p = 0; p < (size_t)LatencyPipe::Count; p++) {
+        for (size_t s = 0; s < (size_t)LatencyStage::Count; s++) {
+            since_capture[p][s].clear();
+            duration[p][s].clear();
+        }
+    }
+}
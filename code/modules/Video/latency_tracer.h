@@ -0,0 +1,131 @@
+#ifndef LATENCY_TRACER_H
+#define LATENCY_TRACER_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <time.h>
+
+// 视频链路延迟追踪
+//
+// 每帧在各个线程中用 FrameTrace 记录经过每个阶段的时间，时间起点为 VI 采集时的 PTS，
+// 处理完成后提交给 LatencyTracer：
+//   - 每个（链路, 阶段）维护两组直方图：从采集到该阶段完成的总延迟、该阶段自身耗时；
+//   - 最近的完整记录保存在无锁环形缓冲区中，供 API 查看单帧明细。
+// 提交只有若干次原子加，不加锁，可以在所有视频线程中常开。
+
+enum class LatencyPipe : uint8_t {
+    Main = 0,   // 主码流：VI 绑定 VENC 0
+    Sub,        // 子码流：VENC 1 及显示 / 预览分支
+    Ai,         // AI 推理和 OSD 绘制
+    Count
+};
+
+enum class LatencyStage : uint8_t {
+    ViGet = 0,          // 取得 VI 帧
+    Convert,            // NV12 -> BGR
+    EncodeSubmit,       // 送入 VENC
+    EncodeGetStream,    // RK_MPI_VENC_GetStream 返回
+    RtspTx,             // rtsp_tx_video 完成
+    Preprocess,         // letterbox 到模型输入
+    Inference,          // rknn_run
+    PostProcess,        // 后处理 / NMS
+    DrawEnqueue,        // 绘制任务入队
+    CanvasUpdate,       // RGN 画布更新完成
+    Count
+};
+
+const char* latencyPipeName(LatencyPipe pipe);
+const char* latencyStageName(LatencyStage stage);
+
+// 与 VI / VENC 的 PTS 使用同一个时钟（CLOCK_MONOTONIC，微秒）
+inline uint64_t latencyNowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+// 一帧的追踪记录，只在一个线程内填写
+struct FrameTrace {
+    explicit FrameTrace(LatencyPipe pipe, uint64_t pts_us = 0) : pipe(pipe), pts_us(pts_us), start_us(0) {
+        for (auto& t : stage_us) {
+            t = 0;
+        }
+    }
+
+    void mark(LatencyStage stage) { stage_us[(size_t)stage] = latencyNowUs(); }
+
+    LatencyPipe pipe;
+    uint64_t pts_us;        // 采集时间，0 表示未知（以第一个阶段的时间代替）
+    uint64_t start_us;      // 第一个阶段耗时的起点，0 表示从 pts_us 算起
+    uint64_t stage_us[(size_t)LatencyStage::Count];     // 各阶段完成时间，0 表示未经过
+};
+
+// 延迟分布，数值单位为微秒
+struct LatencyPercentiles {
+    uint64_t count;
+    uint64_t p50;
+    uint64_t p95;
+    uint64_t p99;
+    uint64_t max;
+};
+
+struct LatencyStageStats {
+    LatencyPipe pipe;
+    LatencyStage stage;
+    LatencyPercentiles since_capture;   // 采集到该阶段完成
+    LatencyPercentiles duration;        // 该阶段自身耗时
+};
+
+class LatencyTracer {
+public:
+    static constexpr size_t kRingSize = 256;
+    static constexpr size_t kBuckets = 208;
+
+    static LatencyTracer& instance();
+
+    void submit(const FrameTrace& trace);
+
+    // 有数据的阶段的统计
+    std::vector<LatencyStageStats> stats() const;
+
+    // 最近的 count 条记录，按提交顺序
+    std::vector<FrameTrace> recent(size_t count) const;
+
+    // 清空直方图（环形缓冲区保留）
+    void reset();
+
+private:
+    // 对数分桶的直方图：16 微秒以下每微秒一个桶，之后每个 2 的幂分 8 个桶，相对误差约 6%
+    struct Histogram {
+        std::atomic<uint32_t> buckets[kBuckets];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> max;
+
+        void add(uint64_t value);
+        LatencyPercentiles percentiles() const;
+        void clear();
+    };
+
+    // 环形缓冲区中的一条记录，用序号校验读到的是完整记录
+    struct Slot {
+        std::atomic<uint64_t> seq;
+        std::atomic<uint64_t> pipe;
+        std::atomic<uint64_t> pts_us;
+        std::atomic<uint64_t> start_us;
+        std::atomic<uint64_t> stage_us[(size_t)LatencyStage::Count];
+    };
+
+    LatencyTracer();
+
+    static size_t bucketOf(uint64_t value);
+    static uint64_t bucketValue(size_t index);
+
+    Histogram since_capture[(size_t)LatencyPipe::Count][(size_t)LatencyStage::Count];
+    Histogram duration[(size_t)LatencyPipe::Count][(size_t)LatencyStage::Count];
+    Slot ring[kRingSize];
+    std::atomic<uint64_t> head;
+};
+
+#endif // LATENCY_TRACER_H
@@ -1,13 +1,16 @@
 #include "luckfox_rgn_draw.h"
+#include "latency_tracer.h"
+#include "label_renderer.h"
 #include <opencv2/opencv.hpp>
 #include <string.h>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <unordered_set>
+#include <algorithm>
 #include <map>
 #include <chrono>
-#include <unordered_map>  // 添加这个头文件以支持std::unordered_map
+#include "param_snapshot.h"
 
 // label OSD的ID基准值
 static const int BASE_LABEL_ID = 1000;
@@ -31,91 +34,47 @@ pthread_t rgn_draw_thread_id;
 // 使用一个全局OSD区域显示所有标签
 static RGN_HANDLE g_LabelRgnHandle = 10;  // 使用单一OSD区域显示所有标签
 static bool g_LabelRgnCreated = false;
-static std::vector<std::pair<int, int>> label_positions; // 存储标签的位置和尺寸
-
-// 记录每个目标的历史置信度，用于平滑显示
-struct ConfidenceHistory {
-    std::vector<float> history;
-    std::chrono::steady_clock::time_point last_update;
-    
-    // 添加新的置信度到历史记录中
-    void add(float conf) {
-        // 限制历史记录长度，保留最近5帧数据
-        const size_t MAX_HISTORY = 5;
-        if (history.size() >= MAX_HISTORY) {
-            history.erase(history.begin());
-        }
-        history.push_back(conf);
-        last_update = std::chrono::steady_clock::now();
-    }
-    
-    // 获取平滑后的置信度
-    float get_smoothed() const {
-        if (history.empty()) {
-            return 0.0f;
-        }
-        
-        float sum = 0.0f;
-        for (float conf : history) {
-            sum += conf;
-        }
-        return sum / history.size();
-    }
-    
-    // 检查记录是否过期
-    bool is_expired() const {
-        auto now = std::chrono::steady_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - last_update).count();
-        return duration > 2; // 2秒不更新认为目标已消失
-    }
+static LabelRenderer g_LabelRenderer;       // 只在绘制线程中使用
+
+// 检测框画布每块缓冲区上次绘制的检测框（画布虚拟地址 -> 检测框），只在绘制线程中使用
+static std::map<uint64_t, std::vector<cv::Rect>> g_BoxDrawn;
+
+// OSD区域尺寸与主码流分辨率一致，在 rgn_draw_nn_init 中从参数读取
+static int g_RgnWidth = 0;
+static int g_RgnHeight = 0;
+
+// 检测框延迟补偿参数，在 rgn_draw_nn_init 中从参数读取
+static bool g_PredictEnable = true;
+static uint64_t g_PredictLatencyUs = 0;    // 0 表示按检测帧 PTS 实测
+static float g_PredictMinScore = 0.5f;
+
+// 每个跟踪目标的标签置信度，按 track_id 取模放入固定大小的数组，只在绘制线程中使用
+// 槽位中的 track_id 不一致或超过跟踪器保留目标的时间未更新时重新开始平滑
+struct LabelTrackState {
+    int track_id;
+    float score;
+    uint64_t last_us;
 };
 
-// 使用目标类别+位置作为key的哈希函数
-struct ObjectKey {
-    int class_id;
-    int x;
-    int y;
-    int width;
-    int height;
-    
-    bool operator==(const ObjectKey& other) const {
-        // 位置允许有一定范围的偏差，认为是同一个目标
-        const int POS_THRESHOLD = 50;
-        const int SIZE_THRESHOLD = 50;
-        
-        return class_id == other.class_id &&
-               std::abs(x - other.x) < POS_THRESHOLD &&
-               std::abs(y - other.y) < POS_THRESHOLD &&
-               std::abs(width - other.width) < SIZE_THRESHOLD &&
-               std::abs(height - other.height) < SIZE_THRESHOLD;
-    }
-};
+static const int kLabelTrackSlots = 64;
+static const float kLabelScoreAlpha = 0.3f;
+static const uint64_t kLabelTrackExpireUs = 500000;   // 与 BYTETracker 保留目标的时间一致
+static LabelTrackState g_LabelTracks[kLabelTrackSlots];
 
-// 自定义哈希函数
-struct ObjectKeyHash {
-    std::size_t operator()(const ObjectKey& key) const {
-        // 简化版哈希函数：将位置四舍五入到最接近50的倍数
-        return std::hash<int>{}(key.class_id) ^ 
-               std::hash<int>{}(key.x / 50 * 50) ^ 
-               std::hash<int>{}(key.y / 50 * 50) ^
-               std::hash<int>{}(key.width / 50 * 50) ^
-               std::hash<int>{}(key.height / 50 * 50);
+// 返回平滑后的置信度，没有跟踪 ID 的目标直接使用本帧置信度
+static float smooth_label_score(int track_id, float score, uint64_t now_us) {
+    if (track_id <= 0) {
+        return score;
     }
-};
-
-// 记录每个目标的历史置信度
-static std::unordered_map<ObjectKey, ConfidenceHistory, ObjectKeyHash> confidence_history;
-
-// 清理过期的置信度记录
-static void clean_expired_confidence_history() {
-    auto it = confidence_history.begin();
-    while (it != confidence_history.end()) {
-        if (it->second.is_expired()) {
-            it = confidence_history.erase(it);
-        } else {
-            ++it;
-        }
+    LabelTrackState& state = g_LabelTracks[track_id % kLabelTrackSlots];
+    if (state.track_id != track_id || now_us - state.last_us > kLabelTrackExpireUs) {
+        state.track_id = track_id;
+        state.score = score;
+    } else {
+        state.score += kLabelScoreAlpha * (score - state.score);
     }
+    state.last_us = now_us;
+    return state.score;
 }
 
 // 初始化全局标签OSD区域
@@ -133,8 +92,8 @@ static RK_S32 init_global_label_rgn() {
     stRgnAttr.enType = OVERLAY_RGN;
     stRgnAttr.unAttr.stOverlay.enPixelFmt = RK_FMT_ARGB8888;
     stRgnAttr.unAttr.stOverlay.u32CanvasNum = 1;
-    stRgnAttr.unAttr.stOverlay.stSize.u32Width = 2304;  // 使用与视频相同的宽度
-    stRgnAttr.unAttr.stOverlay.stSize.u32Height = 1296; // 使用与视频相同的高度
+    stRgnAttr.unAttr.stOverlay.stSize.u32Width = g_RgnWidth;  // 使用与视频相同的宽度
+    stRgnAttr.unAttr.stOverlay.stSize.u32Height = g_RgnHeight; // 使用与视频相同的高度
 
     // 创建RGN区域
     int ret = RK_MPI_RGN_Create(g_LabelRgnHandle, &stRgnAttr);
@@ -169,78 +128,33 @@ static RK_S32 init_global_label_rgn() {
     return RK_SUCCESS;
 }
 
-// 在共享OSD区域上绘制标签
-static RK_S32 draw_label_on_global_rgn(const std::vector<std::tuple<int, int, int, int, std::string>>& labels) {
+// 在共享OSD区域的画布上绘制标签，只更新有变化的矩形
+static RK_S32 draw_label_on_global_rgn(const std::vector<LabelItem>& labels) {
     if (!g_LabelRgnCreated) {
+        if (labels.empty()) {
+            return RK_SUCCESS;
+        }
         if (init_global_label_rgn() != RK_SUCCESS) {
             return RK_FAILURE;
         }
     }
 
-    // 获取共享OSD区域的尺寸
-    int width = 2304;
-    int height = 1296;
-
-    // 创建位图
-    BITMAP_S stBitmap;
-    memset(&stBitmap, 0, sizeof(BITMAP_S));
-    stBitmap.enPixelFormat = RK_FMT_ARGB8888;
-    stBitmap.u32Width = width;
-    stBitmap.u32Height = height;
-    
-    // 分配位图内存
-    int bitmapSize = width * height * 4; // ARGB8888格式每像素4字节
-    stBitmap.pData = malloc(bitmapSize);
-    if (stBitmap.pData == NULL) {
-        RK_LOGE("Failed to allocate bitmap memory for global label\n");
-        return RK_FAILURE;
+    RGN_CANVAS_INFO_S stCanvasInfo;
+    int ret = RK_MPI_RGN_GetCanvasInfo(g_LabelRgnHandle, &stCanvasInfo);
+    if (ret != RK_SUCCESS) {
+        RK_LOGE("Get label canvas info failed with %#x\n", ret);
+        return ret;
     }
 
-    // 创建全透明背景
-    memset(stBitmap.pData, 0, bitmapSize);
-    
-    // 创建OpenCV Mat对象用于绘制位图
-    cv::Mat bitmapMat(height, width, CV_8UC4, stBitmap.pData);
-
-    // 为每个标签绘制背景和文字
-    for (const auto& label_info : labels) {
-        int label_x = std::get<0>(label_info);
-        int label_y = std::get<1>(label_info);
-        int label_width = std::get<2>(label_info);
-        int label_height = std::get<3>(label_info);
-        const std::string& text = std::get<4>(label_info);
-
-        // 确保标签位置有效
-        if (label_x < 0 || label_y < 0 || 
-            label_x + label_width > width || 
-            label_y + label_height > height) {
-            continue;
-        }
+    if (!g_LabelRenderer.render(stCanvasInfo, labels)) {
+        return RK_SUCCESS;
+    }
 
-        // 绘制半透明黑色背景
-        cv::Rect bg_rect(label_x, label_y, label_width, label_height);
-        cv::rectangle(bitmapMat, bg_rect, cv::Scalar(0, 0, 0, 180), -1);
-        
-        // 绘制文本
-        cv::putText(bitmapMat, text, 
-                   cv::Point(label_x + 8, label_y + label_height/2 + 6), 
-                   cv::FONT_HERSHEY_DUPLEX, 0.6, 
-                   cv::Scalar(255, 255, 255, 255), 1, cv::LINE_AA);
-        
-        // 绘制边框
-        cv::rectangle(bitmapMat, bg_rect, cv::Scalar(100, 100, 100, 200), 1);
-    }
-
-    // 设置位图
-    int ret = RK_MPI_RGN_SetBitMap(g_LabelRgnHandle, &stBitmap);
+    ret = RK_MPI_RGN_UpdateCanvas(g_LabelRgnHandle);
     if (ret != RK_SUCCESS) {
-        RK_LOGE("Set bitmap failed with %#x\n", ret);
-        free(stBitmap.pData);
+        RK_LOGE("Update label canvas failed with %#x\n", ret);
         return ret;
     }
-
-    // 释放位图内存
-    free(stBitmap.pData);
     return RK_SUCCESS;
 }
 
@@ -251,6 +165,13 @@ RK_S32 rgn_draw_nn_init(RGN_HANDLE RgnHandle)
     // 初始化视频编码区域的属性
     int ret = 0;
 
+    ParamSnapshotPtr config = rk_param_snapshot();
+    g_RgnWidth = config->get(param_key::video0_width);
+    g_RgnHeight = config->get(param_key::video0_height);
+    g_PredictEnable = config->get(param_key::ai_od_predict);
+    g_PredictLatencyUs = (uint64_t)config->get(param_key::ai_od_latency_ms) * 1000;
+    g_PredictMinScore = config->get(param_key::ai_od_predict_min_score);
+
     RGN_ATTR_S stRgnAttr;
     MPP_CHN_S stMppChn;
     RGN_CHN_ATTR_S stRgnChnAttr;
@@ -261,9 +182,9 @@ RK_S32 rgn_draw_nn_init(RGN_HANDLE RgnHandle)
     memset(&stRgnAttr, 0, sizeof(stRgnAttr));
     stRgnAttr.enType = OVERLAY_RGN;
     stRgnAttr.unAttr.stOverlay.enPixelFmt = RK_FMT_2BPP;
-    stRgnAttr.unAttr.stOverlay.u32CanvasNum = 1;
-    stRgnAttr.unAttr.stOverlay.stSize.u32Width = 2304;
-    stRgnAttr.unAttr.stOverlay.stSize.u32Height = 1296;
+    stRgnAttr.unAttr.stOverlay.u32CanvasNum = 2;    // 双缓冲，编码器不会读到绘制到一半的画布
+    stRgnAttr.unAttr.stOverlay.stSize.u32Width = g_RgnWidth;
+    stRgnAttr.unAttr.stOverlay.stSize.u32Height = g_RgnHeight;
     ret = RK_MPI_RGN_Create(RgnHandle, &stRgnAttr);
     if (RK_SUCCESS != ret) {
         printf("RK_MPI_RGN_Create (%d) failed with %#x\n", RgnHandle, ret);
@@ -272,8 +193,8 @@ RK_S32 rgn_draw_nn_init(RGN_HANDLE RgnHandle)
     }
     printf("The handle: %d, create success\n", RgnHandle);
     // after malloc max size, it needs to be set to the actual size
-    stRgnAttr.unAttr.stOverlay.stSize.u32Width = 2304;
-    stRgnAttr.unAttr.stOverlay.stSize.u32Height = 1296;
+    stRgnAttr.unAttr.stOverlay.stSize.u32Width = g_RgnWidth;
+    stRgnAttr.unAttr.stOverlay.stSize.u32Height = g_RgnHeight;
     ret = RK_MPI_RGN_SetAttr(RgnHandle, &stRgnAttr);
     if (RK_SUCCESS != ret) {
         printf("RK_MPI_RGN_SetAttr (%d) failed with %#x!", RgnHandle, ret);
@@ -318,6 +239,7 @@ int rgn_draw_nn_deinit() {
     rgn_thread_run_ = false;
     cv_draw_queue.notify_all();
     pthread_join(rgn_draw_thread_id, NULL);
+    g_BoxDrawn.clear();
 
     // 清理所有标签区域
     for (auto label_id : created_labels) {
@@ -354,95 +276,84 @@ int rgn_draw_nn_deinit() {
         RK_MPI_RGN_DetachFromChn(g_LabelRgnHandle, &stChn);
         RK_MPI_RGN_Destroy(g_LabelRgnHandle);
         g_LabelRgnCreated = false;
+        g_LabelRenderer.reset();
     }
 
     return ret;
 }
 
-RK_S32 draw_rect_2bpp(RK_U8 *buffer, RK_U32 width, RK_U32 height, int rgn_x, int rgn_y, int rgn_w,
-                      int rgn_h, int line_pixel, COLOR_INDEX_E color_index, const char* label) {
-    int i;
-    RK_U8 value = (color_index == 0) ? 0xff : 0xaa;
+// 一行中连续的像素区间，2BPP 每字节 4 个像素，像素 p 占 bit[2p+1:2p]
+// 首尾不满一个字节时用掩码保留相邻像素，x 不需要按 4 像素对齐
+struct Span2bpp {
+    int first;      // 首字节
+    int last;       // 尾字节
+    RK_U8 head;     // 首字节中属于区间的位
+    RK_U8 tail;     // 尾字节中属于区间的位
+};
 
-    if (line_pixel > 4) {
-        RK_LOGE("line_pixel > 4, not support");
-        return RK_FAILURE;
+// 区间 [x0, x1)，要求 x0 < x1
+static Span2bpp span_2bpp(int x0, int x1) {
+    Span2bpp span;
+    span.first = x0 >> 2;
+    span.last = (x1 - 1) >> 2;
+    span.head = (RK_U8)(0xff << ((x0 & 3) * 2));
+    span.tail = (RK_U8)(0xff >> ((3 - ((x1 - 1) & 3)) * 2));
+    if (span.first == span.last) {
+        span.head &= span.tail;
+        span.tail = span.head;
     }
+    return span;
+}
 
-    // 绘制检测框
-    RK_U8 *ptr = buffer + (width * rgn_y + rgn_x) / 4;
+// pattern 为 2 位像素值重复 4 次
+static inline void fill_span_2bpp(RK_U8 *row, const Span2bpp& span, RK_U8 pattern) {
+    row[span.first] = (row[span.first] & ~span.head) | (pattern & span.head);
+    if (span.last != span.first) {
+        if (span.last - span.first > 1) {
+            memset(row + span.first + 1, pattern, span.last - span.first - 1);
+        }
+        row[span.last] = (row[span.last] & ~span.tail) | (pattern & span.tail);
+    }
+}
 
-    // 绘制顶部线条
-    for (i = 0; i < line_pixel; i++) {
-        memset(ptr, value, (rgn_w + 3) / 4);
-        ptr += width / 4;
+// 只写矩形边框上的像素，value 为 0 时即擦除
+static void stroke_rect_2bpp(RK_U8 *buffer, RK_U32 width, RK_U32 height, const cv::Rect& rect,
+                             int line_pixel, RK_U8 value) {
+    cv::Rect box = rect & cv::Rect(0, 0, (int)width, (int)height);
+    if (box.width <= 0 || box.height <= 0) {
+        return;
+    }
+    RK_U8 pattern = value * 0x55;
+    int right = box.x + box.width;
+    Span2bpp full = span_2bpp(box.x, right);
+    Span2bpp left = span_2bpp(box.x, std::min(box.x + line_pixel, right));
+    Span2bpp right_edge = span_2bpp(std::max(right - line_pixel, box.x), right);
+
+    int stride = width / 4;
+    RK_U8 *row = buffer + (size_t)box.y * stride;
+    int y = 0;
+    for (; y < line_pixel && y < box.height; y++, row += stride) {
+        fill_span_2bpp(row, full, pattern);
     }
+    for (; y < box.height - line_pixel; y++, row += stride) {
+        fill_span_2bpp(row, left, pattern);
+        fill_span_2bpp(row, right_edge, pattern);
+    }
+    for (; y < box.height; y++, row += stride) {
+        fill_span_2bpp(row, full, pattern);
+    }
+}
 
-    // 绘制左右线条
-    for (i = 0; i < (rgn_h - line_pixel * 2); i++) {
-        if (color_index == RGN_COLOR_LUT_INDEX_1) {
-            *ptr = rgn_color_lut_1_left_value[line_pixel - 1];
-            *(ptr + ((rgn_w + 3) / 4)) = rgn_color_lut_1_right_value[line_pixel - 1];
-        } else {
-            *ptr = rgn_color_lut_0_left_value[line_pixel - 1];
-            *(ptr + ((rgn_w + 3) / 4)) = rgn_color_lut_0_right_value[line_pixel - 1];
-        }
-        ptr += width / 4;
-    }
-
-    // 绘制底部线条
-    for (i = 0; i < line_pixel; i++) {
-        memset(ptr, value, (rgn_w + 3) / 4);
-        ptr += width / 4;
-    }
-
-    // 如果有标签，添加到标签列表中而不是创建新的OSD区域
-    if (label && strlen(label) > 0) {
-        // 计算标签位置和大小
-        int label_height = 28;
-        int label_margin = 2;
-        int label_y = (rgn_y > label_height + label_margin) ? 
-                     (rgn_y - label_height - label_margin) : (rgn_y + label_margin);
-        
-        int text_len = strlen(label);
-        int label_width = text_len * 14 + 10; // 根据文本长度调整宽度
-        
-        // 确保标签宽度合适
-        if (label_width > rgn_w) {
-            label_width = rgn_w;
-        }
-        if (label_width < 60) {
-            label_width = 60;
-        }
-        
-        // 计算标签X坐标使其居中
-        int label_x = rgn_x + (rgn_w - label_width) / 2;
-        
-        // 确保标签位置有效
-        if (label_x < 0) label_x = 0;
-        if (label_y < 0) label_y = 0;
-        if (label_x + label_width > width) label_width = width - label_x;
-        if (label_y + label_height > height) label_height = height - label_y;
-        
-        // 添加到全局标签列表
-        static std::mutex labels_mtx;
-        {
-            std::lock_guard<std::mutex> lock(labels_mtx);
-            // 如果有添加新标签，需要在后续处理
-            // 这里我们记录标签位置，稍后统一绘制
-            static std::vector<std::tuple<int, int, int, int, std::string>> labels_to_draw;
-            labels_to_draw.emplace_back(label_x, label_y, label_width, label_height, std::string(label));
-            
-            // 仅从绘制线程中调用，避免多线程访问冲突
-            if (pthread_self() == rgn_draw_thread_id) {
-                if (!labels_to_draw.empty()) {
-                    draw_label_on_global_rgn(labels_to_draw);
-                    labels_to_draw.clear();
-                }
-            }
-        }
+RK_S32 draw_rect_2bpp(RK_U8 *buffer, RK_U32 width, RK_U32 height, int rgn_x, int rgn_y, int rgn_w,
+                      int rgn_h, int line_pixel, COLOR_INDEX_E color_index) {
+    if (line_pixel > 4) {
+        RK_LOGE("line_pixel > 4, not support");
+        return RK_FAILURE;
     }
 
+    // 绘制检测框，x 不需要按 4 像素对齐
+    RK_U8 value = (color_index == RGN_COLOR_LUT_INDEX_0) ? 0x3 : 0x2;
+    stroke_rect_2bpp(buffer, width, height, cv::Rect(rgn_x, rgn_y, rgn_w, rgn_h), line_pixel, value);
     return RK_SUCCESS;
 }
 
@@ -471,15 +382,20 @@ void rgn_add_draw_task(const RgnDrawParams& params) {
     batch_idx = (batch_idx + 1) % INT32_MAX;
     idxMutex.unlock();
     task.batch_num = 1;
+    task.pts_us = 0;
+    task.enqueue_us = 0;
     rgn_draw_queue_push(task);
     cv_draw_queue.notify_all();  // 通知绘制线程新任务到来
 }
 
 // 批量添加绘制任务，填充绘制批次号，绘制批次数量
-void rgn_add_draw_tasks_batch(const std::vector<RgnDrawParams>& params) {
+void rgn_add_draw_tasks_batch(const std::vector<RgnDrawParams>& params, uint64_t pts_us) {
+    uint64_t enqueue_us = latencyNowUs();
     for (const auto& p : params) {
         RgnDrawTask task;
         task.params = p;
+        task.pts_us = pts_us;
+        task.enqueue_us = enqueue_us;
         idxMutex.lock();
         task.batch_idx = batch_idx;
         idxMutex.unlock();
@@ -494,6 +410,71 @@ void rgn_add_draw_tasks_batch(const std::vector<RgnDrawParams>& params) {
     cv_draw_queue.notify_all();  // 通知绘制线程新任务到来
 }
 
+// 检测框外推的最大时长和最大位移（相对框尺寸），速度估计出错时检测框不会飞离目标
+static const uint64_t kMaxPredictUs = 500000;
+static const float kMaxPredictShift = 0.5f;
+
+// 按目标速度把检测框从检测帧的采集时刻外推到当前时刻
+static void predict_box(const RgnDrawTask& task, int* x, int* y) {
+    const RgnDrawParams& params = task.params;
+    if (!g_PredictEnable || task.pts_us == 0 || (params.vx == 0 && params.vy == 0)) {
+        return;
+    }
+
+    uint64_t lead_us = g_PredictLatencyUs;
+    if (lead_us == 0) {
+        uint64_t now = latencyNowUs();
+        lead_us = now > task.pts_us ? now - task.pts_us : 0;
+    }
+    if (lead_us > kMaxPredictUs) {
+        lead_us = kMaxPredictUs;
+    }
+    float lead = (float)lead_us / 1000000.0f;
+    if (params.score < g_PredictMinScore) {
+        lead *= params.score / g_PredictMinScore;
+    }
+
+    float max_dx = params.w * kMaxPredictShift;
+    float max_dy = params.h * kMaxPredictShift;
+    float dx = std::max(-max_dx, std::min(max_dx, params.vx * lead));
+    float dy = std::max(-max_dy, std::min(max_dy, params.vy * lead));
+    *x = std::max(0, *x + (int)dx);
+    *y = std::max(0, *y + (int)dy);
+}
+
+// 计算检测框在画布上的位置，并把标签加入本帧的标签列表，框为空时返回 false
+static bool place_task_on_canvas(const RgnDrawTask& task, const RGN_CANVAS_INFO_S& canvas, int line_pixel,
+                                 cv::Rect* box, std::vector<LabelItem>& frame_labels) {
+    int x = task.params.x;
+    int y = task.params.y;
+    predict_box(task, &x, &y);
+    x &= ~1;  // 确保是2的倍数
+    y &= ~1;
+    int w = task.params.w & ~1;
+    int h = task.params.h & ~1;
+
+    // 边界检查
+    if (w <= 0 || h <= 0) return false;
+    if (x + w > (int)canvas.stSize.u32Width) {
+        w = canvas.stSize.u32Width - x - line_pixel;
+    }
+    if (y + h > (int)canvas.stSize.u32Height) {
+        h = canvas.stSize.u32Height - y - line_pixel;
+    }
+    if (w <= 0 || h <= 0) return false;
+
+    *box = cv::Rect(x, y, w, h);
+
+    // 标签在所有检测框绘制完后统一绘制，置信度取整数百分比，相同文字的标签可以复用已渲染的图像
+    if (task.params.label[0] != '\0') {
+        float score = smooth_label_score(task.params.track_id, task.params.score, latencyNowUs());
+        char text[48];
+        snprintf(text, sizeof(text), "%s %d", task.params.label, (int)(score * 100.0f));
+        frame_labels.push_back({x, y, w, text});
+    }
+    return true;
+}
+
 // 绘制线程，支持异步绘制和批量绘制
 void *rgn_draw_thread(void *arg) {
     RGN_HANDLE RgnHandle = (RGN_HANDLE)arg;
@@ -501,10 +482,52 @@ void *rgn_draw_thread(void *arg) {
     int line_pixel = 2;
     RGN_CANVAS_INFO_S stCanvasInfo;
 
-    // 用于收集所有标签信息
-    std::vector<std::tuple<int, int, int, int, std::string>> frame_labels;
+    // 当前批次的任务、检测框和标签
+    std::vector<RgnDrawTask> batch;
+    std::vector<cv::Rect> boxes;
+    std::vector<LabelItem> frame_labels;
 
     while (rgn_thread_run_) {
+        // 先收齐一个批次再取画布，画布只在擦除和绘制期间占用
+        batch.clear();
+        int currentBatchIdx = -1;
+        int remainingInBatch = 0;
+
+        while (rgn_thread_run_) {
+            std::unique_lock<std::mutex> lck(queueMutex);
+
+            // 等待新任务或退出信号
+            cv_draw_queue.wait(lck, [&] {
+                return !drawTaskQueue.empty() || !rgn_thread_run_;
+            });
+
+            if (drawTaskQueue.empty()) {
+                break;  // 线程退出
+            }
+
+            // 处理批次
+            if (currentBatchIdx == -1) {
+                currentBatchIdx = drawTaskQueue.front().batch_idx;
+                remainingInBatch = drawTaskQueue.front().batch_num;
+            }
+
+            // 检查是否是当前批次
+            if (drawTaskQueue.front().batch_idx != currentBatchIdx) {
+                break;  // 处理下一批次
+            }
+
+            batch.push_back(drawTaskQueue.front());
+            drawTaskQueue.pop();
+
+            // 空任务也计入批次数量，批次完成后立即更新画布
+            if (--remainingInBatch <= 0) {
+                break;  // 当前批次完成
+            }
+        }
+        if (batch.empty()) {
+            continue;
+        }
+
         ret = RK_MPI_RGN_GetCanvasInfo(RgnHandle, &stCanvasInfo);
         if (ret != RK_SUCCESS) {
             RK_LOGE("Failed to get canvas info: %#x", ret);
@@ -519,128 +542,38 @@ void *rgn_draw_thread(void *arg) {
             continue;
         }
 
-        // 清理上一帧的OSD标签
-        for (auto label_id : created_labels) {
-            RGN_HANDLE labelHandle = BASE_LABEL_ID + label_id;
-            // 先解除绑定，然后销毁
-            MPP_CHN_S stChn = {RK_ID_VENC, 0, 0};
-            RK_MPI_RGN_DetachFromChn(labelHandle, &stChn);
-            RK_MPI_RGN_Destroy(labelHandle);
-        }
-        created_labels.clear();
-
-        // 清空画布
-        memset((void *)stCanvasInfo.u64VirAddr, 0,
-               stCanvasInfo.u32VirWidth * stCanvasInfo.u32VirHeight >> 2);
-
-        // 用于收集所有标签信息，每帧重置
-        frame_labels.clear();
-
-        // 绘制当前批次的所有任务
-        int currentBatchIdx = -1;
-        int remainingInBatch = 0;
+        // 画布阶段的耗时从取得画布算起
+        FrameTrace trace(LatencyPipe::Ai, batch.front().pts_us);
+        trace.start_us = latencyNowUs();
 
-        while (rgn_thread_run_) {
-            // 获取任务
-            RgnDrawTask task;
-            {
-                std::unique_lock<std::mutex> lck(queueMutex);
-                
-                // 等待新任务或退出信号
-                cv_draw_queue.wait(lck, [&] {
-                    return !drawTaskQueue.empty() || !rgn_thread_run_;
-                });
-                
-                if (drawTaskQueue.empty()) {
-                    if (!rgn_thread_run_) {
-                        break;  // 线程退出
-                    }
-                    continue;  // 继续等待
-                }
-
-                // 处理批次
-                if (currentBatchIdx == -1) {
-                    currentBatchIdx = drawTaskQueue.front().batch_idx;
-                    remainingInBatch = drawTaskQueue.front().batch_num;
-                }
-
-                // 检查是否是当前批次
-                if (drawTaskQueue.front().batch_idx != currentBatchIdx) {
-                    break;  // 处理下一批次
-                }
-
-                task = drawTaskQueue.front();
-                drawTaskQueue.pop();
-            }
-
-            // 处理单个任务
-            int x = task.params.x & ~1;  // 确保是2的倍数
-            int y = task.params.y & ~1;
-            int w = task.params.w & ~1;
-            int h = task.params.h & ~1;
-
-            // 边界检查
-            if (w <= 0 || h <= 0) continue;
-            if (x + w > stCanvasInfo.stSize.u32Width) {
-                w = stCanvasInfo.stSize.u32Width - x - line_pixel;
-            }
-            if (y + h > stCanvasInfo.stSize.u32Height) {
-                h = stCanvasInfo.stSize.u32Height - y - line_pixel;
-            }
-            if (w <= 0 || h <= 0) continue;
-
-            // 绘制检测框和标签
-            draw_rect_2bpp((RK_U8 *)stCanvasInfo.u64VirAddr,
-                          stCanvasInfo.u32VirWidth,
-                          stCanvasInfo.u32VirHeight,
-                          x, y, w, h,
-                          line_pixel,
-                          RGN_COLOR_LUT_INDEX_0,
-                          task.params.label);
-
-            // 如果有标签，添加到标签列表中
-            if (task.params.label && strlen(task.params.label) > 0) {
-                // 计算标签位置和大小
-                int label_height = 28;
-                int label_margin = 2;
-                int label_y = (y > label_height + label_margin) ? 
-                             (y - label_height - label_margin) : (y + label_margin);
-                
-                int text_len = strlen(task.params.label);
-                int label_width = text_len * 14 + 10; // 根据文本长度调整宽度
-                
-                // 确保标签宽度合适
-                if (label_width > w) {
-                    label_width = w;
-                }
-                if (label_width < 60) {
-                    label_width = 60;
-                }
-                
-                // 计算标签X坐标使其居中
-                int label_x = x + (w - label_width) / 2;
-                
-                // 确保标签位置有效
-                if (label_x < 0) label_x = 0;
-                if (label_y < 0) label_y = 0;
-                if (label_x + label_width > stCanvasInfo.stSize.u32Width) label_width = stCanvasInfo.stSize.u32Width - label_x;
-                if (label_y + label_height > stCanvasInfo.stSize.u32Height) label_height = stCanvasInfo.stSize.u32Height - label_y;
-                
-                // 添加到全局标签列表
-                frame_labels.emplace_back(label_x, label_y, label_width, label_height, std::string(task.params.label));
+        // 双缓冲画布轮换使用，每块缓冲区只擦除它上次画过的检测框，第一次使用时整块清空
+        RK_U8 *canvas = (RK_U8 *)stCanvasInfo.u64VirAddr;
+        auto found = g_BoxDrawn.find(stCanvasInfo.u64VirAddr);
+        if (found == g_BoxDrawn.end()) {
+            memset(canvas, 0, stCanvasInfo.u32VirWidth * stCanvasInfo.u32VirHeight >> 2);
+            found = g_BoxDrawn.emplace(stCanvasInfo.u64VirAddr, std::vector<cv::Rect>()).first;
+        } else {
+            for (const auto& rect : found->second) {
+                stroke_rect_2bpp(canvas, stCanvasInfo.u32VirWidth, stCanvasInfo.u32VirHeight,
+                                 rect, line_pixel, 0);
             }
+        }
 
-            // 更新批次计数
-            remainingInBatch--;
-            if (remainingInBatch <= 0) {
-                break;  // 当前批次完成
+        // 绘制当前批次的所有检测框，擦除时可能碰到的重叠部分一并重画
+        boxes.clear();
+        frame_labels.clear();
+        for (const auto& task : batch) {
+            cv::Rect box;
+            if (place_task_on_canvas(task, stCanvasInfo, line_pixel, &box, frame_labels)) {
+                draw_rect_2bpp(canvas, stCanvasInfo.u32VirWidth, stCanvasInfo.u32VirHeight,
+                               box.x, box.y, box.width, box.height, line_pixel, RGN_COLOR_LUT_INDEX_0);
+                boxes.push_back(box);
             }
         }
+        found->second.swap(boxes);
 
-        // 在处理完所有任务后，统一绘制标签
-        if (!frame_labels.empty()) {
-            draw_label_on_global_rgn(frame_labels);
-        }
+        // 在处理完所有任务后，统一绘制标签，没有标签时清除上一帧的标签
+        draw_label_on_global_rgn(frame_labels);
 
         // 更新画布显示
         ret = RK_MPI_RGN_UpdateCanvas(RgnHandle);
@@ -648,6 +581,10 @@ void *rgn_draw_thread(void *arg) {
             RK_LOGE("RK_MPI_RGN_UpdateCanvas failed with %#x!", ret);
             continue;
         }
+        if (trace.pts_us != 0) {
+            trace.mark(LatencyStage::CanvasUpdate);
+            LatencyTracer::instance().submit(trace);
+        }
     }
     return NULL;
 }
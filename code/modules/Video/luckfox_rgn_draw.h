@@ -13,7 +13,10 @@ struct RgnDrawParams {
     RGN_HANDLE RgnHandle;   // 区域句柄
     int x, y, w, h;         // 绘制区域的坐标
     int line_pixel;         // 线条粗细
-    const char* label;      // 目标标签名称
+    char label[32];         // 目标类别名称，为空时不绘制标签
+    float vx, vy;           // 目标中心速度（像素/秒），用于延迟补偿
+    float score;            // 检测置信度，较低时减小外推距离，标签中显示平滑后的值
+    int track_id;           // 跟踪 ID，0 表示未跟踪，标签置信度按它平滑
 };
 
 #define LABEL_MARGIN_TOP 5  // 标签与检测框的距离
@@ -22,6 +25,8 @@ struct RgnDrawTask {
     RgnDrawParams params;
     int batch_idx;    // 批量绘制的批次
     int batch_num;    // 批量绘制的数量
+    uint64_t pts_us;      // 检测帧的采集时间，用于延迟追踪，0 表示未知
+    uint64_t enqueue_us;  // 入队时间
 };
 
 typedef enum rkCOLOR_INDEX_E {
@@ -41,5 +46,5 @@ int rgn_draw_nn_deinit();
 // int rgn_draw_queue_push(RgnDrawParams params);
 // int rgn_draw_queue_pop(RgnDrawParams *params);
 void rgn_add_draw_task(const RgnDrawParams& task);
-void rgn_add_draw_tasks_batch(const std::vector<RgnDrawParams>& tasks);
+void rgn_add_draw_tasks_batch(const std::vector<RgnDrawParams>& tasks, uint64_t pts_us = 0);
 void *rgn_draw_thread(void *arg);
\ No newline at end of file
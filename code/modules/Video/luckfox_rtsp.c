@@ -5,7 +5,7 @@ rtsp_demo_handle g_rtsplive = NULL;
 rtsp_session_handle g_rtsp_session_0, g_rtsp_session_1;
 
 int rtsp_init() {
-	g_rtsplive = create_rtsp_demo(554);
+	g_rtsplive = create_rtsp_demo(RTSP_PORT);
 	g_rtsp_session_0 = rtsp_new_session(g_rtsplive, RTSP_URL_0);
 	g_rtsp_session_1 = rtsp_new_session(g_rtsplive, RTSP_URL_1);
 	rtsp_set_video(g_rtsp_session_0, RTSP_CODEC_ID_VIDEO_H264, NULL, 0);
@@ -32,29 +32,30 @@ int rtsp_deinit() {
 	return 0;
 }
 
-int rtsp_send_frame(int vencChannelId, VENC_STREAM_S* stFrame) {
-    if (0 == vencChannelId) {
-        if (RK_SUCCESS == RK_MPI_VENC_GetStream(vencChannelId, stFrame, -1)) {
-            if (g_rtsplive && g_rtsp_session_0) {
-                void *pData = RK_MPI_MB_Handle2VirAddr(stFrame->pstPack->pMbBlk);
-				pthread_mutex_lock(&g_rtsp_mutex);
-                rtsp_tx_video(g_rtsp_session_0, (uint8_t *)pData, stFrame->pstPack->u32Len, stFrame->pstPack->u64PTS);
-                rtsp_do_event(g_rtsplive);
-				pthread_mutex_unlock(&g_rtsp_mutex);
-            }
-        }
+// 获取一帧编码后的码流，阻塞直到编码完成，成功返回 0
+int rtsp_get_stream(int vencChannelId, VENC_STREAM_S* stFrame) {
+    if (vencChannelId != 0 && vencChannelId != 1) {
+        return -1;
     }
+    return RK_SUCCESS == RK_MPI_VENC_GetStream(vencChannelId, stFrame, -1) ? 0 : -1;
+}
 
-    if (1 == vencChannelId) {
-        if (RK_SUCCESS == RK_MPI_VENC_GetStream(vencChannelId, stFrame, -1)) {
-            if (g_rtsplive && g_rtsp_session_1) {
-                void *pData = RK_MPI_MB_Handle2VirAddr(stFrame->pstPack->pMbBlk);
-				pthread_mutex_lock(&g_rtsp_mutex);
-                rtsp_tx_video(g_rtsp_session_1, (uint8_t *)pData, stFrame->pstPack->u32Len, stFrame->pstPack->u64PTS);
-                rtsp_do_event(g_rtsplive);
-				pthread_mutex_unlock(&g_rtsp_mutex);
-            }
-        }
+// 将 rtsp_get_stream 取得的码流发送到对应的 RTSP 会话
+int rtsp_tx_stream(int vencChannelId, VENC_STREAM_S* stFrame) {
+    rtsp_session_handle session = vencChannelId == 0 ? g_rtsp_session_0 : g_rtsp_session_1;
+    if (g_rtsplive && session) {
+        void *pData = RK_MPI_MB_Handle2VirAddr(stFrame->pstPack->pMbBlk);
+        pthread_mutex_lock(&g_rtsp_mutex);
+        rtsp_tx_video(session, (uint8_t *)pData, stFrame->pstPack->u32Len, stFrame->pstPack->u64PTS);
+        rtsp_do_event(g_rtsplive);
+        pthread_mutex_unlock(&g_rtsp_mutex);
+    }
+    return 0;
+}
+
+int rtsp_send_frame(int vencChannelId, VENC_STREAM_S* stFrame) {
+    if (rtsp_get_stream(vencChannelId, stFrame) == 0) {
+        rtsp_tx_stream(vencChannelId, stFrame);
     }
     return 0;
 }
\ No newline at end of file
@@ -15,6 +15,8 @@ extern "C" {
 int rtsp_init();
 int rtsp_deinit();
 int rtsp_send_frame(int vencChannelId, VENC_STREAM_S* stFrame);
+int rtsp_get_stream(int vencChannelId, VENC_STREAM_S* stFrame);
+int rtsp_tx_stream(int vencChannelId, VENC_STREAM_S* stFrame);
 
 #ifdef __cplusplus
 }
@@ -137,6 +137,12 @@ int vi_dev_deinit()
 }
 
 int vi_chn_init(int pipeId, int channelId, int width, int height, PIXEL_FORMAT_E enPixelFormat)
+{
+	return vi_chn_init_with_depth(pipeId, channelId, width, height, enPixelFormat, 0);
+}
+
+// depth > 0 时通道绑定到其他模块后仍可以通过 vi_get_frame 取帧
+int vi_chn_init_with_depth(int pipeId, int channelId, int width, int height, PIXEL_FORMAT_E enPixelFormat, int depth)
 {
 	int ret;
 	int buf_cnt = 2;
@@ -153,7 +159,7 @@ int vi_chn_init(int pipeId, int channelId, int width, int height, PIXEL_FORMAT_E
 	vi_chn_attr.enPixelFormat = enPixelFormat;
 	// vi_chn_attr.enPixelFormat = RK_FMT_RGB888;
 	vi_chn_attr.enCompressMode = COMPRESS_MODE_NONE; // COMPRESS_AFBC_16x16;
-	vi_chn_attr.u32Depth = 0;
+	vi_chn_attr.u32Depth = depth;
 	ret = RK_MPI_VI_SetChnAttr(pipeId, channelId, &vi_chn_attr);
 	ret |= RK_MPI_VI_EnableChn(pipeId, channelId);
 	if (ret)
@@ -264,6 +270,48 @@ int venc_release_frame(int vencChannelId, VENC_STREAM_S *stFrame)
 	return 0;
 }
 
+int venc_jpeg_init(int chnId, int width, int height, PIXEL_FORMAT_E enPixelFormat, int quality)
+{
+	// JPEG 抓图通道，按需送帧编码
+	int ret;
+	VENC_RECV_PIC_PARAM_S stRecvParam;
+	VENC_CHN_ATTR_S venc_chn_attr;
+	VENC_JPEG_PARAM_S stJpegParam;
+	memset(&venc_chn_attr, 0, sizeof(VENC_CHN_ATTR_S));
+
+	venc_chn_attr.stVencAttr.enType = RK_VIDEO_ID_JPEG;
+	venc_chn_attr.stVencAttr.enPixelFormat = enPixelFormat;
+	venc_chn_attr.stVencAttr.u32PicWidth = width;
+	venc_chn_attr.stVencAttr.u32PicHeight = height;
+	venc_chn_attr.stVencAttr.u32VirWidth = width;
+	venc_chn_attr.stVencAttr.u32VirHeight = height;
+	venc_chn_attr.stVencAttr.u32StreamBufCnt = 2;
+	venc_chn_attr.stVencAttr.u32BufSize = width * height;
+	venc_chn_attr.stVencAttr.enMirror = MIRROR_NONE;
+	ret = RK_MPI_VENC_CreateChn(chnId, &venc_chn_attr);
+	if (ret != RK_SUCCESS)
+	{
+		printf("ERROR: create JPEG VENC %d error! ret=%#x\n", chnId, ret);
+		return ret;
+	}
+
+	memset(&stJpegParam, 0, sizeof(VENC_JPEG_PARAM_S));
+	stJpegParam.u32Qfactor = quality;
+	RK_MPI_VENC_SetJpegParam(chnId, &stJpegParam);
+
+	memset(&stRecvParam, 0, sizeof(VENC_RECV_PIC_PARAM_S));
+	stRecvParam.s32RecvPicNum = -1;
+	ret = RK_MPI_VENC_StartRecvFrame(chnId, &stRecvParam);
+	if (ret != RK_SUCCESS)
+	{
+		printf("ERROR: start JPEG VENC %d error! ret=%#x\n", chnId, ret);
+		RK_MPI_VENC_DestroyChn(chnId);
+		return ret;
+	}
+
+	return 0;
+}
+
 int bind_vi_to_venc(int pipeId, MPP_CHN_S *vi_chn, MPP_CHN_S *venc_chn)
 {
 	// bind
@@ -300,6 +348,33 @@ int unbind_vi_to_venc(int pipeId, MPP_CHN_S *vi_chn, MPP_CHN_S *venc_chn)
 	return 0;
 }
 
+int bind_vi_chn_to_venc(int viChannelId, int vencChannelId, MPP_CHN_S *vi_chn, MPP_CHN_S *venc_chn)
+{
+	int ret;
+	vi_chn->enModId = RK_ID_VI;
+	vi_chn->s32DevId = 0;
+	vi_chn->s32ChnId = viChannelId;
+	venc_chn->enModId = RK_ID_VENC;
+	venc_chn->s32DevId = 0;
+	venc_chn->s32ChnId = vencChannelId;
+	ret = RK_MPI_SYS_Bind(vi_chn, venc_chn);
+	if (ret)
+		printf("Bind VI %d and VENC %d error! ret=%#x\n", viChannelId, vencChannelId, ret);
+	else
+		printf("Bind VI %d and VENC %d success\n", viChannelId, vencChannelId);
+	return ret;
+}
+
+int unbind_vi_chn_to_venc(MPP_CHN_S *vi_chn, MPP_CHN_S *venc_chn)
+{
+	int ret = RK_MPI_SYS_UnBind(vi_chn, venc_chn);
+	if (ret)
+		printf("Unbind VI %d and VENC %d error! ret=%#x\n", vi_chn->s32ChnId, venc_chn->s32ChnId, ret);
+	else
+		printf("Unbind VI %d and VENC %d success\n", vi_chn->s32ChnId, venc_chn->s32ChnId);
+	return ret;
+}
+
 int vpss_init(int VpssChn, int width, int height)
 {
 	printf("%s\n", __func__);
@@ -48,6 +48,7 @@ RK_U64 TEST_COMM_GetNowUs();
 int vi_dev_init();
 int vi_dev_deinit();
 int vi_chn_init(int pipeId, int channelId, int width, int height, PIXEL_FORMAT_E enPixelFormat);
+int vi_chn_init_with_depth(int pipeId, int channelId, int width, int height, PIXEL_FORMAT_E enPixelFormat, int depth);
 int vi_chn_deinit(int pipeId, int channelId);
 void* vi_get_frame(int pipeId, int viChannelId, int width, int height, VIDEO_FRAME_INFO_S *stViFrame);
 int vi_release_frame(int pipeId, int viChannelId, VIDEO_FRAME_INFO_S *stViFrame);
@@ -56,9 +57,12 @@ int venc_init(int chnId, int width, int height, RK_CODEC_ID_E enType, PIXEL_FORM
 int venc_deinit(int chnId);
 int venc_encode_frame(int vencChannelId, VIDEO_FRAME_INFO_S *venc_frame);
 int venc_release_frame(int vencChannelId, VENC_STREAM_S *stFrame);
+int venc_jpeg_init(int chnId, int width, int height, PIXEL_FORMAT_E enPixelFormat, int quality);
 
 int bind_vi_to_venc(int pipeId, MPP_CHN_S *vi_chn, MPP_CHN_S *venc_chn);
 int unbind_vi_to_venc(int pipeId, MPP_CHN_S *vi_chn, MPP_CHN_S *venc_chn);
+int bind_vi_chn_to_venc(int viChannelId, int vencChannelId, MPP_CHN_S *vi_chn, MPP_CHN_S *venc_chn);
+int unbind_vi_chn_to_venc(MPP_CHN_S *vi_chn, MPP_CHN_S *venc_chn);
 
 int vpss_init(int VpssChn, int width, int height);
 
@@ -22,6 +22,31 @@ char *font_path_[128];
 unsigned int color_index_;
 unsigned int trans_index_;
 
+// 字形缓存：FT_Render_Glyph 得到的 8 位覆盖率位图，按字符和字号缓存
+// 开放寻址，装满后覆盖散列位置上的旧字形，只在 g_font_mutex 下访问
+#define GLYPH_CACHE_SIZE 64
+#define GLYPH_TEXT_MAX 128
+
+typedef struct glyph_cache_entry {
+	wchar_t wch;
+	int font_size;
+	int left;               // 位图左边相对笔位置的偏移
+	int top;                // 位图上边相对 buffer 顶部的偏移
+	int width;
+	int rows;
+	int advance;            // 像素
+	unsigned char *bitmap;  // width * rows，为 NULL 表示空槽
+} glyph_cache_entry_s;
+
+static glyph_cache_entry_s g_glyph_cache[GLYPH_CACHE_SIZE];
+
+static void clear_glyph_cache() {
+	for (int i = 0; i < GLYPH_CACHE_SIZE; i++) {
+		free(g_glyph_cache[i].bitmap);
+		g_glyph_cache[i].bitmap = NULL;
+	}
+}
+
 int create_font(const char *font_path, int font_size) {
 	pthread_mutex_lock(&g_font_mutex);
 	FT_Init_FreeType(&library_);
@@ -41,6 +66,7 @@ int create_font(const char *font_path, int font_size) {
 
 	FT_Set_Pixel_Sizes(face_, font_size, 0);
 	font_size_ = font_size;
+	clear_glyph_cache();
 	memcpy(font_path_, font_path, strlen(font_path));
 	slot_ = face_->glyph;
 	pthread_mutex_unlock(&g_font_mutex);
@@ -50,6 +76,7 @@ int create_font(const char *font_path, int font_size) {
 
 int destroy_font() {
 	pthread_mutex_lock(&g_font_mutex);
+	clear_glyph_cache();
 	if (face_) {
 		FT_Done_Face(face_);
 		face_ = NULL;
@@ -186,15 +213,169 @@ void draw_argb8888_text(unsigned char *buffer, int buf_w, int buf_h, const wchar
 		return;
 	}
 
+	draw_argb8888_text_diff(buffer, buf_w, buf_h, wstr, NULL);
+	// save_argb8888_to_bmp(buffer, buf_w, buf_h);
+}
+
+// 取缓存的字形，未命中时渲染后放入缓存，调用者持有 g_font_mutex
+static const glyph_cache_entry_s *get_glyph(wchar_t wch) {
+	unsigned int hash = ((unsigned int)wch * 2654435761u) ^ (unsigned int)font_size_;
+	int home = hash % GLYPH_CACHE_SIZE;
+	int slot = -1;
+	for (int i = 0; i < GLYPH_CACHE_SIZE; i++) {
+		int index = (home + i) % GLYPH_CACHE_SIZE;
+		glyph_cache_entry_s *entry = &g_glyph_cache[index];
+		if (entry->bitmap == NULL) {
+			slot = index;
+			break;
+		}
+		if (entry->wch == wch && entry->font_size == font_size_)
+			return entry;
+	}
+	if (slot < 0)
+		slot = home;
+
+	FT_Set_Transform(face_, NULL, NULL);
+	if (FT_Load_Char(face_, wch, FT_LOAD_DEFAULT | FT_LOAD_NO_BITMAP)) {
+		LOG_DEBUG("FT_Load_Char error\n");
+		return NULL;
+	}
+	FT_Render_Glyph(slot_, FT_RENDER_MODE_NORMAL); // 8bit per pixel
+
+	glyph_cache_entry_s *entry = &g_glyph_cache[slot];
+	int width = slot_->bitmap.width;
+	int rows = slot_->bitmap.rows;
+	unsigned char *bitmap = malloc(width * rows > 0 ? width * rows : 1);
+	if (!bitmap)
+		return NULL;
+	for (int j = 0; j < rows; j++)
+		memcpy(bitmap + j * width, slot_->bitmap.buffer + j * slot_->bitmap.pitch, width);
+	free(entry->bitmap);
+	entry->wch = wch;
+	entry->font_size = font_size_;
+	entry->left = slot_->bitmap_left;
+	entry->top = (face_->size->metrics.ascender >> 6) - slot_->bitmap_top;
+	entry->width = width;
+	entry->rows = rows;
+	entry->advance = (slot_->advance.x + 32) >> 6;
+	entry->bitmap = bitmap;
+	return entry;
+}
+
+// 预先渲染常用字符（时间中的数字和分隔符）
+void warm_glyph_cache(const wchar_t *wstr) {
+	pthread_mutex_lock(&g_font_mutex);
+	if (face_) {
+		for (; *wstr; wstr++)
+			get_glyph(*wstr);
+	}
+	pthread_mutex_unlock(&g_font_mutex);
+}
+
+// 字符所占的列范围：笔位置到下一个笔位置，以及位图超出的部分
+static void glyph_cell(const glyph_cache_entry_s *glyph, int pen, int *x0, int *x1) {
+	*x0 = pen;
+	*x1 = pen;
+	if (!glyph)
+		return;
+	*x0 = pen + glyph->left < pen ? pen + glyph->left : pen;
+	*x1 = pen + glyph->advance;
+	if (pen + glyph->left + glyph->width > *x1)
+		*x1 = pen + glyph->left + glyph->width;
+}
+
+static void blit_glyph(unsigned int *buffer, int buf_w, int buf_h, const glyph_cache_entry_s *glyph,
+                       int pen) {
+	for (int q = 0; q < glyph->rows; q++) {
+		int j = glyph->top + q;
+		if (j < 0 || j >= buf_h)
+			continue;
+		const unsigned char *src = glyph->bitmap + q * glyph->width;
+		unsigned int *dst = buffer + j * buf_w;
+		for (int p = 0; p < glyph->width; p++) {
+			int i = pen + glyph->left + p;
+			if (src[p] && i >= 0 && i < buf_w)
+				dst[i] = font_color_;
+		}
+	}
+}
+
+// 用缓存的字形绘制字符串，prev 为上次绘制到同一 buffer 的字符串
+// prev 为 NULL 时整块重绘；否则只清除并重绘字符或位置发生变化的格子，以及与被清除格子重叠的字符
+// 返回重绘的字符数，为 0 时 buffer 内容没有变化
+int draw_argb8888_text_diff(unsigned char *buffer, int buf_w, int buf_h, const wchar_t *wstr,
+                            const wchar_t *prev) {
+	int pen_new[GLYPH_TEXT_MAX], x0_new[GLYPH_TEXT_MAX], x1_new[GLYPH_TEXT_MAX];
+	int pen_old[GLYPH_TEXT_MAX], x0_old[GLYPH_TEXT_MAX], x1_old[GLYPH_TEXT_MAX];
+	int cleared_x0[GLYPH_TEXT_MAX], cleared_x1[GLYPH_TEXT_MAX];
+	int cleared = 0, drawn = 0;
+	unsigned int *pixels = (unsigned int *)buffer;
+
+	if (wstr == NULL) {
+		LOG_ERROR("wstr is NULL\n");
+		return 0;
+	}
+
+	pthread_mutex_lock(&g_font_mutex);
+	if (!face_) {
+		LOG_INFO("please check font_path %s\n", *font_path_);
+		pthread_mutex_unlock(&g_font_mutex);
+		return 0;
+	}
+
 	int len = wcslen(wstr);
-	// wprintf("wstr is %ls\n", wstr);
-	// LOG_DEBUG("len is %d\n", len);
-	pen_.x = 0 * 64;
-	pen_.y = 0 * 64;
+	int prev_len = prev ? wcslen(prev) : 0;
+	if (len > GLYPH_TEXT_MAX)
+		len = GLYPH_TEXT_MAX;
+	if (prev_len > GLYPH_TEXT_MAX)
+		prev_len = GLYPH_TEXT_MAX;
+
+	int pen = 0;
 	for (int i = 0; i < len; i++) {
-		draw_argb8888_wchar(buffer, buf_w, buf_h, wstr[i]);
-		pen_.x += slot_->advance.x;
-		pen_.y += slot_->advance.y;
+		const glyph_cache_entry_s *glyph = get_glyph(wstr[i]);
+		pen_new[i] = pen;
+		glyph_cell(glyph, pen, &x0_new[i], &x1_new[i]);
+		pen += glyph ? glyph->advance : 0;
 	}
-	// save_argb8888_to_bmp(buffer, buf_w, buf_h);
+	pen = 0;
+	for (int i = 0; i < prev_len; i++) {
+		const glyph_cache_entry_s *glyph = get_glyph(prev[i]);
+		pen_old[i] = pen;
+		glyph_cell(glyph, pen, &x0_old[i], &x1_old[i]);
+		pen += glyph ? glyph->advance : 0;
+	}
+
+	if (!prev) {
+		memset(buffer, 0, buf_w * buf_h * 4);
+	}
+
+	// 清除消失、改变或移动的字符所在的列
+	for (int i = 0; i < prev_len; i++) {
+		if (i < len && wstr[i] == prev[i] && pen_new[i] == pen_old[i])
+			continue;
+		int x0 = x0_old[i] < 0 ? 0 : x0_old[i];
+		int x1 = x1_old[i] > buf_w ? buf_w : x1_old[i];
+		if (x0 >= x1)
+			continue;
+		for (int j = 0; j < buf_h; j++)
+			memset(pixels + j * buf_w + x0, 0, (x1 - x0) * 4);
+		cleared_x0[cleared] = x0;
+		cleared_x1[cleared] = x1;
+		cleared++;
+	}
+
+	for (int i = 0; i < len; i++) {
+		int redraw = !prev || i >= prev_len || wstr[i] != prev[i] || pen_new[i] != pen_old[i];
+		for (int k = 0; k < cleared && !redraw; k++)
+			redraw = x0_new[i] < cleared_x1[k] && cleared_x0[k] < x1_new[i];
+		if (!redraw)
+			continue;
+		const glyph_cache_entry_s *glyph = get_glyph(wstr[i]);
+		if (glyph)
+			blit_glyph(pixels, buf_w, buf_h, glyph, pen_new[i]);
+		drawn++;
+	}
+	pthread_mutex_unlock(&g_font_mutex);
+
+	return drawn + cleared;
 }
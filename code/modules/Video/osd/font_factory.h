@@ -24,5 +24,8 @@ unsigned int get_font_color();
 void draw_argb8888_buffer(unsigned int *buffer, int buf_w, int buf_h);
 void draw_argb8888_wchar(unsigned char *buffer, int buf_w, int buf_h, const wchar_t wch);
 void draw_argb8888_text(unsigned char *buffer, int buf_w, int buf_h, const wchar_t *wstr);
+void warm_glyph_cache(const wchar_t *wstr);
+int draw_argb8888_text_diff(unsigned char *buffer, int buf_w, int buf_h, const wchar_t *wstr,
+                            const wchar_t *prev);
 
 #endif
\ No newline at end of file
@@ -203,7 +203,13 @@ static void *osd_time_server(void *arg) {
 	sscanf(rk_param_get_string("osd.common:font_color", NULL), "%x", &osd_data.text.font_color);
 	LOG_INFO("osd_data.text.font_color is %x\n", osd_data.text.font_color);
 	osd_data.text.color_inverse = 1;
-	osd_data.text.font_path = rk_param_get_string("osd.common:font_path", NULL);
+	// 时间线程整个生命周期都会用到字体路径，复制一份，参数重新加载后原字符串会被释放
+	static char font_path[256];
+	const char *font_path_param = rk_param_get_string("osd.common:font_path", NULL);
+	if (font_path_param) {
+		snprintf(font_path, sizeof(font_path), "%s", font_path_param);
+		osd_data.text.font_path = font_path;
+	}
 	// osd_data.text.format = rk_param_get_int("osd.common:???", -1);
 
 	// get time
@@ -234,6 +240,11 @@ static void *osd_time_server(void *arg) {
 	}
 	LOG_INFO("osd_data.text.format is %s\n", osd_data.text.format);
 
+	// 预先渲染时间中会出现的字符，之后每秒只复制变化的字符
+	warm_glyph_cache(L"0123456789-/: 年月日星期一二三四五六AMP");
+
+	// buffer 在线程中一直保留，每秒只重绘与上次不同的字符
+	wchar_t last_wch[128];
 	wchar_cnt = generate_date_time(osd_data.text.format, osd_data.text.wch, 128);
 	osd_data.width = UPALIGNTO16(wchar_cnt * osd_data.text.font_size);
 	osd_data.height = UPALIGNTO16(osd_data.text.font_size);
@@ -241,9 +252,9 @@ static void *osd_time_server(void *arg) {
 	osd_data.buffer = malloc(osd_data.size);
 	memset(osd_data.buffer, 0, osd_data.size);
 	fill_text(&osd_data);
+	wcscpy(last_wch, osd_data.text.wch);
 	// rk_osd_bmp_destroy_(osd_time_id);
 	rk_osd_bmp_create_(osd_time_id, &osd_data);
-	free(osd_data.buffer);
 
 	time(&rawtime);
 	cur_time_info = localtime(&rawtime);
@@ -258,15 +269,27 @@ static void *osd_time_server(void *arg) {
 		else
 			last_time_sec = cur_time_info->tm_sec;
 		wchar_cnt = generate_date_time(osd_data.text.format, osd_data.text.wch, 128);
-		osd_data.width = UPALIGNTO16(wchar_cnt * osd_data.text.font_size);
-		osd_data.height = UPALIGNTO16(osd_data.text.font_size);
-		osd_data.size = osd_data.width * osd_data.height * 4; // BGRA8888 4byte
-		osd_data.buffer = malloc(osd_data.size);
-		memset(osd_data.buffer, 0, osd_data.size);
-		fill_text(&osd_data);
-		rk_osd_bmp_change_(osd_time_id, &osd_data);
-		free(osd_data.buffer);
+		int width = UPALIGNTO16(wchar_cnt * osd_data.text.font_size);
+		int height = UPALIGNTO16(osd_data.text.font_size);
+		int changed;
+		if (width != osd_data.width || height != osd_data.height) {
+			// 尺寸变化时重新分配并整块重绘
+			free(osd_data.buffer);
+			osd_data.width = width;
+			osd_data.height = height;
+			osd_data.size = osd_data.width * osd_data.height * 4; // BGRA8888 4byte
+			osd_data.buffer = malloc(osd_data.size);
+			changed = draw_argb8888_text_diff(osd_data.buffer, osd_data.width, osd_data.height,
+			                                  osd_data.text.wch, NULL);
+		} else {
+			changed = draw_argb8888_text_diff(osd_data.buffer, osd_data.width, osd_data.height,
+			                                  osd_data.text.wch, last_wch);
+		}
+		wcscpy(last_wch, osd_data.text.wch);
+		if (changed)
+			rk_osd_bmp_change_(osd_time_id, &osd_data);
 	}
+	free(osd_data.buffer);
 	LOG_INFO("exit\n");
 
 	return 0;
@@ -0,0 +1,296 @@
+#include "privacy_mask.h"
+#include "latency_tracer.h"
+#include "param_snapshot.h"
+#include "log.h"
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+static constexpr int kAlign = 16;
+static constexpr int kMinSize = 32;                 // MOSAIC 区域最小 32x32，COVER 同样使用
+static constexpr uint64_t kMaxLeadUs = 500 * 1000;  // 运动延伸最多按 500ms 计算
+
+PrivacyMask::~PrivacyMask() {
+    deinit();
+}
+
+bool PrivacyMask::init() {
+    ParamSnapshotPtr config = rk_param_snapshot();
+    if (!config->get(param_key::ai_privacy_enable)) {
+        return false;
+    }
+    width = config->get(param_key::video0_width);
+    height = config->get(param_key::video0_height);
+    sub_width = config->get(param_key::video1_width);
+    sub_height = config->get(param_key::video1_height);
+    margin = config->get(param_key::ai_privacy_margin);
+    hold_ms = config->get(param_key::ai_privacy_hold_ms);
+    head_ratio = config->get(param_key::ai_privacy_head_only) ? 1.0f / 3 : 1.0f;
+    mosaic = strcmp(config->get(param_key::ai_privacy_style), "cover") != 0;
+
+    int limit = mosaic ? kMaxMosaicMasks : kMaxMasks;
+    int wanted = config->get(param_key::ai_privacy_max_masks);
+    if (wanted > limit) {
+        LOG_WARN("privacy mask: %d masks requested, %s supports at most %d\n",
+                 wanted, mosaic ? "mosaic" : "cover", limit);
+        wanted = limit;
+    }
+
+    // 所有句柄预先创建并挂到编码通道，初始隐藏
+    RGN_ATTR_S stRgnAttr;
+    memset(&stRgnAttr, 0, sizeof(stRgnAttr));
+    stRgnAttr.enType = mosaic ? MOSAIC_RGN : COVER_RGN;
+    sub_attached = true;
+    for (int i = 0; i < wanted; i++) {
+        int ret = RK_MPI_RGN_Create(kHandleBase + i, &stRgnAttr);
+        if (RK_SUCCESS != ret) {
+            LOG_ERROR("RK_MPI_RGN_Create (%d) failed with %#x\n", kHandleBase + i, ret);
+            break;
+        }
+        slots[i].rect = cv::Rect(0, 0, kMinSize, kMinSize);
+        slots[i].shown = false;
+        if (!attach(i, 0)) {
+            RK_MPI_RGN_Destroy(kHandleBase + i);
+            break;
+        }
+        // 子码流未启动时只遮挡主码流
+        if (sub_attached && !attach(i, 1)) {
+            LOG_ERROR("privacy mask: sub stream is not masked\n");
+            sub_attached = false;
+            for (int k = 0; k < i; k++) {
+                MPP_CHN_S stMppChn = {RK_ID_VENC, 0, 1};
+                RK_MPI_RGN_DetachFromChn(kHandleBase + k, &stMppChn);
+            }
+        }
+        count = i + 1;
+    }
+
+    if (count == 0) {
+        return false;
+    }
+    LOG_INFO("privacy mask: %d %s regions on venc0%s\n", count, mosaic ? "mosaic" : "cover",
+             sub_attached ? " and venc1" : "");
+    return true;
+}
+
+void PrivacyMask::deinit() {
+    for (int i = 0; i < count; i++) {
+        MPP_CHN_S stMppChn = {RK_ID_VENC, 0, 0};
+        RK_MPI_RGN_DetachFromChn(kHandleBase + i, &stMppChn);
+        if (sub_attached) {
+            stMppChn.s32ChnId = 1;
+            RK_MPI_RGN_DetachFromChn(kHandleBase + i, &stMppChn);
+        }
+        RK_MPI_RGN_Destroy(kHandleBase + i);
+    }
+    count = 0;
+    held.clear();
+    for (auto& slot : slots) {
+        slot.track_id = -1;
+    }
+}
+
+// 主码流坐标换算到对应编码通道，并保持对齐和最小尺寸
+static RECT_S channel_rect(const cv::Rect& rect, int chn_width, int chn_height, int width, int height) {
+    RECT_S result;
+    int x0 = rect.x * chn_width / width / kAlign * kAlign;
+    int y0 = rect.y * chn_height / height / kAlign * kAlign;
+    int x1 = ((rect.x + rect.width) * chn_width / width + kAlign - 1) / kAlign * kAlign;
+    int y1 = ((rect.y + rect.height) * chn_height / height + kAlign - 1) / kAlign * kAlign;
+    x1 = std::min(std::max(x1, x0 + kMinSize), chn_width / kAlign * kAlign);
+    y1 = std::min(std::max(y1, y0 + kMinSize), chn_height / kAlign * kAlign);
+    x0 = std::max(0, std::min(x0, x1 - kMinSize));
+    y0 = std::max(0, std::min(y0, y1 - kMinSize));
+    result.s32X = x0;
+    result.s32Y = y0;
+    result.u32Width = x1 - x0;
+    result.u32Height = y1 - y0;
+    return result;
+}
+
+bool PrivacyMask::attach(int index, int venc_chn) {
+    RGN_CHN_ATTR_S stRgnChnAttr;
+    memset(&stRgnChnAttr, 0, sizeof(stRgnChnAttr));
+    MPP_CHN_S stMppChn = {RK_ID_VENC, 0, venc_chn};
+    int chn_width = venc_chn == 0 ? width : sub_width;
+    int chn_height = venc_chn == 0 ? height : sub_height;
+
+    stRgnChnAttr.bShow = RK_FALSE;
+    if (mosaic) {
+        stRgnChnAttr.enType = MOSAIC_RGN;
+        stRgnChnAttr.unChnAttr.stMosaicChn.stRect = channel_rect(slots[index].rect, chn_width, chn_height, width, height);
+        stRgnChnAttr.unChnAttr.stMosaicChn.enBlkSize = venc_chn == 0 ? MOSAIC_BLK_SIZE_32 : MOSAIC_BLK_SIZE_8;
+        stRgnChnAttr.unChnAttr.stMosaicChn.u32Layer = index;
+    } else {
+        stRgnChnAttr.enType = COVER_RGN;
+        stRgnChnAttr.unChnAttr.stCoverChn.stRect = channel_rect(slots[index].rect, chn_width, chn_height, width, height);
+        stRgnChnAttr.unChnAttr.stCoverChn.u32Color = 0x000000;
+        stRgnChnAttr.unChnAttr.stCoverChn.u32Layer = index;
+        stRgnChnAttr.unChnAttr.stCoverChn.enCoordinate = RGN_ABS_COOR;
+    }
+    int ret = RK_MPI_RGN_AttachToChn(kHandleBase + index, &stMppChn, &stRgnChnAttr);
+    if (RK_SUCCESS != ret) {
+        LOG_ERROR("RK_MPI_RGN_AttachToChn (%d) to venc%d failed with %#x\n", kHandleBase + index, venc_chn, ret);
+        return false;
+    }
+    return true;
+}
+
+bool PrivacyMask::show(int index, int venc_chn, const cv::Rect& rect, bool visible) {
+    RGN_CHN_ATTR_S stRgnChnAttr;
+    MPP_CHN_S stMppChn = {RK_ID_VENC, 0, venc_chn};
+    int chn_width = venc_chn == 0 ? width : sub_width;
+    int chn_height = venc_chn == 0 ? height : sub_height;
+
+    // 取回挂载时的属性，只改位置和显隐
+    int ret = RK_MPI_RGN_GetDisplayAttr(kHandleBase + index, &stMppChn, &stRgnChnAttr);
+    if (RK_SUCCESS != ret) {
+        return false;
+    }
+    stRgnChnAttr.bShow = visible ? RK_TRUE : RK_FALSE;
+    if (mosaic) {
+        stRgnChnAttr.unChnAttr.stMosaicChn.stRect = channel_rect(rect, chn_width, chn_height, width, height);
+    } else {
+        stRgnChnAttr.unChnAttr.stCoverChn.stRect = channel_rect(rect, chn_width, chn_height, width, height);
+    }
+    ret = RK_MPI_RGN_SetDisplayAttr(kHandleBase + index, &stMppChn, &stRgnChnAttr);
+    if (RK_SUCCESS != ret) {
+        LOG_ERROR("RK_MPI_RGN_SetDisplayAttr (%d) on venc%d failed with %#x\n", kHandleBase + index, venc_chn, ret);
+        return false;
+    }
+    return true;
+}
+
+// 向外对齐到 16 像素，目标小幅抖动时区域位置不变
+cv::Rect PrivacyMask::align(const cv::Rect& rect) const {
+    int x0 = std::max(0, rect.x) / kAlign * kAlign;
+    int y0 = std::max(0, rect.y) / kAlign * kAlign;
+    int x1 = std::min(width, (rect.x + rect.width + kAlign - 1) / kAlign * kAlign);
+    int y1 = std::min(height, (rect.y + rect.height + kAlign - 1) / kAlign * kAlign);
+    return cv::Rect(x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0));
+}
+
+void PrivacyMask::cover() {
+    held.clear();
+    for (int i = 0; i < count; i++) {
+        bool visible = i == 0;
+        cv::Rect rect = visible ? cv::Rect(0, 0, width, height) : slots[i].rect;
+        slots[i].track_id = -1;
+        if (visible == slots[i].shown && rect == slots[i].rect) {
+            continue;
+        }
+        bool ok = show(i, 0, rect, visible);
+        if (sub_attached) {
+            ok = show(i, 1, rect, visible) && ok;
+        }
+        if (ok) {
+            slots[i].rect = rect;
+            slots[i].shown = visible;
+        }
+    }
+}
+
+// 按头部比例裁剪、外扩边距，再与按速度外推到当前时刻的位置合并
+cv::Rect PrivacyMask::region(const cv::Rect& rect, float vx, float vy, uint64_t pts_us, uint64_t now) const {
+    float lead = (pts_us != 0 && pts_us < now) ? (float)std::min(now - pts_us, kMaxLeadUs) / 1e6f : 0.0f;
+    cv::Rect head(rect.x, rect.y, rect.width, std::max(1, (int)std::lround(rect.height * head_ratio)));
+    head = cv::Rect(head.x - margin, head.y - margin, head.width + 2 * margin, head.height + 2 * margin);
+    cv::Rect moved = head + cv::Point((int)std::lround(vx * lead), (int)std::lround(vy * lead));
+    return align(head | moved);
+}
+
+void PrivacyMask::addSubject(int track_id, const cv::Rect& rect) {
+    if (rect.area() <= 0) {
+        return;
+    }
+    auto it = std::find_if(subjects.begin(), subjects.end(), [&](const Subject& s) { return s.track_id == track_id; });
+    if (it == subjects.end()) {
+        subjects.push_back({track_id, rect});
+    } else {
+        it->region |= rect;
+    }
+}
+
+void PrivacyMask::update(const std::vector<Object>& people, uint64_t pts_us) {
+    if (count == 0) {
+        return;
+    }
+    uint64_t now = latencyNowUs();
+    subjects.clear();
+
+    // 本帧每个检测框都生成遮挡区域；跟踪结果与输入一一对应，只取速度和跟踪 ID
+    if (!people.empty()) {
+        std::vector<Object> tracked = tracker.update(people, pts_us);
+        for (size_t k = 0; k < people.size(); k++) {
+            const Object& object = tracked[k];
+            addSubject(object.track_id, region(people[k].rect, object.vx, object.vy, pts_us, now));
+            auto it = std::find_if(held.begin(), held.end(), [&](const Held& h) { return h.track_id == object.track_id; });
+            if (it == held.end()) {
+                held.push_back({object.track_id, people[k].rect, object.vx, object.vy, pts_us, now});
+            } else if (it->last_us == now) {
+                it->rect |= people[k].rect;     // 同一跟踪 ID 本帧已出现过
+            } else {
+                *it = {object.track_id, people[k].rect, object.vx, object.vy, pts_us, now};
+            }
+        }
+    }
+
+    // 本帧漏检的目标在 hold_ms 内保持遮挡
+    uint64_t hold_us = (uint64_t)hold_ms * 1000;
+    held.erase(std::remove_if(held.begin(), held.end(), [&](const Held& h) { return now - h.last_us > hold_us; }),
+               held.end());
+    for (const auto& h : held) {
+        if (h.last_us != now) {
+            addSubject(h.track_id, region(h.rect, h.vx, h.vy, h.pts_us, now));
+        }
+    }
+
+    // 已占用句柄的目标保持原句柄，离开的目标释放句柄，新目标占用空闲句柄；
+    // 句柄用完时，其余目标合并到最后一个句柄
+    cv::Rect next[kMaxMasks];
+    bool visible[kMaxMasks] = {false};
+    for (int i = 0; i < count; i++) {
+        auto it = std::find_if(subjects.begin(), subjects.end(), [&](const Subject& s) { return s.track_id == slots[i].track_id; });
+        if (slots[i].track_id >= 0 && it != subjects.end()) {
+            next[i] = it->region;
+            visible[i] = true;
+            it->track_id = -1;      // 已分配
+        } else {
+            slots[i].track_id = -1;
+        }
+    }
+    for (const auto& subject : subjects) {
+        if (subject.track_id < 0) {
+            continue;
+        }
+        int free_slot = -1;
+        for (int i = 0; i < count && free_slot < 0; i++) {
+            if (slots[i].track_id < 0) {
+                free_slot = i;
+            }
+        }
+        if (free_slot >= 0) {
+            slots[free_slot].track_id = subject.track_id;
+            next[free_slot] = subject.region;
+            visible[free_slot] = true;
+        } else {
+            next[count - 1] |= subject.region;
+        }
+    }
+
+    // 只更新位置或显隐变化的区域
+    for (int i = 0; i < count; i++) {
+        cv::Rect rect = visible[i] ? next[i] : slots[i].rect;
+        if (visible[i] == slots[i].shown && rect == slots[i].rect) {
+            continue;
+        }
+        bool ok = show(i, 0, rect, visible[i]);
+        if (sub_attached) {
+            ok = show(i, 1, rect, visible[i]) && ok;
+        }
+        if (ok) {
+            slots[i].rect = rect;
+            slots[i].shown = visible[i];
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef PRIVACY_MASK_H
+#define PRIVACY_MASK_H
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "sample_comm.h"
+#include "tracker/BYTETracker.h"
+
+// 动态隐私遮挡
+//
+// 按跟踪结果遮挡画面中的人员，由编码器的 MOSAIC / COVER 区域完成，不在 CPU 上处理图像：
+//   - 初始化时创建固定数量的区域句柄，挂到 VENC 0 和 VENC 1 并全部隐藏；
+//   - 每帧只对位置或显隐有变化的句柄调用 RK_MPI_RGN_SetDisplayAttr，不再创建和销毁区域；
+//   - 区域挂在编码通道而不是 VI 上，AI 输入不受遮挡影响，否则被遮挡的人员无法再被检测到。
+//
+// 每帧开销：最多 max_masks × 2 次 SetDisplayAttr（每次一次 ioctl），区域按 16 像素对齐，
+// 目标静止时位置不变，不产生调用。
+// 遮挡数量上限：MOSAIC 区域层号范围 [0,3]，每个通道最多 4 个；COVER 层号范围 [0,7]，最多 8 个。
+// 每帧按全部人员检测框生成遮挡区域，跟踪器只提供速度和漏检保持，跟踪 ID 重复或匹配错误时也不漏遮。
+// 目标检测不可用或尚未输出结果时遮挡整幅画面，不输出未遮挡的码流。
+// 区域句柄按跟踪 ID 分配，目标存在期间占用同一个句柄，其他目标出现或消失时不换位；
+// 同一跟踪 ID 在一帧中对应多个检测框时合并为外接矩形。
+// 目标多于区域数量时，超出的目标与最后一个区域合并为外接矩形，保证不漏遮。
+// 遮挡区域按跟踪速度向运动方向延伸到编码时刻的位置，目标短暂漏检时保持原位置 hold_ms，
+// 避免遮挡滞后或闪烁露出画面。
+// 只在 AI 线程中使用，不加锁。
+class PrivacyMask {
+public:
+    static constexpr int kHandleBase = 20;      // 避开 OSD（0-7）、检测框（0）和标签（10）使用的句柄
+    static constexpr int kMaxMasks = 8;
+    static constexpr int kMaxMosaicMasks = 4;
+
+    PrivacyMask() = default;
+    ~PrivacyMask();
+
+    // 读取 ai.privacy 配置并创建区域，未使能或失败时返回 false
+    bool init();
+    void deinit();
+
+    bool enabled() const { return count > 0; }
+
+    // 遮挡整幅画面，用于目标检测不可用或尚未输出结果时；下一次 update() 按检测结果恢复
+    void cover();
+
+    // 传入本帧人员检测框（主码流坐标）和采集时间，更新遮挡区域
+    void update(const std::vector<Object>& people, uint64_t pts_us);
+
+private:
+    struct Slot {
+        cv::Rect rect;      // 主码流坐标，已对齐
+        bool shown = false;
+        int track_id = -1;  // 占用该句柄的跟踪 ID，-1 为空闲
+    };
+
+    struct Held {
+        int track_id;
+        cv::Rect rect;
+        float vx;
+        float vy;
+        uint64_t pts_us;    // 最近一次检测到时的帧采集时间
+        uint64_t last_us;
+    };
+
+    struct Subject {
+        int track_id;
+        cv::Rect region;
+    };
+
+    bool attach(int index, int venc_chn);
+    bool show(int index, int venc_chn, const cv::Rect& rect, bool visible);
+    cv::Rect align(const cv::Rect& rect) const;
+    cv::Rect region(const cv::Rect& rect, float vx, float vy, uint64_t pts_us, uint64_t now) const;
+    void addSubject(int track_id, const cv::Rect& rect);
+
+    int count = 0;
+    bool mosaic = true;
+    bool sub_attached = false;
+    int width = 0;
+    int height = 0;
+    int sub_width = 0;
+    int sub_height = 0;
+    int margin = 16;
+    int hold_ms = 500;
+    float head_ratio = 1.0f;
+
+    BYTETracker tracker;
+    std::vector<Held> held;
+    std::vector<Subject> subjects;      // 本帧需要遮挡的目标，每个跟踪 ID 一项
+    Slot slots[kMaxMasks];
+};
+
+#endif // PRIVACY_MASK_H
@@ -0,0 +1,280 @@
+#include "rate_controller.h"
+#include "latency_tracer.h"
+#include "luckfox_rtsp.h"
+#include "param_snapshot.h"
+#include "log.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+static constexpr uint64_t kWindowUs = 1000 * 1000;
+static constexpr int kCongestedWindows = 2;     // 连续拥塞多少个窗口才降码率
+static constexpr double kDecreaseFactor = 0.7;
+static constexpr double kIncreaseStep = 0.1;    // 每次恢复最大码率的 10%
+static constexpr double kTxBlockedRatio = 0.25; // 发送阻塞比例高于该值视为拥塞
+static constexpr double kTxClearRatio = 0.05;   // 低于该值视为畅通
+
+RateController& RateController::instance() {
+    static RateController controller;
+    return controller;
+}
+
+// 按目标码率确定帧率和 GOP
+static void encoder_profile(int target_kbps, int max_kbps, int full_fps, int base_gop, int* fps, int* gop) {
+    double ratio = max_kbps > 0 ? (double)target_kbps / max_kbps : 1.0;
+    if (ratio >= 0.5) {
+        *fps = full_fps;
+    } else if (ratio >= 0.25) {
+        *fps = std::max(1, full_fps * 2 / 3);
+    } else {
+        *fps = std::max(1, full_fps / 2);
+    }
+    *gop = std::max(1, base_gop * *fps / full_fps * (ratio < 0.5 ? 2 : 1));
+}
+
+static bool set_encoder(int chn, int kbps, int full_fps, int fps, int gop) {
+    VENC_CHN_ATTR_S attr;
+    if (RK_MPI_VENC_GetChnAttr(chn, &attr) != RK_SUCCESS) {
+        LOG_ERROR("RK_MPI_VENC_GetChnAttr (%d) failed\n", chn);
+        return false;
+    }
+    attr.stRcAttr.enRcMode = VENC_RC_MODE_H264CBR;
+    attr.stRcAttr.stH264Cbr.u32BitRate = kbps;
+    attr.stRcAttr.stH264Cbr.u32Gop = gop;
+    attr.stRcAttr.stH264Cbr.u32SrcFrameRateNum = full_fps;
+    attr.stRcAttr.stH264Cbr.u32SrcFrameRateDen = 1;
+    attr.stRcAttr.stH264Cbr.fr32DstFrameRateNum = fps;
+    attr.stRcAttr.stH264Cbr.fr32DstFrameRateDen = 1;
+    int ret = RK_MPI_VENC_SetChnAttr(chn, &attr);
+    if (ret != RK_SUCCESS) {
+        LOG_ERROR("RK_MPI_VENC_SetChnAttr (%d) failed with %#x\n", chn, ret);
+        return false;
+    }
+    return true;
+}
+
+void RateController::attach(int chn) {
+    if (chn < 0 || chn >= kMaxChannels) {
+        return;
+    }
+    ParamSnapshotPtr config = rk_param_snapshot();
+    int kbps;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Channel& c = channels[chn];
+        c = Channel();
+        c.active = true;
+        c.adaptive = config->get(param_key::video_rc_enable);
+        c.max_kbps = chn == 0 ? config->get(param_key::video0_max_rate) : config->get(param_key::video1_max_rate);
+        c.full_fps = chn == 0 ? config->get(param_key::video0_fps) : config->get(param_key::video1_fps);
+        c.base_gop = chn == 0 ? config->get(param_key::video0_gop) : config->get(param_key::video1_gop);
+        c.min_kbps = std::max(64, c.max_kbps * config->get(param_key::video_rc_min_percent) / 100);
+        c.state = c.adaptive ? "stable" : "fixed";
+        c.window_start_us = latencyNowUs();
+        c.idle_enabled = chn == 0 && config->get(param_key::video_idle_enable);
+        c.idle_fps = std::min(c.full_fps, (int)config->get(param_key::video_idle_fps));
+        c.idle_gop_s = config->get(param_key::video_idle_gop_s);
+        c.idle_kbps = std::max(64, c.max_kbps * config->get(param_key::video_idle_rate_percent) / 100);
+        c.idle_hold_us = (uint64_t)config->get(param_key::video_idle_hold_s) * 1000 * 1000;
+        c.last_activity_us = c.window_start_us;
+        backlog_ms = config->get(param_key::video_rc_backlog_ms);
+        recover_s = config->get(param_key::video_rc_recover_s);
+        kbps = c.max_kbps;
+    }
+    apply(chn, kbps, "init");
+}
+
+void RateController::detach(int chn) {
+    if (chn < 0 || chn >= kMaxChannels) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    channels[chn].active = false;
+}
+
+// RTSP 端口上已建立的 TCP 连接中最大的发送队列，每个窗口最多读取一次
+uint64_t RateController::sampleBacklog(uint64_t now) {
+    if (now - backlog_sampled_us < kWindowUs / 2) {
+        return backlog_bytes;
+    }
+    backlog_sampled_us = now;
+    uint64_t result = 0;
+    const char* files[] = {"/proc/net/tcp", "/proc/net/tcp6"};
+    for (const char* path : files) {
+        FILE* fp = fopen(path, "r");
+        if (fp == NULL) {
+            continue;
+        }
+        char line[256];
+        while (fgets(line, sizeof(line), fp) != NULL) {
+            unsigned int port = 0, st = 0;
+            unsigned long tx_queue = 0, rx_queue = 0;
+            if (sscanf(line, " %*d: %*[0-9A-Fa-f]:%x %*[0-9A-Fa-f]:%*x %x %lx:%lx",
+                       &port, &st, &tx_queue, &rx_queue) != 4) {
+                continue;   // 表头
+            }
+            if (port == RTSP_PORT && st == 0x01) {
+                result = std::max(result, (uint64_t)tx_queue);
+            }
+        }
+        fclose(fp);
+    }
+    backlog_bytes = result;
+    return result;
+}
+
+// target_kbps 小于 0 时沿用当前目标码率，在串行化后读取，不会覆盖其间的拥塞调整
+void RateController::apply(int chn, int target_kbps, const char* reason) {
+    std::lock_guard<std::mutex> apply_lock(apply_mutex);
+    int full_fps, kbps, fps, gop, from_kbps;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Channel& c = channels[chn];
+        if (target_kbps < 0) {
+            target_kbps = c.target_kbps;
+        }
+        encoder_profile(target_kbps, c.max_kbps, c.full_fps, c.base_gop, &fps, &gop);
+        kbps = target_kbps;
+        if (c.idle) {
+            kbps = std::min(kbps, c.idle_kbps);
+            fps = std::min(fps, c.idle_fps);
+            gop = std::max(1, fps * c.idle_gop_s);
+        }
+        full_fps = c.full_fps;
+        from_kbps = c.kbps;
+    }
+    if (!set_encoder(chn, kbps, full_fps, fps, gop)) {
+        return;
+    }
+
+    uint64_t time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::lock_guard<std::mutex> lock(mutex);
+    Channel& c = channels[chn];
+    c.target_kbps = target_kbps;
+    c.kbps = kbps;
+    c.fps = fps;
+    c.gop = gop;
+    events.push_back({time_ms, chn, from_kbps, kbps, fps, gop, reason});
+    if (events.size() > kHistorySize) {
+        events.pop_front();
+    }
+    LOG_INFO("venc %d: %s, %d -> %d kbps, %d fps, gop %d\n", chn, reason, from_kbps, kbps, fps, gop);
+}
+
+void RateController::setActivity(int chn, bool activity) {
+    if (chn < 0 || chn >= kMaxChannels) {
+        return;
+    }
+    uint64_t now = latencyNowUs();
+    const char* reason = NULL;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Channel& c = channels[chn];
+        if (!c.active || !c.idle_enabled) {
+            return;
+        }
+        if (activity) {
+            c.last_activity_us = now;
+            if (c.idle) {
+                c.idle = false;
+                reason = "active";
+            }
+        } else if (!c.idle && now - c.last_activity_us >= c.idle_hold_us) {
+            c.idle = true;
+            reason = "idle";
+        }
+    }
+    if (reason == NULL) {
+        return;
+    }
+    apply(chn, -1, reason);
+    // 事件从关键帧开始，不等空闲档的长 GOP 结束
+    if (activity) {
+        RK_MPI_VENC_RequestIDR(chn, RK_TRUE);
+    }
+}
+
+void RateController::onFrameSent(int chn, uint32_t bytes, uint64_t tx_us) {
+    if (chn < 0 || chn >= kMaxChannels) {
+        return;
+    }
+    uint64_t now = latencyNowUs();
+    int new_kbps = 0;
+    const char* reason = NULL;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Channel& c = channels[chn];
+        if (!c.active) {
+            return;
+        }
+        c.window_bytes += bytes;
+        c.window_tx_us += tx_us;
+        uint64_t elapsed = now - c.window_start_us;
+        if (elapsed < kWindowUs) {
+            return;
+        }
+
+        c.sent_kbps = (double)c.window_bytes * 8 / 1000 / ((double)elapsed / 1e6);
+        c.tx_ratio = (double)c.window_tx_us / elapsed;
+        c.window_start_us = now;
+        c.window_bytes = 0;
+        c.window_tx_us = 0;
+        if (!c.adaptive) {
+            return;
+        }
+
+        // 积压按两路码流的目标码率换算成排空时间
+        uint64_t backlog = sampleBacklog(now);
+        int total_kbps = 0;
+        for (const auto& other : channels) {
+            total_kbps += other.active ? other.kbps : 0;
+        }
+        double drain_ms = total_kbps > 0 ? (double)backlog * 8 / total_kbps : 0;
+
+        bool congested = drain_ms > backlog_ms || c.tx_ratio > kTxBlockedRatio;
+        bool clear = drain_ms < backlog_ms / 4.0 && c.tx_ratio < kTxClearRatio;
+        c.congested_windows = congested ? c.congested_windows + 1 : 0;
+        c.clear_windows = clear ? c.clear_windows + 1 : 0;
+
+        if (c.congested_windows >= kCongestedWindows && c.target_kbps > c.min_kbps) {
+            new_kbps = std::max(c.min_kbps, (int)(c.target_kbps * kDecreaseFactor));
+            reason = "congestion";
+            c.congested_windows = 0;
+            c.last_decrease_us = now;
+        } else if (c.clear_windows >= recover_s && c.target_kbps < c.max_kbps &&
+                   now - c.last_decrease_us >= (uint64_t)recover_s * kWindowUs) {
+            new_kbps = std::min(c.max_kbps, c.target_kbps + (int)(c.max_kbps * kIncreaseStep));
+            reason = "recovery";
+            c.clear_windows = 0;
+        }
+
+        if (congested) {
+            c.state = "congested";
+        } else if (c.target_kbps < c.max_kbps) {
+            c.state = "recovering";
+        } else {
+            c.state = "stable";
+        }
+    }
+    if (reason != NULL) {
+        apply(chn, new_kbps, reason);
+    }
+}
+
+std::vector<RateController::Status> RateController::status() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Status> result;
+    for (int i = 0; i < kMaxChannels; i++) {
+        const Channel& c = channels[i];
+        result.push_back({i, c.active, c.max_kbps, c.min_kbps, c.target_kbps, c.kbps, c.fps, c.gop,
+                          c.idle, c.sent_kbps, c.tx_ratio, backlog_bytes, c.state});
+    }
+    return result;
+}
+
+std::vector<RateController::Event> RateController::history() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::vector<Event>(events.begin(), events.end());
+}
@@ -0,0 +1,115 @@
+#ifndef RATE_CONTROLLER_H
+#define RATE_CONTROLLER_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// RTSP 码流自适应码率
+//
+// rtsp 库不提供 RTCP 接收报告和发送队列，拥塞由两路信号判断：
+//   - 发送阻塞：rtsp_tx_stream 在一个统计窗口内占用的时间比例（TCP 发送缓冲区满时阻塞）；
+//   - 发送积压：/proc/net/tcp 中 RTSP 端口上已建立连接的发送队列字节数，换算成按当前码率的排空时间。
+// 每秒统计一次，带滞回：
+//   - 连续 2 个窗口拥塞才降码率（乘 0.7，不低于 min_percent）；
+//   - 连续 recover_s 个窗口畅通、且距上次降码率超过 recover_s 才升码率（每次加最大码率的 10%）；
+//   - 两个阈值之间保持不变。
+// 码率低于最大值的 1/2、1/4 时帧率降到 2/3、1/2，GOP 按帧率缩放并把时长加倍，减少 I 帧突发。
+// 通过 RK_MPI_VENC_SetChnAttr 修改，编码通道不重建。UDP 传输的客户端没有可观测的拥塞信号，不参与调整。
+// 关闭自适应时只在创建通道时按 max_rate / dst_frame_rate_num / gop 配置一次。
+//
+// 主码流另有空闲档：AI 连续 hold_s 秒没有检测到人员或车辆时切换到低帧率、长 GOP、低码率，
+// 检测到目标时立即切回并请求 IDR，事件录像从关键帧开始。空闲档只限制上限，仍受拥塞调整约束。
+class RateController {
+public:
+    static constexpr int kMaxChannels = 2;
+    static constexpr size_t kHistorySize = 32;
+
+    struct Status {
+        int chn;
+        bool active;
+        int max_kbps;
+        int min_kbps;
+        int target_kbps;        // 自适应目标码率
+        int kbps;               // 编码器当前码率（空闲时受空闲档限制）
+        int fps;
+        int gop;
+        bool idle;
+        double sent_kbps;       // 上一个窗口实际发送码率
+        double tx_ratio;        // 上一个窗口发送阻塞比例
+        uint64_t backlog_bytes; // 上一个窗口 RTSP 连接发送队列字节数（两路码流共用）
+        const char* state;      // "stable" / "congested" / "recovering" / "fixed"
+    };
+
+    struct Event {
+        uint64_t time_ms;       // 系统时间
+        int chn;
+        int from_kbps;
+        int to_kbps;
+        int fps;
+        int gop;
+        const char* reason;     // "init" / "congestion" / "recovery" / "idle" / "active"
+    };
+
+    static RateController& instance();
+
+    // 编码通道创建后调用，按配置设置初始码率、帧率和 GOP
+    void attach(int chn);
+    void detach(int chn);
+
+    // 每发送一帧调用一次，在发送线程中按窗口评估并调整
+    void onFrameSent(int chn, uint32_t bytes, uint64_t tx_us);
+
+    // 每个 AI 帧调用一次，activity 表示本帧是否检测到人员或车辆
+    void setActivity(int chn, bool activity);
+
+    std::vector<Status> status();
+    std::vector<Event> history();
+
+private:
+    struct Channel {
+        bool active = false;
+        bool adaptive = false;
+        int max_kbps = 0;
+        int min_kbps = 0;
+        int full_fps = 0;
+        int base_gop = 0;
+        int target_kbps = 0;
+        int kbps = 0;
+        int fps = 0;
+        int gop = 0;
+        uint64_t window_start_us = 0;
+        uint64_t window_bytes = 0;
+        uint64_t window_tx_us = 0;
+        int congested_windows = 0;
+        int clear_windows = 0;
+        uint64_t last_decrease_us = 0;
+        double sent_kbps = 0;
+        double tx_ratio = 0;
+        const char* state = "stable";
+        bool idle_enabled = false;
+        bool idle = false;
+        int idle_fps = 0;
+        int idle_gop_s = 0;
+        int idle_kbps = 0;
+        uint64_t idle_hold_us = 0;
+        uint64_t last_activity_us = 0;
+    };
+
+    RateController() = default;
+
+    uint64_t sampleBacklog(uint64_t now);
+    void apply(int chn, int target_kbps, const char* reason);
+
+    std::mutex mutex;
+    std::mutex apply_mutex;     // 串行化编码器设置，发送线程和 AI 线程都会调整
+    Channel channels[kMaxChannels];
+    std::deque<Event> events;
+    uint64_t backlog_bytes = 0;
+    uint64_t backlog_sampled_us = 0;
+    int backlog_ms = 300;
+    int recover_s = 10;
+};
+
+#endif // RATE_CONTROLLER_H
@@ -2,9 +2,27 @@
 #include <algorithm>
 #include <sstream>
 #include "param.h"
+#include "param_snapshot.h"
 #include "rknn/yolov5.h" // 确保在 roi_detector.h 前包含
 #include "roi_detector.h"
 #include "global.h"
+#include "latency_tracer.h"
+
+const std::string& RoiNameTable::roiName(int roi_id) const {
+    static const std::string empty;
+    if (roi_id < 0 || roi_id >= (int)roi_names.size()) {
+        return empty;
+    }
+    return roi_names[roi_id];
+}
+
+const std::string& RoiNameTable::groupName(int group_id) const {
+    static const std::string empty;
+    if (group_id < 0 || group_id >= (int)group_names.size()) {
+        return empty;
+    }
+    return group_names[group_id];
+}
 
 RoiDetector::RoiDetector() {
     // 创建目标跟踪器
@@ -79,8 +97,11 @@ cv::Scalar RoiDetector::generateColorByClassId(int class_id) {
 }
 
 bool RoiDetector::loadConfig() {
+    // 所有参数从同一份快照读取，避免加载过程中参数被修改导致配置前后不一致
+    ParamSnapshotPtr config = rk_param_snapshot();
+    
     // 从配置文件加载检测阈值
-    detection_threshold = rk_param_get_float("ai.roi:detection_threshold", 0.4f);
+    detection_threshold = config->get(param_key::ai_roi_detection_threshold);
     LOG_INFO("ROI detection threshold: %.2f", detection_threshold);
     
     // 清空现有配置
@@ -89,16 +110,22 @@ bool RoiDetector::loadConfig() {
     roi_to_group.clear();
     group_classes.clear();
     
+    // 名称表随配置一起重新生成，填充完成后再发布，旧告警事件仍持有旧表
+    auto names = std::make_shared<RoiNameTable>();
+    
     // 检查ROI功能是否启用
-    int roi_enable = rk_param_get_int("ai.roi:enable", 0);
+    bool roi_enable = config->get(param_key::ai_roi_enable);
     if (!roi_enable) {
         LOG_INFO("ROI detection is disabled");
+        std::atomic_store(&name_table, std::shared_ptr<const RoiNameTable>(names));
         return false;
     }
     
     // 读取有多少个ROI区域和组
-    int roi_count = rk_param_get_int("ai.roi:count", 0);
-    int group_count = rk_param_get_int("ai.roi:groups", 0);
+    int roi_count = config->get(param_key::ai_roi_count);
+    int group_count = config->get(param_key::ai_roi_groups);
+    names->roi_names.resize(std::max(roi_count, 0));
+    names->group_names.resize(std::max(group_count, 0));
     
     LOG_INFO("Loading %d ROI areas and %d ROI groups", roi_count, group_count);
     
@@ -109,7 +136,7 @@ bool RoiDetector::loadConfig() {
         
         // 读取ROI基础信息
         snprintf(param_name, sizeof(param_name), "ai.roi.%d:enabled", i);
-        roi.enabled = rk_param_get_int(param_name, 1) != 0;
+        roi.enabled = config->getInt(param_name, 1) != 0;
         
         if (!roi.enabled) {
             continue;
@@ -119,29 +146,30 @@ bool RoiDetector::loadConfig() {
         roi.group_id = -1;  // 默认不属于任何组
         
         snprintf(param_name, sizeof(param_name), "ai.roi.%d:name", i);
-        roi.name = rk_param_get_string(param_name, "");
+        roi.name = config->getString(param_name, "");
+        names->roi_names[i] = roi.name;
         
         snprintf(param_name, sizeof(param_name), "ai.roi.%d:x", i);
-        roi.x = rk_param_get_int(param_name, 0);
+        roi.x = config->getInt(param_name, 0);
         
         snprintf(param_name, sizeof(param_name), "ai.roi.%d:y", i);
-        roi.y = rk_param_get_int(param_name, 0);
+        roi.y = config->getInt(param_name, 0);
         
         snprintf(param_name, sizeof(param_name), "ai.roi.%d:width", i);
-        roi.width = rk_param_get_int(param_name, 100);
+        roi.width = config->getInt(param_name, 100);
         
         snprintf(param_name, sizeof(param_name), "ai.roi.%d:height", i);
-        roi.height = rk_param_get_int(param_name, 100);
+        roi.height = config->getInt(param_name, 100);
         
         snprintf(param_name, sizeof(param_name), "ai.roi.%d:stay_time", i);
-        roi.stay_time = rk_param_get_int(param_name, 0);
+        roi.stay_time = config->getInt(param_name, 0);
         
         snprintf(param_name, sizeof(param_name), "ai.roi.%d:cooldown_time", i);
-        roi.cooldown_time = rk_param_get_int(param_name, 10);
+        roi.cooldown_time = config->getInt(param_name, 10);
         
         // 读取ROI关注的目标类别（如果没有组，单个ROI可以有自己的类别）
         snprintf(param_name, sizeof(param_name), "ai.roi.%d:classes", i);
-        std::string classes_str = rk_param_get_string(param_name, "");
+        std::string classes_str = config->getString(param_name, "");
         
         if (!classes_str.empty()) {
             roi.classes = parseClassesString(classes_str);
@@ -172,17 +200,18 @@ bool RoiDetector::loadConfig() {
         // 读取组名称
         snprintf(param_name, sizeof(param_name), "ai.roi.group.%d:name", i);
         std::string default_name = "Group " + std::to_string(i);
-        group.name = rk_param_get_string(param_name, default_name.c_str());
+        group.name = config->getString(param_name, default_name.c_str());
+        names->group_names[i] = group.name;
         
         // 读取组关注的目标类别
         snprintf(param_name, sizeof(param_name), "ai.roi.group.%d:classes", i);
-        std::string classes_str = rk_param_get_string(param_name, "");
+        std::string classes_str = config->getString(param_name, "");
         
         group.classes = parseClassesString(classes_str);
         
         // 读取组包含的ROI ID列表
         snprintf(param_name, sizeof(param_name), "ai.roi.group.%d:rois", i);
-        std::string rois_str = rk_param_get_string(param_name, "");
+        std::string rois_str = config->getString(param_name, "");
         
         group.roi_ids = parseRoiIdsString(rois_str);
         
@@ -236,6 +265,8 @@ bool RoiDetector::loadConfig() {
                 classes_debug.c_str());
     }
     
+    std::atomic_store(&name_table, std::shared_ptr<const RoiNameTable>(names));
+    
     return !roi_areas.empty();
 }
 
@@ -248,6 +279,7 @@ bool RoiDetector::reloadConfig() {
     auto old_roi_groups = roi_groups;
     auto old_roi_to_group = roi_to_group;
     auto old_group_classes = group_classes;
+    auto old_name_table = std::atomic_load(&name_table);
     
     // 尝试加载新配置
     if (!loadConfig()) {
@@ -257,6 +289,7 @@ bool RoiDetector::reloadConfig() {
         roi_groups = old_roi_groups;
         roi_to_group = old_roi_to_group;
         group_classes = old_group_classes;
+        std::atomic_store(&name_table, old_name_table);
         return false;
     }
     
@@ -264,7 +297,7 @@ bool RoiDetector::reloadConfig() {
     return true;
 }
 
-void RoiDetector::processDetectionResult(const cv::Mat& frame, object_detect_result_list& od_results) {
+void RoiDetector::processDetectionResult(const VideoFrameRef& frame, object_detect_result_list& od_results) {
     // 转换检测结果为ByteTrack可接受的格式
     std::vector<Object> detections;
     
@@ -312,8 +345,9 @@ void RoiDetector::processDetectionResult(const cv::Mat& frame, object_detect_res
         detections.push_back(obj);
     }
     
-    // 使用ByteTrack进行目标跟踪
-    auto tracked_objects = tracker->update(detections);
+    // 使用ByteTrack进行目标跟踪，按帧的采集时间计算
+    last_pts_us = frame ? frame->pts_us : latencyNowUs();
+    auto tracked_objects = tracker->update(detections, last_pts_us);
     
     // 更新跟踪状态
     std::unordered_set<int> current_track_ids;
@@ -446,7 +480,7 @@ int RoiDetector::getRoiGroup(int roi_id) {
     return -1;
 }
 
-void RoiDetector::checkAlarm(const cv::Mat& frame, int track_id) {
+void RoiDetector::checkAlarm(const VideoFrameRef& frame, int track_id) {
     auto& obj = tracked_objects[track_id];
     
     // 获取当前ROI区域
@@ -504,32 +538,44 @@ void RoiDetector::checkAlarm(const cv::Mat& frame, int track_id) {
     obj.alarm_triggered = true;
     obj.last_alarm = now;
     
-    // 如果注册了告警回调，调用它
-    if (alarm_callback) {
-        AlarmInfo alarm;
-        alarm.roi_id = obj.roi_id;
-        alarm.roi_name = roi->name;
-        alarm.group_id = obj.group_id;
-        alarm.group_name = group ? group->name : "";
-        alarm.track_id = obj.track_id;
-        alarm.class_id = obj.class_id;
-        alarm.class_name = std::string(coco_cls_to_name(obj.class_id));
-        alarm.box = obj.box;
-        alarm.confidence = obj.confidence;
-        alarm.timestamp = std::chrono::system_clock::now();
+    // 如果注册了告警回调，生成一次告警事件并分发给所有回调
+    // 回调列表在锁内复制，回调在锁外执行，耗时的回调不阻塞注册
+    std::vector<AlarmCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(alarm_callbacks_mutex);
+        callbacks = alarm_callbacks;
+    }
+    if (!callbacks.empty()) {
+        auto alarm = std::make_shared<AlarmEvent>();
+        alarm->roi_id = obj.roi_id;
+        alarm->group_id = obj.group_id;
+        alarm->track_id = obj.track_id;
+        alarm->class_id = obj.class_id;
+        alarm->box = obj.box;
+        alarm->confidence = obj.confidence;
+        alarm->timestamp = std::chrono::system_clock::now();
+        alarm->names = std::atomic_load(&name_table);
         
         // 裁剪当前帧作为告警截图
+        int frame_width = frame ? frame->width : 0;
+        int frame_height = frame ? frame->height : 0;
         cv::Rect crop_rect = obj.box;
         // 扩大截图范围，包括更多上下文
         crop_rect.x = std::max(0, crop_rect.x - crop_rect.width / 4);
         crop_rect.y = std::max(0, crop_rect.y - crop_rect.height / 4);
-        crop_rect.width = std::min(frame.cols - crop_rect.x, crop_rect.width * 3 / 2);
-        crop_rect.height = std::min(frame.rows - crop_rect.y, crop_rect.height * 3 / 2);
+        crop_rect.width = std::min(frame_width - crop_rect.x, crop_rect.width * 3 / 2);
+        crop_rect.height = std::min(frame_height - crop_rect.y, crop_rect.height * 3 / 2);
         
-        alarm.snapshot = frame(crop_rect).clone();
+        // 截图直接从共享的帧缓冲区中裁剪，只在此处编码一次，所有消费者共享同一份JPEG数据
+        if (crop_rect.width > 0 && crop_rect.height > 0) {
+            cv::imencode(".jpg", frame->mat()(crop_rect), alarm->jpeg);
+        }
         
         // 调用告警回调
-        alarm_callback(alarm);
+        AlarmEventPtr event = std::move(alarm);
+        for (const auto& callback : callbacks) {
+            callback(event);
+        }
         
         if (group) {
             LOG_INFO("Alarm triggered: Group %d (%s), ROI %d (%s), Class %s, Track ID %d", 
@@ -727,18 +773,17 @@ std::vector<int> RoiDetector::getDetectionClasses() {
 }
 
 void RoiDetector::registerAlarmCallback(AlarmCallback callback) {
-    alarm_callback = callback;
+    std::lock_guard<std::mutex> lock(alarm_callbacks_mutex);
+    alarm_callbacks.push_back(std::move(callback));
 }
 
 void RoiDetector::cleanExpiredObjects() {
-    auto now = std::chrono::steady_clock::now();
-    
     for (auto it = tracked_objects.begin(); it != tracked_objects.end(); ) {
         auto& obj = it->second;
-        auto last_seen = tracker->getTrackLastSeen(obj.track_id);
+        uint64_t last_seen = tracker->getTrackLastSeen(obj.track_id);
         
-        // 将过期时间从5秒减少到1秒，更快地移除不可见目标
-        if (last_seen && std::chrono::duration_cast<std::chrono::seconds>(now - *last_seen).count() > 1) {
+        // 将过期时间从5秒减少到1秒，更快地移除不可见目标（按帧的采集时间）
+        if (last_seen != 0 && (int64_t)(last_pts_us - last_seen) > 1000000) {
             it = tracked_objects.erase(it);
         } else {
             ++it;
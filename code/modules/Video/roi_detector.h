@@ -7,8 +7,12 @@
 #include <unordered_set>
 #include <string>
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <functional>
 #include <opencv2/opencv.hpp>
 #include "postprocess.h"
+#include "frame_pool.h"
 #include "tracker/BYTETracker.h"
 
 // ROI区域定义
@@ -47,21 +51,50 @@ struct RoiObject {
     bool alarm_triggered;   // 是否已触发告警
 };
 
-// 告警信息
-struct AlarmInfo {
+// 编译后的ROI名称表（只读快照，每次加载配置生成一份）
+// 告警事件只保存ID，名称通过该表解析，配置热加载后旧事件仍引用旧表
+struct RoiNameTable {
+    std::vector<std::string> roi_names;     // 以ROI ID为下标
+    std::vector<std::string> group_names;   // 以组ID为下标
+
+    const std::string& roiName(int roi_id) const;
+    const std::string& groupName(int group_id) const;
+};
+
+// 告警事件（不可变，创建后通过引用计数在各个消费者之间共享）
+struct AlarmEvent {
     int roi_id;                 // 触发告警的ROI ID
-    std::string roi_name;       // ROI名称
     int group_id;               // 触发告警的组ID，-1表示不属于任何组
-    std::string group_name;     // 组名称，如果有
     int track_id;               // 触发告警的目标ID
     int class_id;               // 目标类别
-    std::string class_name;     // 目标类别名称
     cv::Rect box;               // 目标位置
     float confidence;           // 置信度
-    cv::Mat snapshot;           // 告警截图
     std::chrono::system_clock::time_point timestamp; // 告警时间
+    std::vector<uchar> jpeg;    // 告警截图（JPEG编码，只编码一次）
+    std::shared_ptr<const RoiNameTable> names;       // 生成告警时的名称表
+
+    const std::string& roiName() const { return names->roiName(roi_id); }
+    const std::string& groupName() const { return names->groupName(group_id); }
+    const char* className() const { return coco_cls_to_name(class_id); }
 };
 
+using AlarmEventPtr = std::shared_ptr<const AlarmEvent>;
+
+// 单帧检测结果摘要（坐标已映射到主码流分辨率）
+struct DetectionSummary {
+    struct Object {
+        int class_id;
+        float confidence;
+        cv::Rect box;
+    };
+    uint64_t frame_seq;         // 推理帧序号
+    int width, height;          // 坐标所在的画面尺寸
+    std::chrono::system_clock::time_point timestamp;
+    std::vector<Object> objects;
+};
+
+using DetectionSummaryPtr = std::shared_ptr<const DetectionSummary>;
+
 class RoiDetector {
 public:
     RoiDetector();
@@ -73,8 +106,8 @@ public:
     // 重新加载配置（热加载）
     bool reloadConfig();
     
-    // 处理检测结果
-    void processDetectionResult(const cv::Mat& frame, object_detect_result_list& od_results);
+    // 处理检测结果，frame 为对应的视频帧，只在触发告警时读取截图区域
+    void processDetectionResult(const VideoFrameRef& frame, object_detect_result_list& od_results);
     
     // 判断目标是否在ROI内
     bool isObjectInRoi(const cv::Rect& obj_box, const RoiArea& roi);
@@ -97,8 +130,11 @@ public:
     // 获取ROI区域列表
     const std::vector<RoiArea>& getRoiAreas() const { return roi_areas; }
     
-    // 注册告警回调函数
-    using AlarmCallback = std::function<void(const AlarmInfo&)>;
+    // 获取当前配置对应的名称表
+    std::shared_ptr<const RoiNameTable> getNameTable() const { return std::atomic_load(&name_table); }
+    
+    // 注册告警回调函数（可注册多个，所有回调共享同一个告警事件）
+    using AlarmCallback = std::function<void(const AlarmEventPtr&)>;
     void registerAlarmCallback(AlarmCallback callback);
 
 private:
@@ -123,11 +159,18 @@ private:
     // 目标状态映射表 (track_id -> object)
     std::unordered_map<int, RoiObject> tracked_objects;
     
-    // 告警回调函数
-    AlarmCallback alarm_callback;
+    // 最近一次处理的帧的采集时间（微秒），用于清理过期目标
+    uint64_t last_pts_us = 0;
+    
+    // 当前配置的名称表
+    std::shared_ptr<const RoiNameTable> name_table;
+    
+    // 告警回调函数列表
+    std::vector<AlarmCallback> alarm_callbacks;
+    std::mutex alarm_callbacks_mutex;
     
     // 检查并触发告警
-    void checkAlarm(const cv::Mat& frame, int track_id);
+    void checkAlarm(const VideoFrameRef& frame, int track_id);
     
     // 处理目标状态
     void updateObjectStatus(const cv::Mat& frame);
@@ -0,0 +1,150 @@
+#include "roi_encoder.h"
+#include "param_snapshot.h"
+#include "log.h"
+#include <algorithm>
+#include <string.h>
+
+static constexpr int kAlign = 16;   // H.264 宏块大小
+
+RoiEncoder::~RoiEncoder() {
+    deinit();
+}
+
+bool RoiEncoder::init(int venc_chn) {
+    ParamSnapshotPtr config = rk_param_snapshot();
+    if (!config->get(param_key::video_roi_qp_enable)) {
+        return false;
+    }
+    this->venc_chn = venc_chn;
+    width = config->get(param_key::video0_width);
+    height = config->get(param_key::video0_height);
+    subject_qp = config->get(param_key::video_roi_qp_subject);
+    background_qp = config->get(param_key::video_roi_qp_background);
+    update_frames = config->get(param_key::video_roi_qp_update_frames);
+    margin = config->get(param_key::video_roi_qp_margin);
+    hold_frames = config->get(param_key::video_roi_qp_hold_frames);
+
+    // 背景 ROI 覆盖整幅画面，之后不再修改
+    if (background_qp != 0 && !set(0, cv::Rect(0, 0, width, height), background_qp, true)) {
+        return false;
+    }
+    for (int i = 1; i < kMaxRegions; i++) {
+        set(i, cv::Rect(0, 0, kAlign, kAlign), subject_qp, false);
+    }
+    frame = 0;
+    last_update_frame = 0;
+    held.clear();
+    applied.clear();
+    active = true;
+    LOG_INFO("venc %d ROI: subject qp %d, background qp %d\n", venc_chn, subject_qp, background_qp);
+    return true;
+}
+
+void RoiEncoder::deinit() {
+    if (!active) {
+        return;
+    }
+    for (int i = 0; i < kMaxRegions; i++) {
+        set(i, cv::Rect(0, 0, kAlign, kAlign), 0, false);
+    }
+    active = false;
+}
+
+bool RoiEncoder::set(int index, const cv::Rect& rect, int qp, bool enable) {
+    VENC_ROI_ATTR_S stRoiAttr;
+    memset(&stRoiAttr, 0, sizeof(stRoiAttr));
+    stRoiAttr.u32Index = index;
+    stRoiAttr.bEnable = enable ? RK_TRUE : RK_FALSE;
+    stRoiAttr.bAbsQp = RK_FALSE;
+    stRoiAttr.s32Qp = qp;
+    stRoiAttr.bIntra = RK_FALSE;
+    stRoiAttr.stRect.s32X = rect.x;
+    stRoiAttr.stRect.s32Y = rect.y;
+    stRoiAttr.stRect.u32Width = rect.width;
+    stRoiAttr.stRect.u32Height = rect.height;
+    updates++;
+    int ret = RK_MPI_VENC_SetRoiAttr(venc_chn, &stRoiAttr);
+    if (ret != RK_SUCCESS) {
+        LOG_ERROR("RK_MPI_VENC_SetRoiAttr (%d, %d) failed with %#x\n", venc_chn, index, ret);
+        return false;
+    }
+    return true;
+}
+
+// 外扩后向外对齐到宏块
+cv::Rect RoiEncoder::pad(const cv::Rect& rect, int amount) const {
+    int x0 = std::max(0, rect.x - amount) / kAlign * kAlign;
+    int y0 = std::max(0, rect.y - amount) / kAlign * kAlign;
+    int x1 = std::min(width, (rect.x + rect.width + amount + kAlign - 1) / kAlign * kAlign);
+    int y1 = std::min(height, (rect.y + rect.height + amount + kAlign - 1) / kAlign * kAlign);
+    return cv::Rect(x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0));
+}
+
+void RoiEncoder::update(const std::vector<Object>& subjects, uint64_t pts_us) {
+    if (!active) {
+        return;
+    }
+    frame++;
+
+    // 跟踪结果与输入一一对应，按跟踪 ID 更新保持列表
+    if (!subjects.empty()) {
+        std::vector<Object> tracked = tracker.update(subjects, pts_us);
+        for (const auto& object : tracked) {
+            auto it = std::find_if(held.begin(), held.end(), [&](const Held& h) { return h.track_id == object.track_id; });
+            if (it == held.end()) {
+                held.push_back({object.track_id, object.rect, frame});
+            } else {
+                it->rect = object.rect;
+                it->last_frame = frame;
+            }
+        }
+    }
+    held.erase(std::remove_if(held.begin(), held.end(),
+                              [&](const Held& h) { return frame - h.last_frame > (uint64_t)hold_frames; }),
+               held.end());
+
+    if (frame - last_update_frame < (uint64_t)update_frames) {
+        return;
+    }
+
+    // 按跟踪先后顺序占用序号，多出的目标合并到最后一个
+    std::vector<cv::Rect> targets;
+    for (const auto& h : held) {
+        cv::Rect rect = pad(h.rect, margin);
+        if (rect.area() > 0) {
+            targets.push_back(rect);
+        }
+    }
+    if ((int)targets.size() > kMaxRegions - 1) {
+        for (size_t k = kMaxRegions - 1; k < targets.size(); k++) {
+            targets[kMaxRegions - 2] |= targets[k];
+        }
+        targets.resize(kMaxRegions - 1);
+    }
+
+    // 滞回：数量不变、每个目标仍在对应 ROI 内、且 ROI 不超出目标再外扩 2 * margin 的范围时保持
+    bool keep = targets.size() == applied.size();
+    for (size_t k = 0; keep && k < targets.size(); k++) {
+        cv::Rect loose = pad(targets[k], 2 * margin);
+        keep = (targets[k] & applied[k]) == targets[k] && (applied[k] & loose) == applied[k];
+    }
+    if (keep) {
+        return;
+    }
+
+    std::vector<cv::Rect> next;
+    for (const auto& target : targets) {
+        next.push_back(pad(target, margin));
+    }
+    for (int k = 0; k < kMaxRegions - 1; k++) {
+        bool was = k < (int)applied.size();
+        bool now = k < (int)next.size();
+        if (now && (!was || applied[k] != next[k])) {
+            set(k + 1, next[k], subject_qp, true);
+        } else if (!now && was) {
+            set(k + 1, applied[k], subject_qp, false);
+        }
+    }
+    applied.swap(next);
+    last_update_frame = frame;
+}
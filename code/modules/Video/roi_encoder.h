@@ -0,0 +1,68 @@
+#ifndef ROI_ENCODER_H
+#define ROI_ENCODER_H
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "sample_comm.h"
+#include "tracker/BYTETracker.h"
+
+// 按检测结果设置主码流编码 ROI
+//
+// 人员和车辆所在区域使用负的相对 QP，背景使用正的相对 QP，码率不变时把码字集中到目标上：
+//   - ROI 0 覆盖整幅画面，设置背景 QP；ROI 1-7 为目标区域，序号大的 ROI 在重叠处优先；
+//   - 目标按跟踪 ID 保持，漏检 hold_frames 帧后才移除；
+//   - 每 update_frames 帧最多更新一次。ROI 设置为目标框外扩 2 * margin，
+//     之后目标框外扩 margin 仍在 ROI 内、且 ROI 不超出目标框外扩 3 * margin 时不更新，
+//     目标移动和检测框抖动在 margin 以内时 ROI 不变；
+//   - 只对内容变化的序号调用 RK_MPI_VENC_SetRoiAttr。
+// 目标多于 7 个时，后出现的目标合并到最后一个 ROI。
+// 只在 AI 线程中使用，不加锁。
+class RoiEncoder {
+public:
+    static constexpr int kMaxRegions = 8;       // VENC ROI 序号范围 [0,7]
+
+    RoiEncoder() = default;
+    ~RoiEncoder();
+
+    // 读取 video.roi_qp 配置，设置背景 ROI，未使能时返回 false
+    bool init(int venc_chn);
+    void deinit();
+
+    bool enabled() const { return active; }
+
+    // 传入本帧目标框（主码流坐标）和帧的采集时间（微秒）
+    void update(const std::vector<Object>& subjects, uint64_t pts_us);
+
+    // 累计的 SetRoiAttr 调用次数
+    uint64_t updateCount() const { return updates; }
+
+private:
+    struct Held {
+        int track_id;
+        cv::Rect rect;
+        uint64_t last_frame;
+    };
+
+    bool set(int index, const cv::Rect& rect, int qp, bool enable);
+    cv::Rect pad(const cv::Rect& rect, int amount) const;
+
+    bool active = false;
+    int venc_chn = 0;
+    int width = 0;
+    int height = 0;
+    int subject_qp = -6;
+    int background_qp = 3;
+    int update_frames = 5;
+    int margin = 32;
+    int hold_frames = 10;
+
+    uint64_t frame = 0;
+    uint64_t last_update_frame = 0;
+    uint64_t updates = 0;
+    BYTETracker tracker;
+    std::vector<Held> held;
+    std::vector<cv::Rect> applied;      // 当前设置的目标 ROI，对应序号 1 起
+};
+
+#endif // ROI_ENCODER_H
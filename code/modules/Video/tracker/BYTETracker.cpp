@@ -7,25 +7,36 @@
 // 静态成员初始化
 int STrack::next_id = 1;
 
-STrack::STrack(const cv::Rect& rect, float score, int class_id) :
+STrack::STrack(const cv::Rect& rect, float score, int class_id, uint64_t pts_us) :
     _track_id(next_id++),
     _rect(rect),
     _score(score),
     _class_id(class_id),
-    _state(TrackState::New) {
-        _last_seen = std::make_unique<std::chrono::steady_clock::time_point>(std::chrono::steady_clock::now());
-    }
+    _state(TrackState::New),
+    _vx(0),
+    _vy(0),
+    _hits(1),
+    _last_pts_us(pts_us) {}
 
-void STrack::updateTrack(const cv::Rect& rect, float score, int class_id) {
+void STrack::updateTrack(const cv::Rect& rect, float score, int class_id, uint64_t pts_us) {
+    // 中心点位移除以两帧的采集间隔，指数平滑后作为速度
+    float dt = pts_us > _last_pts_us ? (pts_us - _last_pts_us) / 1e6f : 0.0f;
+    if (dt > 0.001f) {
+        float vx = ((rect.x + rect.width * 0.5f) - (_rect.x + _rect.width * 0.5f)) / dt;
+        float vy = ((rect.y + rect.height * 0.5f) - (_rect.y + _rect.height * 0.5f)) / dt;
+        const float alpha = _hits > 1 ? 0.5f : 1.0f;
+        _vx += alpha * (vx - _vx);
+        _vy += alpha * (vy - _vy);
+        _hits++;
+    }
     _rect = rect;
     _score = score;
     _class_id = class_id;
-    _last_seen = std::make_unique<std::chrono::steady_clock::time_point>(std::chrono::steady_clock::now());
+    _last_pts_us = pts_us;
 }
 
 void STrack::markTracked() {
     _state = TrackState::Tracked;
-    _last_seen = std::make_unique<std::chrono::steady_clock::time_point>(std::chrono::steady_clock::now());
 }
 
 void STrack::markLost() {
@@ -38,23 +49,19 @@ void STrack::markRemoved() {
 
 BYTETracker::BYTETracker(const BYTETrackerParams& params) : params(params) {}
 
-std::vector<Object> BYTETracker::update(const std::vector<Object>& objects) {
+std::vector<Object> BYTETracker::update(const std::vector<Object>& objects, uint64_t pts_us) {
     // 创建结果容器
     std::vector<Object> results;
     
-    // 创建当前检测的ID集合
+    // 本帧已分配的跟踪 ID
     std::unordered_set<int> current_ids;
     
-    // 清理过期的跟踪目标 - 这里大幅减少保留时间到0.5秒
-    auto now = std::chrono::steady_clock::now();
+    // 清理过期的跟踪目标 - 这里大幅减少保留时间到0.5秒（按采集时间，时间回退时同样清理）
     tracked_stracks.erase(
         std::remove_if(tracked_stracks.begin(), tracked_stracks.end(), 
-            [&now](const std::shared_ptr<STrack>& track) {
-                auto last_seen = track->getLastSeen();
-                if (!last_seen) return true;
-                
-                auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - *last_seen).count();
-                return duration > 500; // 只保留0.5秒内看到的目标
+            [pts_us](const std::shared_ptr<STrack>& track) {
+                int64_t elapsed = (int64_t)(pts_us - track->getLastSeen());
+                return elapsed > 500000 || elapsed < 0; // 只保留0.5秒内看到的目标
             }
         ), 
         tracked_stracks.end()
@@ -72,6 +79,10 @@ std::vector<Object> BYTETracker::update(const std::vector<Object>& objects) {
             if (track->getClassId() != obj.label) {
                 continue;
             }
+            // 本帧已被其他检测占用的跟踪目标不再匹配，同一帧内跟踪 ID 不重复
+            if (current_ids.count(track->trackId()) > 0) {
+                continue;
+            }
             
             // 计算IoU
             cv::Rect rect1 = track->getRect();
@@ -105,7 +116,7 @@ std::vector<Object> BYTETracker::update(const std::vector<Object>& objects) {
         // 如果找到匹配，则更新跟踪目标
         if (matched) {
             // 立即更新位置，不使用任何平滑或预测
-            best_match->updateTrack(obj.rect, obj.prob, obj.label);
+            best_match->updateTrack(obj.rect, obj.prob, obj.label, pts_us);
             best_match->markTracked();
             
             Object result;
@@ -113,13 +124,15 @@ std::vector<Object> BYTETracker::update(const std::vector<Object>& objects) {
             result.prob = best_match->getScore();
             result.label = best_match->getClassId();
             result.track_id = best_match->trackId();
+            result.vx = best_match->velocityX();
+            result.vy = best_match->velocityY();
             
             results.push_back(result);
             current_ids.insert(best_match->trackId());
         } 
         // 如果没有找到匹配，则创建新的跟踪目标
         else {
-            auto new_track = std::make_shared<STrack>(obj.rect, obj.prob, obj.label);
+            auto new_track = std::make_shared<STrack>(obj.rect, obj.prob, obj.label, pts_us);
             new_track->markTracked();
             tracked_stracks.push_back(new_track);
             
@@ -137,7 +150,7 @@ std::vector<Object> BYTETracker::update(const std::vector<Object>& objects) {
     return results;
 }
 
-std::chrono::steady_clock::time_point* BYTETracker::getTrackLastSeen(int track_id) {
+uint64_t BYTETracker::getTrackLastSeen(int track_id) {
     // 在跟踪中的目标中搜索
     for (const auto& track : tracked_stracks) {
         if (track->trackId() == track_id) {
@@ -145,5 +158,5 @@ std::chrono::steady_clock::time_point* BYTETracker::getTrackLastSeen(int track_i
         }
     }
     
-    return nullptr;
+    return 0;
 }
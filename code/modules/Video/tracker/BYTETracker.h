@@ -5,13 +5,15 @@
 #include <memory>
 #include <map>
 #include <opencv2/opencv.hpp>
-#include <chrono>
+#include <cstdint>
 
 struct Object {
     cv::Rect rect;
     int label;
     float prob;
     int track_id;
+    float vx = 0;       // 目标中心速度（像素/秒），由跟踪器估计
+    float vy = 0;
 };
 
 struct BYTETrackerParams {
@@ -35,11 +37,11 @@ enum TrackState { New = 0, Tracked, Lost, Removed };
 // 表示单个跟踪目标的类
 class STrack {
 public:
-    STrack(const cv::Rect& rect, float score, int class_id);
+    STrack(const cv::Rect& rect, float score, int class_id, uint64_t pts_us);
     ~STrack() = default;
     
-    // 更新跟踪目标
-    void updateTrack(const cv::Rect& rect, float score, int class_id);
+    // 更新跟踪目标，pts_us 为检测所用帧的采集时间
+    void updateTrack(const cv::Rect& rect, float score, int class_id, uint64_t pts_us);
     
     // 获取目标状态
     TrackState state() const { return _state; }
@@ -47,9 +49,11 @@ public:
     cv::Rect getRect() const { return _rect; }
     float getScore() const { return _score; }
     int getClassId() const { return _class_id; }
+    float velocityX() const { return _vx; }
+    float velocityY() const { return _vy; }
     
-    // 使用指针代替std::optional
-    std::chrono::steady_clock::time_point* getLastSeen() const { return _last_seen.get(); }
+    // 最近一次检测到的帧的采集时间（微秒）
+    uint64_t getLastSeen() const { return _last_pts_us; }
     
     // 标记为"已跟踪"
     void markTracked();
@@ -65,9 +69,10 @@ private:
     float _score;
     int _class_id;
     TrackState _state;
-    
-    // 使用unique_ptr代替std::optional
-    std::unique_ptr<std::chrono::steady_clock::time_point> _last_seen;
+    float _vx;
+    float _vy;
+    int _hits;
+    uint64_t _last_pts_us;
 };
 
 // ByteTrack跟踪器类
@@ -76,11 +81,13 @@ public:
     BYTETracker(const BYTETrackerParams& params = BYTETrackerParams());
     ~BYTETracker() = default;
     
-    // 更新跟踪器，传入检测结果，返回跟踪结果
-    std::vector<Object> update(const std::vector<Object>& objects);
+    // 更新跟踪器，传入检测结果和检测所用帧的采集时间（微秒），返回跟踪结果
+    // 速度和目标保留时间都按采集时间计算，与推理耗时和调用时刻无关
+    // 每个跟踪目标在一帧中最多匹配一个检测，结果中的跟踪 ID 互不相同
+    std::vector<Object> update(const std::vector<Object>& objects, uint64_t pts_us);
     
-    // 使用指针代替std::optional
-    std::chrono::steady_clock::time_point* getTrackLastSeen(int track_id);
+    // 目标最近一次检测到的帧的采集时间，目标不存在时返回 0
+    uint64_t getTrackLastSeen(int track_id);
     
 private:
     BYTETrackerParams params;
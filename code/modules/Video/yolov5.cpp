@@ -196,23 +196,37 @@ int release_yolov5_model(rknn_app_context_t *app_ctx)
 
 int inference_yolov5_model(rknn_app_context_t *app_ctx, object_detect_result_list *od_results)
 {
-    int ret;
-    const float nms_threshold = NMS_THRESH;      // 默认的NMS阈值
-    const float box_conf_threshold = BOX_THRESH; // 默认的置信度阈值
-
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    int ret = run_yolov5_model(app_ctx);
     if (ret < 0)
     {
-        printf("rknn_run fail! ret=%d\n", ret);
         return -1;
     }
 
     // Post Process
-    post_process(app_ctx, app_ctx->output_mems, box_conf_threshold, nms_threshold, od_results);
+    post_process_yolov5_model(app_ctx, od_results);
 
     return ret;
 }
 
+int run_yolov5_model(rknn_app_context_t *app_ctx)
+{
+    int ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    if (ret < 0)
+    {
+        printf("rknn_run fail! ret=%d\n", ret);
+        return -1;
+    }
+    return ret;
+}
+
+int post_process_yolov5_model(rknn_app_context_t *app_ctx, object_detect_result_list *od_results)
+{
+    const float nms_threshold = NMS_THRESH;      // 默认的NMS阈值
+    const float box_conf_threshold = BOX_THRESH; // 默认的置信度阈值
+
+    return post_process(app_ctx, app_ctx->output_mems, box_conf_threshold, nms_threshold, od_results);
+}
+
 cv::Mat letterbox(cv::Mat input, int video_width, int video_height)
 {
     float scaleX = (float)MODEL_WIDTH / (float)video_width;
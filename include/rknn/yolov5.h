@@ -65,6 +65,10 @@ int release_yolov5_model(rknn_app_context_t* app_ctx);
 
 int inference_yolov5_model(rknn_app_context_t* app_ctx,  object_detect_result_list* od_results);
 
+// inference_yolov5_model 的两个步骤，便于分别计时
+int run_yolov5_model(rknn_app_context_t* app_ctx);
+int post_process_yolov5_model(rknn_app_context_t* app_ctx, object_detect_result_list* od_results);
+
 cv::Mat letterbox(cv::Mat input, int video_width, int video_height);
 
 void mapCoordinates(int *x, int *y);
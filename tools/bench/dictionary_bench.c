@@ -0,0 +1,99 @@
+/*
+ * iniparser 字典查找基准测试
+ *
+ * 对比线性扫描的原字典与开放寻址哈希索引的字典，键数 250 / 2000 / 20000，
+ * 键名格式与 ROI 配置相同（"ai.roi.N:field_M"）。
+ * 分别统计建表时间、命中查找和未命中查找的平均耗时。
+ *
+ * 原字典取自引入哈希索引之前的提交，函数加 old_ 前缀后与当前字典链接到同一程序。
+ * 主机编译运行（在仓库根目录）：
+ *   mkdir -p /tmp/dict_old
+ *   git show e8c9e47~1:code/common/param/dictionary.c > /tmp/dict_old/dictionary.c
+ *   git show e8c9e47~1:code/common/param/dictionary.h > /tmp/dict_old/dictionary.h
+ *   gcc -O2 -c -I/tmp/dict_old /tmp/dict_old/dictionary.c -o /tmp/dict_old/dictionary.o \
+ *       -Ddictionary_hash=old_dictionary_hash -Ddictionary_new=old_dictionary_new \
+ *       -Ddictionary_del=old_dictionary_del -Ddictionary_get=old_dictionary_get \
+ *       -Ddictionary_set=old_dictionary_set -Ddictionary_unset=old_dictionary_unset \
+ *       -Ddictionary_dump=old_dictionary_dump
+ *   gcc -O2 -Icode/common/param tools/bench/dictionary_bench.c code/common/param/dictionary.c \
+ *       /tmp/dict_old/dictionary.o -o dictionary_bench
+ *   ./dictionary_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dictionary.h"
+
+#define MAX_KEYS 20000
+#define KEY_LEN 32
+
+dictionary *old_dictionary_new(size_t size);
+void old_dictionary_del(dictionary *d);
+const char *old_dictionary_get(const dictionary *d, const char *key, const char *def);
+int old_dictionary_set(dictionary *d, const char *key, const char *val);
+
+typedef struct {
+	const char *name;
+	dictionary *(*create)(size_t size);
+	void (*destroy)(dictionary *d);
+	const char *(*get)(const dictionary *d, const char *key, const char *def);
+	int (*set)(dictionary *d, const char *key, const char *val);
+} dict_impl;
+
+static char keys[MAX_KEYS][KEY_LEN];
+static int order[200000];
+static volatile size_t sink;
+
+static double now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void run(const dict_impl *impl, int n, int report) {
+	int i;
+	for (i = 0; i < n; i++)
+		snprintf(keys[i], KEY_LEN, "ai.roi.%d:field_%d", i / 10, i % 10);
+
+	double t0 = now_ns();
+	dictionary *d = impl->create(0);
+	for (i = 0; i < n; i++)
+		impl->set(d, keys[i], "123");
+	double t1 = now_ns();
+
+	/* 线性扫描在大字典上很慢，查找次数随规模减少 */
+	int lookups = n >= MAX_KEYS ? MAX_KEYS : 200000;
+	for (i = 0; i < lookups; i++)
+		order[i] = rand() % n;
+
+	double t2 = now_ns();
+	for (i = 0; i < lookups; i++)
+		sink += (size_t)impl->get(d, keys[order[i]], NULL);
+	double t3 = now_ns();
+	for (i = 0; i < lookups; i++)
+		sink += (size_t)impl->get(d, "osd.9:missing_key", NULL);
+	double t4 = now_ns();
+
+	if (report)
+		printf("%-4s keys %5d  build %9.1f us  get hit %8.1f ns  get miss %8.1f ns\n", impl->name, n,
+		       (t1 - t0) / 1e3, (t3 - t2) / lookups, (t4 - t3) / lookups);
+	impl->destroy(d);
+}
+
+int main(void) {
+	const dict_impl old_impl = {"old", old_dictionary_new, old_dictionary_del, old_dictionary_get, old_dictionary_set};
+	const dict_impl new_impl = {"new", dictionary_new, dictionary_del, dictionary_get, dictionary_set};
+	const int sizes[] = {250, 2000, 20000};
+	size_t i;
+
+	/* 预热 */
+	run(&old_impl, 2000, 0);
+	run(&new_impl, 2000, 0);
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		run(&old_impl, sizes[i], 1);
+		run(&new_impl, sizes[i], 1);
+	}
+	return 0;
+}
@@ -0,0 +1,162 @@
+// ROI 配置 JSON 解析与序列化基准测试
+//
+// 对比 ApiServer 原先的 find/substr 逐字段提取、stringstream 拼接，
+// 与 code/common/utils/json.h 中的 JsonDocument / JsonWriter。
+// 请求体为 64 个 ROI 的配置（约 10KB），每个 ROI 带 classes 数组。
+// 原实现遇到 classes 数组会在第一个 ']' 处截断，为公平起见，旧实现按 rfind(']') 取完整数组，两者处理相同的文本。
+//
+// 主机编译运行（在仓库根目录）：
+//   g++ -std=gnu++14 -O2 -Icode/common/utils tools/bench/json_bench.cpp code/common/utils/json.cpp -o json_bench
+//   ./json_bench
+
+#include "json.h"
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+static const int kRoiCount = 64;
+static const int kIterations = 20000;
+
+static std::string body;
+static volatile size_t sink;
+
+// 原 handleUpdateRoiConfig 的提取方式
+static void parseOld() {
+    std::string roi_areas_str = body.substr(body.find("\"roi_areas\""));
+    size_t start_pos = roi_areas_str.find('[');
+    size_t end_pos = roi_areas_str.rfind(']');
+    std::string areas_array = roi_areas_str.substr(start_pos + 1, end_pos - start_pos - 1);
+
+    auto parseValue = [](const std::string& key, const std::string& obj, bool is_string) -> std::string {
+        std::string search = "\"" + key + "\":";
+        size_t key_pos = obj.find(search);
+        if (key_pos == std::string::npos) return "";
+        size_t value_start = key_pos + search.length();
+        while (value_start < obj.length() && std::isspace(obj[value_start])) value_start++;
+        if (is_string) {
+            if (obj[value_start] != '"') return "";
+            size_t value_end = obj.find('"', value_start + 1);
+            if (value_end == std::string::npos) return "";
+            return obj.substr(value_start + 1, value_end - value_start - 1);
+        }
+        size_t value_end = obj.find_first_of(",}", value_start);
+        if (value_end == std::string::npos) return "";
+        return obj.substr(value_start, value_end - value_start);
+    };
+
+    static const char* keys[] = {"id", "x", "y", "width", "height", "stay_time", "cooldown_time", "enabled", "group_id"};
+    size_t pos = 0, obj_start, obj_end, n = 0;
+    while ((obj_start = areas_array.find('{', pos)) != std::string::npos) {
+        obj_end = areas_array.find('}', obj_start);
+        if (obj_end == std::string::npos) break;
+        std::string roi_obj = areas_array.substr(obj_start, obj_end - obj_start + 1);
+        n += parseValue("name", roi_obj, true).size();
+        for (const char* key : keys) {
+            n += parseValue(key, roi_obj, false).size();
+        }
+        size_t classes_start = roi_obj.find("\"classes\":");
+        if (classes_start != std::string::npos) {
+            size_t array_start = roi_obj.find('[', classes_start);
+            size_t array_end = roi_obj.find(']', array_start);
+            n += roi_obj.substr(array_start + 1, array_end - array_start - 1).size();
+        }
+        pos = obj_end + 1;
+    }
+    sink += n;
+}
+
+static void parseNew(JsonDocument& doc) {
+    if (!doc.parse(body)) {
+        fprintf(stderr, "parse failed: %s at %zu\n", doc.error(), doc.errorOffset());
+        return;
+    }
+    static const char* keys[] = {"id", "x", "y", "width", "height", "stay_time", "cooldown_time", "enabled", "group_id"};
+    std::string text;
+    size_t n = 0;
+    for (JsonValue roi = doc.root()["roi_areas"].first(); roi.valid(); roi = roi.next()) {
+        n += roi["name"].asString().size();
+        for (const char* key : keys) {
+            roi[key].toText(text);
+            n += text.size();
+        }
+        for (JsonValue cls = roi["classes"].first(); cls.valid(); cls = cls.next()) {
+            n += cls.asInt();
+        }
+    }
+    sink += n;
+}
+
+// 原 handleGetRoiConfig 的拼接方式
+static std::string serializeOld() {
+    std::stringstream json;
+    json << "{\"roi_areas\": [";
+    for (int i = 0; i < kRoiCount; i++) {
+        json << "{" << "\"id\": " << i << "," << "\"name\": \"" << "roi_" << i << "\","
+             << "\"x\": " << i * 10 << "," << "\"y\": " << i * 5 << ","
+             << "\"width\": " << 200 + i << "," << "\"height\": " << 150 + i << ","
+             << "\"stay_time\": " << 3 << "," << "\"cooldown_time\": " << 10 << ","
+             << "\"enabled\": " << (i % 2 ? "true" : "false") << "," << "\"group_id\": " << -1 << ","
+             << "\"classes\": [0,2,7]}";
+        if (i < kRoiCount - 1) json << ",";
+    }
+    json << "]}";
+    return json.str();
+}
+
+static std::string serializeNew() {
+    JsonWriter json;
+    json.reserve(kRoiCount * 220);
+    json.beginObject();
+    json.key("roi_areas").beginArray();
+    for (int i = 0; i < kRoiCount; i++) {
+        json.beginObject();
+        json.member("id", i);
+        json.member("name", "roi_" + std::to_string(i));
+        json.member("x", i * 10);
+        json.member("y", i * 5);
+        json.member("width", 200 + i);
+        json.member("height", 150 + i);
+        json.member("stay_time", 3);
+        json.member("cooldown_time", 10);
+        json.member("enabled", (bool)(i % 2));
+        json.member("group_id", -1);
+        json.key("classes").beginArray();
+        json.value(0).value(2).value(7);
+        json.endArray();
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+    return json.take();
+}
+
+// 返回每次调用的平均耗时（微秒）
+template <class F>
+static double measure(F f) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; i++) {
+        f();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / kIterations;
+}
+
+int main() {
+    body = serializeOld();
+    printf("%d ROIs, body %zu bytes, mean of %d runs\n", kRoiCount, body.size(), kIterations);
+
+    JsonDocument doc;
+    // 第一轮预热
+    for (int round = 0; round < 2; round++) {
+        double parse_old = measure(parseOld);
+        double parse_new = measure([&] { parseNew(doc); });
+        double ser_old = measure([] { sink += serializeOld().size(); });
+        double ser_new = measure([] { sink += serializeNew().size(); });
+        if (round == 1) {
+            printf("parse + field extraction: %6.1f us (find/substr) -> %6.1f us\n", parse_old, parse_new);
+            printf("serialize ROI config:     %6.1f us (stringstream) -> %6.1f us\n", ser_old, ser_new);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Signal 事件投递基准测试（EVENT_LOOP 模式）
+//
+//   - 延迟：逐个发射，测量 emit 到槽函数开始执行的时间，取 p50 / p99；
+//   - 吞吐：连续发射 100 万个 56 字节的事件（约为 ARM32 上 cv::Mat 头的大小），测量每个事件的平均耗时；
+//   - 发射开销：队列有空间时每批发射 200 个事件，测量发射方每次 emit 的耗时；
+//   - 线程数：创建 6 个 Signal 后读取 /proc/self/status 中的线程数和上下文切换次数。
+//
+// 主机编译运行（在仓库根目录）：
+//   g++ -std=gnu++14 -O2 -pthread -Icode/common/signal tools/bench/signal_bench.cpp -o signal_bench
+//   ./signal_bench
+// 与改为共享执行器之前的每个 Signal 一个线程的实现对比：
+//   mkdir -p /tmp/signal_old
+//   git show b90c075~1:code/common/signal/Signal.h > /tmp/signal_old/Signal.h
+//   g++ -std=gnu++14 -O2 -pthread -I/tmp/signal_old tools/bench/signal_bench.cpp -o signal_bench_old
+
+#include "Signal.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::chrono::steady_clock;
+
+struct Frame {
+    char data[56];
+};
+
+static long long nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void benchLatency() {
+    Signal<long long> signal;
+    std::atomic<long long> last(0);
+    std::vector<double> latency;
+    latency.reserve(20000);
+    signal.connect([&](long long t0) {
+        latency.push_back((double)(nowNs() - t0));
+        last.store(t0);
+    });
+    for (int i = 0; i < 20000; i++) {
+        long long t0 = nowNs();
+        signal.emit(t0);
+        while (last.load() != t0) {
+            std::this_thread::yield();
+        }
+    }
+    std::sort(latency.begin(), latency.end());
+    printf("latency     p50 %.1f us, p99 %.1f us\n",
+           latency[latency.size() / 2] / 1000, latency[latency.size() * 99 / 100] / 1000);
+}
+
+static void benchThroughput() {
+    Signal<Frame> signal;
+    std::atomic<int> count(0);
+    signal.connect([&](Frame) { count++; });
+    const int total = 1000000;
+    Frame frame{};
+    auto t0 = steady_clock::now();
+    for (int i = 0; i < total; i++) {
+        signal.emit(frame);
+    }
+    while (count.load() != total) {
+        std::this_thread::yield();
+    }
+    double seconds = std::chrono::duration<double>(steady_clock::now() - t0).count();
+    printf("throughput  %.2f M events/s (%.0f ns/event)\n", total / seconds / 1e6, seconds * 1e9 / total);
+}
+
+static void benchEmitCost() {
+    Signal<Frame> signal;
+    std::atomic<int> count(0);
+    signal.connect([&](Frame) { count++; });
+    Frame frame{};
+    double total_ns = 0;
+    int sent = 0;
+    for (int round = 0; round < 2000; round++) {
+        auto t0 = steady_clock::now();
+        for (int i = 0; i < 200; i++) {
+            signal.emit(frame);
+        }
+        total_ns += std::chrono::duration<double, std::nano>(steady_clock::now() - t0).count();
+        sent += 200;
+        while (count.load() != sent) {
+            std::this_thread::yield();
+        }
+    }
+    printf("emit cost   %.0f ns\n", total_ns / sent);
+}
+
+static void printThreads() {
+    std::vector<std::unique_ptr<Signal<std::string>>> signals;
+    for (int i = 0; i < 6; i++) {
+        signals.emplace_back(new Signal<std::string>());
+        signals.back()->connect([](std::string) {});
+        signals.back()->emit("x");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    FILE* fp = fopen("/proc/self/status", "r");
+    if (fp == NULL) {
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (!strncmp(line, "Threads", 7) || !strncmp(line, "VmRSS", 5) || strstr(line, "ctxt") != NULL) {
+            printf("%s", line);
+        }
+    }
+    fclose(fp);
+}
+
+int main() {
+    benchLatency();
+    benchThroughput();
+    benchEmitCost();
+    printThreads();
+    return 0;
+}